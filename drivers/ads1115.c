@@ -13,28 +13,19 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <fcntl.h>
 #include <errno.h>
-#include <sys/ioctl.h>
-#include <linux/types.h>
-#include <linux/i2c-dev.h>
 #include <signal.h>
 #include "ads1115.h"
 
 int ads1115_init(ads1115 *dev, uint8_t s_address)
 {
-    dev->fd = open(dev->fname, O_RDWR);
-    if (dev->fd < 0)
+    dev->bus = i2c_bus_open(dev->fname);
+    if (dev->bus == NULL)
     {
-        perror("[ERROR] Could not create a file descriptor.");
-        return -1;
-    }
-
-    if (ioctl(dev->fd, I2C_SLAVE, s_address) < 0)
-    {
-        perror("[ERROR] Could not assign device.");
+        perror("[ERROR] Could not open the I2C bus.");
         return -1;
     }
+    dev->addr = s_address;
 
     return 1;
 }
@@ -46,7 +37,7 @@ int ads1115_configure(ads1115 *dev, ads1115_config m_con)
     buf[1] = m_con.raw >> 8;
     buf[2] = m_con.raw & 0xFF;
 
-    if (write(dev->fd, buf, 3) < 3)
+    if (i2c_bus_send(dev->bus, dev->addr, buf, 3) < 0)
     {
         perror("[ERROR] Could not configure device.");
         return -1;
@@ -72,18 +63,13 @@ int ads1115_read_data(ads1115 *dev, int16_t *data)
         buf[1] = m_con.raw >> 8;
         buf[2] = m_con.raw & 0xFF;
 
-        if (write(dev->fd, buf, 3) < 3)
+        if (i2c_bus_send(dev->bus, dev->addr, buf, 3) < 0)
         {
             perror("[ERROR] Could not access target register.");
             return -1;
         }
 
-        if (write(dev->fd, buf, 1) < 1)
-        {
-            perror("Could not stat read");
-        }
-
-        if (read(dev->fd, &buf[1], 2) < 2)
+        if (i2c_bus_read(dev->bus, dev->addr, buf[0], &buf[1], 2) < 0)
         {
             perror("Could not stat read command");
         }
@@ -95,12 +81,7 @@ int ads1115_read_data(ads1115 *dev, int16_t *data)
     do
     {
         buf[0] = CONFIG_REG;
-        if (write(dev->fd, buf, 1) < 1)
-        {
-            perror("Could not stat read");
-        }
-
-        if (read(dev->fd, &buf[1], 2) < 2)
+        if (i2c_bus_read(dev->bus, dev->addr, buf[0], &buf[1], 2) < 0)
         {
             perror("Could not stat read command");
         }
@@ -118,13 +99,7 @@ int ads1115_read_data(ads1115 *dev, int16_t *data)
         buf[0] = CONVERSION_REG;
         buf[1] = 0x00;
         buf[2] = 0x00;
-        if (write(dev->fd, buf, 1) < 1)
-        {
-            perror("Could not stat read");
-            status = 0;
-        }
-
-        if (read(dev->fd, &buf[1], 2) < 2)
+        if (i2c_bus_read(dev->bus, dev->addr, buf[0], &buf[1], 2) < 0)
         {
             perror("Could not stat read command");
             status = 0;
@@ -135,7 +110,7 @@ int ads1115_read_data(ads1115 *dev, int16_t *data)
         buf[1] = m_con.raw >> 8;
 
         buf[2] = m_con.raw & 0xff;
-        if (write(dev->fd, buf, 3) < 3)
+        if (i2c_bus_send(dev->bus, dev->addr, buf, 3) < 0)
         {
             perror("Could not stat mux change");
             status = 0;
@@ -160,7 +135,7 @@ int ads1115_read_cont(ads1115 *dev, int16_t *data)
     buf[1] = m_con.raw >> 8;
     buf[2] = m_con.raw & 0xFF;
 
-    if (write(dev->fd, buf, 3) < 3)
+    if (i2c_bus_send(dev->bus, dev->addr, buf, 3) < 0)
     {
         perror("[ERROR] Could not access target register.");
         return -1;
@@ -177,13 +152,7 @@ int ads1115_read_cont(ads1115 *dev, int16_t *data)
         buf[0] = CONVERSION_REG;
         buf[1] = 0x00;
         buf[2] = 0x00;
-        if (write(dev->fd, buf, 1) < 1)
-        {
-            perror("Could not stat read");
-            status = 0;
-        }
-
-        if (read(dev->fd, &buf[1], 2) < 2)
+        if (i2c_bus_read(dev->bus, dev->addr, buf[0], &buf[1], 2) < 0)
         {
             perror("Could not stat read command");
             status = 0;
@@ -194,7 +163,7 @@ int ads1115_read_cont(ads1115 *dev, int16_t *data)
         buf[1] = m_con.raw >> 8;
 
         buf[2] = m_con.raw & 0xff;
-        if (write(dev->fd, buf, 3) < 3)
+        if (i2c_bus_send(dev->bus, dev->addr, buf, 3) < 0)
         {
             perror("Could not stat mux change");
             status = 0;
@@ -212,13 +181,7 @@ int ads1115_read_config(ads1115 *dev, uint16_t *data)
     buf[1] = 0;
     buf[2] = 0;
 
-    if (write(dev->fd, buf, 1) < 1)
-    {
-        perror("[ERROR] Could not select config register.");
-        return -1;
-    }
-
-    if (read(dev->fd, &buf[1], 2) < 2)
+    if (i2c_bus_read(dev->bus, dev->addr, buf[0], &buf[1], 2) < 0)
     {
         perror("[ERROR] Could not read config register.");
         return -1;
@@ -229,6 +192,6 @@ int ads1115_read_config(ads1115 *dev, uint16_t *data)
 
 void ads1115_destroy(ads1115 *dev)
 {
-    close(dev->fd);
+    i2c_bus_close(dev->bus);
     free(dev);
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
 #ifndef ADS1115_H
 #define ADS1115_H
 #include <stdint.h>
+#include "i2c_bus.h"
 /**
  * @brief Default I2C Address
  * 
@@ -165,11 +166,12 @@ typedef union {
  */
 typedef struct
 {
-    int fd;         ///< Device file descriptor
+    i2c_bus *bus;   ///< I2C bus, shared with the other devices on it
+    uint8_t addr;   ///< Device address
     char fname[40]; ///< I2C Bus name
 } ads1115;
 /**
- * @brief Initializes an ADS1115 device. Opens the I2C device named in ads1115->fname.
+ * @brief Initializes an ADS1115 device. Opens (or shares) the I2C bus named in ads1115->fname.
  * 
  * @param dev Pointer to ads1115 device struct.
  * @param s_address 7-bit I2C address
@@ -0,0 +1,100 @@
+/**
+ * @file gpio_event.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Function definitions for the GPIO edge event driver (gpiochip character device, Linux)
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include "gpio_event.h"
+
+/**
+ * @brief Requests edge events of a line of the GPIO chip dev->fname, the line is
+ * configured as an input.
+ * 
+ * @param dev 
+ * @param line Line offset on the chip
+ * @param edges Edges to report, GPIO_EVENT_RISING, GPIO_EVENT_FALLING or GPIO_EVENT_BOTH
+ * @return 1 on success, -1 on failure
+ */
+int gpio_event_init(gpio_event *dev, uint32_t line, uint32_t edges)
+{
+    dev->fd = -1;
+    dev->line = line;
+    dev->last = 0;
+    int chip = open(dev->fname, O_RDONLY);
+    if (chip < 0)
+    {
+        perror("[ERROR] GPIO Could not open the chip");
+        return -1;
+    }
+    struct gpioevent_request req;
+    memset(&req, 0, sizeof(req));
+    req.lineoffset = line;
+    req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+    req.eventflags = edges;
+    snprintf(req.consumer_label, sizeof(req.consumer_label), "shflight");
+    int status = ioctl(chip, GPIO_GET_LINEEVENT_IOCTL, &req);
+    close(chip); // the request holds the line
+    if (status < 0)
+    {
+        perror("[ERROR] GPIO Could not request the line events");
+        return -1;
+    }
+    dev->fd = req.fd;
+    return 1;
+}
+/**
+ * @brief Waits for an edge of the line, and takes all edges queued.
+ * 
+ * @param dev 
+ * @param timeout Maximum wait in msec, 0 returns immediately, negative waits indefinitely
+ * @return Number of edges taken, 0 on timeout, -1 on failure
+ */
+int gpio_event_wait(gpio_event *dev, int timeout)
+{
+    struct pollfd pfd = {.fd = dev->fd, .events = POLLIN | POLLPRI};
+    int n = 0;
+    while (1)
+    {
+        int status = poll(&pfd, 1, n ? 0 : timeout); // after the first edge, only take what is queued
+        if (status < 0 && errno == EINTR)
+            continue;
+        if (status < 0)
+        {
+            perror(__FUNCTION__);
+            return -1;
+        }
+        if (status == 0)
+            return n;
+        struct gpioevent_data ev;
+        if (read(dev->fd, &ev, sizeof(ev)) != sizeof(ev))
+        {
+            perror(__FUNCTION__);
+            return n ? n : -1;
+        }
+        dev->last = ev.timestamp;
+        n++;
+    }
+}
+/**
+ * @brief Releases the line.
+ * 
+ * @param dev 
+ */
+void gpio_event_destroy(gpio_event *dev)
+{
+    if (dev->fd >= 0)
+        close(dev->fd);
+    dev->fd = -1;
+}
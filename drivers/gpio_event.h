@@ -0,0 +1,37 @@
+/**
+ * @file gpio_event.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Function prototypes and struct declarations for the GPIO edge event driver
+ * (gpiochip character device, Linux)
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#ifndef GPIO_EVENT_H
+#define GPIO_EVENT_H
+#include <stdint.h>
+#include <linux/gpio.h>
+
+#define GPIO_EVENT_RISING GPIOEVENT_REQUEST_RISING_EDGE   ///< Report rising edges
+#define GPIO_EVENT_FALLING GPIOEVENT_REQUEST_FALLING_EDGE ///< Report falling edges (active low interrupt outputs)
+#define GPIO_EVENT_BOTH GPIOEVENT_REQUEST_BOTH_EDGES      ///< Report both edges
+
+/**
+ * @brief GPIO edge event device handle. The kernel timestamps and queues the edges of the
+ * line, none are lost while nobody waits for them.
+ * 
+ */
+typedef struct
+{
+    int fd;         ///< File descriptor of the line event request
+    char fname[40]; ///< GPIO chip device file name, e.g. "/dev/gpiochip0"
+    uint32_t line;  ///< Line offset on the chip
+    uint64_t last;  ///< Kernel timestamp of the last edge received, in nsec
+} gpio_event;
+
+int gpio_event_init(gpio_event *dev, uint32_t line, uint32_t edges);
+int gpio_event_wait(gpio_event *dev, int timeout);
+void gpio_event_destroy(gpio_event *dev);
+#endif // GPIO_EVENT_H
@@ -0,0 +1,268 @@
+/**
+ * @file i2c_bus.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Shared I2C transaction layer.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+#include "i2c_bus.h"
+
+static i2c_bus buses[I2C_BUS_MAX];                           // open buses, refs == 0 marks a free slot
+static pthread_mutex_t buses_lock = PTHREAD_MUTEX_INITIALIZER; // protects the table
+static __thread int i2c_prio = I2C_PRIO_SENSOR;                // priority of the calling thread
+
+/**
+ * @brief Current CLOCK_MONOTONIC time, in usec.
+ *
+ */
+static inline uint64_t i2c_bus_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+i2c_bus *i2c_bus_open(const char *fname)
+{
+    i2c_bus *bus = NULL;
+    pthread_mutex_lock(&buses_lock);
+    for (int i = 0; i < I2C_BUS_MAX; i++)
+    {
+        if (buses[i].refs > 0 && strncmp(buses[i].fname, fname, sizeof(buses[i].fname)) == 0)
+        {
+            bus = &buses[i];
+            bus->refs++;
+            pthread_mutex_unlock(&buses_lock);
+            return bus;
+        }
+        if (bus == NULL && buses[i].refs == 0)
+            bus = &buses[i];
+    }
+    if (bus == NULL)
+    {
+        fprintf(stderr, "[I2C] Too many buses open, %s not opened\n", fname);
+        pthread_mutex_unlock(&buses_lock);
+        return NULL;
+    }
+    bus->fd = open(fname, O_RDWR);
+    if (bus->fd < 0)
+    {
+        perror("[I2C] Could not open bus");
+        pthread_mutex_unlock(&buses_lock);
+        return NULL;
+    }
+    unsigned long funcs = 0;
+    bus->rdwr = ioctl(bus->fd, I2C_FUNCS, &funcs) >= 0 && (funcs & I2C_FUNC_I2C);
+    if (!bus->rdwr)
+        fprintf(stderr, "[I2C] %s does not take combined transactions, one message per system call\n", fname);
+    bus->slave = -1;
+    bus->split = 0; // found out by the first transfer that reads before the last message
+    pthread_mutex_init(&bus->lock, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC); // timed waits run to the end of the quiet window, see i2c_bus_now()
+    for (int i = 0; i < I2C_PRIO_COUNT; i++)
+    {
+        pthread_cond_init(&bus->ready[i], &attr);
+        bus->waiting[i] = 0;
+    }
+    pthread_condattr_destroy(&attr);
+    bus->depth = 0;
+    bus->quiet_start = bus->quiet_end = 0;
+    snprintf(bus->fname, sizeof(bus->fname), "%s", fname);
+    bus->refs = 1;
+    pthread_mutex_unlock(&buses_lock);
+    return bus;
+}
+
+void i2c_bus_close(i2c_bus *bus)
+{
+    if (bus == NULL)
+        return;
+    pthread_mutex_lock(&buses_lock);
+    if (bus->refs > 0 && --bus->refs == 0)
+    {
+        close(bus->fd);
+        pthread_mutex_destroy(&bus->lock);
+        for (int i = 0; i < I2C_PRIO_COUNT; i++)
+            pthread_cond_destroy(&bus->ready[i]);
+    }
+    pthread_mutex_unlock(&buses_lock);
+}
+
+void i2c_bus_priority(int prio)
+{
+    if (prio >= 0 && prio < I2C_PRIO_COUNT)
+        i2c_prio = prio;
+}
+
+int i2c_bus_acquire(i2c_bus *bus, uint64_t span)
+{
+    return i2c_bus_acquire_prio(bus, span, i2c_prio);
+}
+
+int i2c_bus_acquire_prio(i2c_bus *bus, uint64_t span, int prio)
+{
+    if (bus == NULL || prio < 0 || prio >= I2C_PRIO_COUNT)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    pthread_t self = pthread_self();
+    pthread_mutex_lock(&bus->lock);
+    if (bus->depth > 0 && pthread_equal(bus->owner, self)) // nested
+    {
+        bus->depth++;
+        pthread_mutex_unlock(&bus->lock);
+        return 1;
+    }
+    bus->waiting[prio]++;
+    while (1)
+    {
+        int busy = bus->depth > 0;
+        for (int i = 0; i < prio && !busy; i++) // served after all waiting threads of higher priority
+            busy = bus->waiting[i] > 0;
+        uint64_t now = 0;
+        if (!busy && prio == I2C_PRIO_HOUSEKEEPING && bus->quiet_end > (now = i2c_bus_now()) && now + span > bus->quiet_start)
+        {
+            // the exchange would overlap the quiet window, wait for its end
+            struct timespec ts = {.tv_sec = bus->quiet_end / 1000000, .tv_nsec = (bus->quiet_end % 1000000) * 1000};
+            pthread_cond_timedwait(&bus->ready[prio], &bus->lock, &ts);
+            continue;
+        }
+        if (!busy)
+            break;
+        pthread_cond_wait(&bus->ready[prio], &bus->lock);
+    }
+    bus->waiting[prio]--;
+    bus->owner = self;
+    bus->depth = 1;
+    pthread_mutex_unlock(&bus->lock);
+    return 1;
+}
+
+void i2c_bus_release(i2c_bus *bus)
+{
+    if (bus == NULL)
+        return;
+    pthread_mutex_lock(&bus->lock);
+    if (bus->depth > 0 && --bus->depth == 0)
+    {
+        for (int i = 0; i < I2C_PRIO_COUNT; i++) // hand the bus to the highest priority waiting
+        {
+            if (bus->waiting[i] > 0)
+            {
+                pthread_cond_signal(&bus->ready[i]);
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&bus->lock);
+}
+
+void i2c_bus_quiet(i2c_bus *bus, uint64_t start, uint64_t end)
+{
+    if (bus == NULL)
+        return;
+    pthread_mutex_lock(&bus->lock);
+    bus->quiet_start = start;
+    bus->quiet_end = end;
+    pthread_cond_broadcast(&bus->ready[I2C_PRIO_HOUSEKEEPING]); // re-check the waits against the new window
+    pthread_mutex_unlock(&bus->lock);
+}
+
+int i2c_bus_transfer(i2c_bus *bus, struct i2c_msg *msgs, int n)
+{
+    if (bus == NULL || n < 1 || n > I2C_RDWR_IOCTL_MAX_MSGS)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (i2c_bus_acquire(bus, 0) < 0)
+        return -1;
+    int status = 1;
+    if (bus->rdwr)
+    {
+        for (int i = 0, start = 0; i < n && status > 0; i++)
+        {
+            if (i < n - 1 && !(bus->split && (msgs[i].flags & I2C_M_RD))) // the transaction goes on
+                continue;
+            struct i2c_rdwr_ioctl_data data = {.msgs = msgs + start, .nmsgs = i + 1 - start};
+            int ret = ioctl(bus->fd, I2C_RDWR, &data);
+            if (ret < 0 && errno == EOPNOTSUPP && !bus->split) // nothing executed yet, start over split after each read
+            {
+                fprintf(stderr, "[I2C] %s takes a read only as the last message, one transaction per read\n", bus->fname);
+                bus->split = 1;
+                i = -1;
+                continue;
+            }
+            status = ret == i + 1 - start ? 1 : -1;
+            start = i + 1;
+        }
+        i2c_bus_release(bus);
+        return status;
+    }
+    for (int i = 0; i < n && status > 0; i++) // the selected address is state of the file descriptor, kept by the owner
+    {
+        if (bus->slave != msgs[i].addr)
+        {
+            if (ioctl(bus->fd, I2C_SLAVE, msgs[i].addr) < 0)
+            {
+                status = -1;
+                break;
+            }
+            bus->slave = msgs[i].addr;
+        }
+        ssize_t len = (msgs[i].flags & I2C_M_RD) ? read(bus->fd, msgs[i].buf, msgs[i].len) : write(bus->fd, msgs[i].buf, msgs[i].len);
+        if (len < msgs[i].len)
+            status = -1;
+    }
+    i2c_bus_release(bus);
+    return status;
+}
+
+int i2c_bus_read(i2c_bus *bus, uint8_t addr, uint8_t reg, void *buf, size_t len)
+{
+    struct i2c_msg msgs[2] = {
+        {.addr = addr, .flags = 0, .len = 1, .buf = &reg},
+        {.addr = addr, .flags = I2C_M_RD, .len = len, .buf = (uint8_t *)buf},
+    };
+    return i2c_bus_transfer(bus, msgs, 2);
+}
+
+int i2c_bus_write(i2c_bus *bus, uint8_t addr, uint8_t reg, const void *buf, size_t len)
+{
+    if (len > I2C_BUS_MAX_WRITE)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    uint8_t data[I2C_BUS_MAX_WRITE + 1];
+    data[0] = reg;
+    memcpy(data + 1, buf, len);
+    struct i2c_msg msg = {.addr = addr, .flags = 0, .len = len + 1, .buf = data};
+    return i2c_bus_transfer(bus, &msg, 1);
+}
+
+int i2c_bus_send(i2c_bus *bus, uint8_t addr, const void *buf, size_t len)
+{
+    struct i2c_msg msg = {.addr = addr, .flags = 0, .len = len, .buf = (uint8_t *)buf};
+    return i2c_bus_transfer(bus, &msg, 1);
+}
+
+int i2c_bus_recv(i2c_bus *bus, uint8_t addr, void *buf, size_t len)
+{
+    struct i2c_msg msg = {.addr = addr, .flags = I2C_M_RD, .len = len, .buf = (uint8_t *)buf};
+    return i2c_bus_transfer(bus, &msg, 1);
+}
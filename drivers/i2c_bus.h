@@ -0,0 +1,208 @@
+/**
+ * @file i2c_bus.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Shared I2C transaction layer. One file descriptor per bus, shared by all devices
+ * on the bus; every transaction is one I2C_RDWR ioctl, register reads use a repeated start
+ * between the register address and the data. Threads sharing a bus are arbitrated by
+ * priority, and low priority traffic is held back from the quiet windows of the ACS.
+ *
+ * Several messages can go out as one transaction (e.g. both channels of a TSL2561).
+ * Adapters that take a read only as the last message (i2c-bcm2835 of the Raspberry Pi)
+ * get one transaction up to each read, adapters without I2C_FUNC_I2C one read() or write()
+ * per message after I2C_SLAVE. The ACS thread goes first, so that a magnetometer read waits
+ * for at most the transaction in progress, then the sun sensor acquisition, then the EPS.
+ * The ACS marks the measurement window of its next cycle with i2c_bus_quiet(); an EPS
+ * command is only sent if the command, the reply wait and the reply (EPS_EXCHANGE_TIME())
+ * fit outside of it, and the bus is free for other devices during the reply wait.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <linux/i2c.h>
+
+/**
+ * @brief Maximum number of buses open at the same time.
+ *
+ */
+#ifndef I2C_BUS_MAX
+#define I2C_BUS_MAX 4
+#endif
+
+/**
+ * @brief Maximum number of data bytes of i2c_bus_write().
+ *
+ */
+#define I2C_BUS_MAX_WRITE 32
+
+/**
+ * @brief Priorities of the bus traffic, highest first. Set per thread with i2c_bus_priority(),
+ * or per exchange with i2c_bus_acquire_prio().
+ *
+ */
+typedef enum
+{
+    I2C_PRIO_ACS,          ///< Magnetometer and gyroscope reads of the ACS, never held back
+    I2C_PRIO_SENSOR,       ///< Sun sensors and other periodic sensor reads (default)
+    I2C_PRIO_HOUSEKEEPING, ///< EPS and other housekeeping, held back from the quiet windows
+    I2C_PRIO_COUNT         ///< Number of priorities
+} I2C_PRIO;
+
+/**
+ * @brief I2C bus handle, shared by all devices on the bus. The bus is owned by one thread
+ * at a time; a thread that waits for it is served before all waiting threads of lower
+ * priority, so that a thread waits for at most the transaction in progress and the waiting
+ * threads of higher priority.
+ *
+ */
+typedef struct
+{
+    int fd;                               ///< File descriptor of the bus
+    char fname[40];                       ///< Bus device file name
+    int refs;                             ///< Number of devices holding the bus
+    int rdwr;                             ///< 1 if the adapter takes combined transactions (I2C_RDWR)
+    int slave;                            ///< Address selected with I2C_SLAVE, without I2C_RDWR (-1: none)
+    int split;                            ///< 1 if the adapter takes a read only as the last message of a transaction
+    pthread_mutex_t lock;                 ///< Protects the arbitration state below
+    pthread_cond_t ready[I2C_PRIO_COUNT]; ///< Signaled when the bus is released, per priority
+    int waiting[I2C_PRIO_COUNT];          ///< Number of threads waiting for the bus, per priority
+    pthread_t owner;                      ///< Thread owning the bus, valid while depth > 0
+    int depth;                            ///< Number of nested i2c_bus_acquire() of the owner
+    uint64_t quiet_start;                 ///< Start of the quiet window, CLOCK_MONOTONIC usec
+    uint64_t quiet_end;                   ///< End of the quiet window, CLOCK_MONOTONIC usec
+} i2c_bus;
+
+/**
+ * @brief Opens a bus, or takes another reference to it if it is already open.
+ *
+ * @param fname Bus device file name, e.g. "/dev/i2c-1"
+ * @return i2c_bus* Bus handle, NULL on failure
+ */
+i2c_bus *i2c_bus_open(const char *fname);
+
+/**
+ * @brief Releases a reference to the bus, the file descriptor is closed with the last one.
+ *
+ * @param bus Bus handle, NULL is ignored
+ */
+void i2c_bus_close(i2c_bus *bus);
+
+/**
+ * @brief Sets the priority of the bus traffic of the calling thread, on all buses.
+ * Threads start with I2C_PRIO_SENSOR.
+ *
+ * @param prio One of I2C_PRIO
+ */
+void i2c_bus_priority(int prio);
+
+/**
+ * @brief Waits until the calling thread owns the bus, in order of priority. Transactions
+ * of the owner run without arbitration until the matching i2c_bus_release(), which keeps
+ * a sequence of transactions together. Nested calls are counted.
+ * Housekeeping traffic is also held back until the exchange of span usec starting now
+ * ends before, or starts after, the quiet window (see i2c_bus_quiet()).
+ *
+ * @param bus Bus handle
+ * @param span Time the exchange that starts now needs the device, in usec, including
+ * waits with the bus released (e.g. for a reply)
+ * @return int 1 on success, -1 on failure
+ */
+int i2c_bus_acquire(i2c_bus *bus, uint64_t span);
+
+/**
+ * @brief i2c_bus_acquire() with the priority of the exchange instead of the priority of
+ * the calling thread, for traffic of a fixed class (e.g. EPS housekeeping) from any thread.
+ *
+ * @param bus Bus handle
+ * @param span Time the exchange that starts now needs the device, in usec
+ * @param prio One of I2C_PRIO
+ * @return int 1 on success, -1 on failure
+ */
+int i2c_bus_acquire_prio(i2c_bus *bus, uint64_t span, int prio);
+
+/**
+ * @brief Releases the bus acquired with i2c_bus_acquire(), and hands it to the waiting
+ * thread of the highest priority.
+ *
+ * @param bus Bus handle
+ */
+void i2c_bus_release(i2c_bus *bus);
+
+/**
+ * @brief Sets the quiet window of the bus, the time the ACS measures in. No housekeeping
+ * exchange starts if it would overlap the window. Replaces the previous window.
+ *
+ * @param bus Bus handle
+ * @param start Start of the window, CLOCK_MONOTONIC usec (see sh_time_usec())
+ * @param end End of the window, CLOCK_MONOTONIC usec
+ */
+void i2c_bus_quiet(i2c_bus *bus, uint64_t start, uint64_t end);
+
+/**
+ * @brief Executes the messages as one combined transaction: a repeated start between the
+ * messages and one stop at the end, in a single system call. Adapters that take a read
+ * only as the last message (e.g. i2c-bcm2835 of the Raspberry Pi) execute one transaction
+ * up to each read, adapters without I2C_RDWR one message per system call. Waits for the bus in order of priority, unless the
+ * calling thread owns it (see i2c_bus_acquire()).
+ *
+ * @param bus Bus handle
+ * @param msgs Messages (address, flags, length, buffer), see linux/i2c.h
+ * @param n Number of messages, at most I2C_RDWR_IOCTL_MAX_MSGS
+ * @return int 1 on success, -1 on failure
+ */
+int i2c_bus_transfer(i2c_bus *bus, struct i2c_msg *msgs, int n);
+
+/**
+ * @brief Reads len bytes starting at register reg of the device: register address
+ * write, repeated start and read.
+ *
+ * @param bus Bus handle
+ * @param addr 7 bit device address
+ * @param reg Register address (with the auto increment bit where the device needs one)
+ * @param buf Buffer of len bytes
+ * @param len Number of bytes to read
+ * @return int 1 on success, -1 on failure
+ */
+int i2c_bus_read(i2c_bus *bus, uint8_t addr, uint8_t reg, void *buf, size_t len);
+
+/**
+ * @brief Writes len bytes starting at register reg of the device, in one message.
+ *
+ * @param bus Bus handle
+ * @param addr 7 bit device address
+ * @param reg Register address
+ * @param buf Data, at most I2C_BUS_MAX_WRITE bytes
+ * @param len Number of bytes to write
+ * @return int 1 on success, -1 on failure
+ */
+int i2c_bus_write(i2c_bus *bus, uint8_t addr, uint8_t reg, const void *buf, size_t len);
+
+/**
+ * @brief Writes raw bytes to the device, without a register address.
+ *
+ * @param bus Bus handle
+ * @param addr 7 bit device address
+ * @param buf Data
+ * @param len Number of bytes to write
+ * @return int 1 on success, -1 on failure
+ */
+int i2c_bus_send(i2c_bus *bus, uint8_t addr, const void *buf, size_t len);
+
+/**
+ * @brief Reads raw bytes from the device, without a register address.
+ *
+ * @param bus Bus handle
+ * @param addr 7 bit device address
+ * @param buf Buffer of len bytes
+ * @param len Number of bytes to read
+ * @return int 1 on success, -1 on failure
+ */
+int i2c_bus_recv(i2c_bus *bus, uint8_t addr, void *buf, size_t len);
+#endif // I2C_BUS_H
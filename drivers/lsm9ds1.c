@@ -1,7 +1,7 @@
 /**
  * @file lsm9ds1.c
  * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
- * @brief Function definitions for LSM9DS1 Magnetometer I2C driver.
+ * @brief Function definitions for LSM9DS1 Magnetometer and Gyroscope I2C driver.
  * @version 0.1
  * @date 2020-03-19
  * 
@@ -10,14 +10,9 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
-#include <fcntl.h>
-#include <linux/i2c-dev.h>
 #include <errno.h>
 #include <stdint.h>
-#include <sys/stat.h>
-#include <unistd.h>
 #include <string.h>
-#include <sys/ioctl.h>
 #include "lsm9ds1.h"
 /**
  * @brief Takes the pointer to the device struct, XL address and M address,
@@ -30,39 +25,22 @@
  */
 int lsm9ds1_init(lsm9ds1 *dev, uint8_t xl_addr, uint8_t mag_addr)
 {
-    uint8_t accel_stat = 1;
-    dev->accel_file = open(dev->fname, O_RDWR);
-    if (dev->mag_file < 0)
+    dev->gyro = 0;
+    dev->fifo = 0;
+    // accel + gyro and mag share one bus handle
+    dev->bus = i2c_bus_open(dev->fname);
+    if (dev->bus == NULL)
     {
-        accel_stat = 0;
-        perror("LSM9DS1: Could not open fd for mag");
-    }
-    dev->mag_file = open(dev->fname, O_RDWR);
-    if (dev->mag_file < 0)
-    {
-        perror("LSM9DS1: Could not open fd for mag");
-        return -1;
-    }
-    if (ioctl(dev->mag_file, I2C_SLAVE, mag_addr) < 0)
-    {
-        perror("LSM9DS1: MAG ioctl failed");
-        return -1;
-    }
-    if (ioctl(dev->accel_file, I2C_SLAVE, xl_addr) < 0)
-    {
-        perror("LSM9DS1: ACCEL ioctl failed");
+        perror("LSM9DS1: Could not open bus");
         return -1;
     }
+    dev->xl_addr = xl_addr;
+    dev->mag_addr = mag_addr;
     // Verify mag identity
-    uint8_t buf = MAG_WHO_AM_I;
-    if (write(dev->mag_file, &buf, 1) < 1)
-    {
-        perror("LSM9DS1_INIT: Could not write to magnetic field descriptor.");
-        return -1;
-    }
-    if (read(dev->mag_file, &buf, 1) < 1)
+    uint8_t buf = 0;
+    if (i2c_bus_read(dev->bus, dev->mag_addr, MAG_WHO_AM_I, &buf, 1) < 0)
     {
-        perror("LSM9DS1_INIT: Could not write to magnetic field descriptor.");
+        perror("LSM9DS1_INIT: Could not read magnetometer identity.");
         return -1;
     }
     if (buf != MAG_IDENT)
@@ -70,18 +48,17 @@ int lsm9ds1_init(lsm9ds1 *dev, uint8_t xl_addr, uint8_t mag_addr)
         perror("LSM9DS1_INIT: Identity did not match");
         return -1;
     }
-    // disable accel+gyro
-    char obuf[2];
-    obuf[0] = LSM9DS1_CTRL_REG1_G;
-    obuf[1] = 0x00;
-    accel_stat = write(dev->accel_file, &obuf, 2);
-    obuf[0] = LSM9DS1_CTRL_REG5_XL;
-    accel_stat = write(dev->accel_file, &obuf, 2);
-    obuf[0] = LSM9DS1_CTRL_REG6_XL;
-    accel_stat = write(dev->accel_file, &obuf, 2);
-    if (accel_stat < 2)
-        perror("[LSM9DS1] Error configuring accelerometer + gyro");
-    // also configure magnetometer for SPACE HAUC use I2C_SLAVE
+    // power down the accelerometer, run the gyroscope alone
+    GYRO_CTRL gctrl;
+    gctrl.bandwidth = 0b00;
+    gctrl.reserved = 0;
+    gctrl.full_scale = 0b00; // 245 dps, LSM9DS1_GYRO_SCALE_245
+    gctrl.data_rate = 0b011; // 119 Hz, about 12 samples per ACS cycle queue in the FIFO
+    if (lsm9ds1_config_gyro(dev, gctrl) < 0)
+        fprintf(stderr, "[LSM9DS1] Gyroscope not available, angular speed from magnetometer only\n");
+    else if (lsm9ds1_config_fifo(dev, 1) < 0)
+        fprintf(stderr, "[LSM9DS1] Gyroscope FIFO not available, reading one sample per cycle\n");
+    // also configure magnetometer for SPACE HAUC use
     MAG_DATA_RATE drate;
     drate.data_rate = 0b101;
     drate.fast_odr = 0;
@@ -92,7 +69,8 @@ int lsm9ds1_init(lsm9ds1 *dev, uint8_t xl_addr, uint8_t mag_addr)
     rst.reboot = 0;
     rst.soft_rst = 0;
     MAG_DATA_READ dread;
-    dread.bdu = 0;
+    dread.reserved = 0;
+    dread.bdu = 1; // the burst read in lsm9ds1_read_mag() gets both bytes of the same sample
     dread.fast_read = 0;
     int mag_stat = lsm9ds1_config_mag(dev, drate, rst, dread);
 
@@ -110,38 +88,33 @@ int lsm9ds1_init(lsm9ds1 *dev, uint8_t xl_addr, uint8_t mag_addr)
 int lsm9ds1_config_mag(lsm9ds1 *dev, MAG_DATA_RATE datarate, MAG_RESET rst, MAG_DATA_READ dread)
 {
     int stat = 1;
-    uint8_t buf[2];
-    buf[0] = MAG_CTRL_REG1_M;
-    buf[1] = *((char *)&datarate);
-    if (write(dev->mag_file, &buf, 2) < 2)
+    uint8_t buf;
+    buf = *((char *)&datarate);
+    if (i2c_bus_write(dev->bus, dev->mag_addr, MAG_CTRL_REG1_M, &buf, 1) < 0)
     {
         perror("Data rate config failed.");
         stat = 0;
     }
-    buf[0] = MAG_CTRL_REG2_M;
-    buf[1] = *((char *)&rst);
-    if (write(dev->mag_file, &buf, 2) < 2)
+    buf = *((char *)&rst);
+    if (i2c_bus_write(dev->bus, dev->mag_addr, MAG_CTRL_REG2_M, &buf, 1) < 0)
     {
         perror("Reset config failed.");
         stat = 0;
     }
-    buf[0] = MAG_CTRL_REG3_M;
-    buf[1] = 0x00;
-    if (write(dev->mag_file, &buf, 2) < 2)
+    buf = 0x00;
+    if (i2c_bus_write(dev->bus, dev->mag_addr, MAG_CTRL_REG3_M, &buf, 1) < 0)
     {
         perror("Reg3 config failed.");
         stat = 0;
     }
-    buf[0] = MAG_CTRL_REG4_M;
-    buf[1] = MAG_CTRL_REG4_DATA;
-    if (write(dev->mag_file, &buf, 2) < 2)
+    buf = MAG_CTRL_REG4_DATA;
+    if (i2c_bus_write(dev->bus, dev->mag_addr, MAG_CTRL_REG4_M, &buf, 1) < 0)
     {
         perror("Reg4 config failed.");
         stat = 0;
     }
-    buf[0] = MAG_CTRL_REG5_M;
-    buf[1] = *((char *)&dread);
-    if (write(dev->mag_file, &buf, 2) < 2)
+    buf = *((char *)&dread);
+    if (i2c_bus_write(dev->bus, dev->mag_addr, MAG_CTRL_REG5_M, &buf, 1) < 0)
     {
         perror("Data read config failed.");
         stat = 0;
@@ -156,13 +129,11 @@ int lsm9ds1_config_mag(lsm9ds1 *dev, MAG_DATA_RATE datarate, MAG_RESET rst, MAG_
  */
 int lsm9ds1_reset_mag(lsm9ds1 *dev)
 {
-    uint8_t buf[2];
-    buf[0] = MAG_CTRL_REG2_M;
-    buf[1] = 0x00;
-    MAG_RESET rst = *((MAG_RESET *)&buf[1]);
+    uint8_t buf = 0x00;
+    MAG_RESET rst = *((MAG_RESET *)&buf);
     rst.reboot = 1;
-    buf[1] = *((uint8_t *)&rst);
-    if (write(dev->mag_file, &buf, 2) < 2)
+    buf = *((uint8_t *)&rst);
+    if (i2c_bus_write(dev->bus, dev->mag_addr, MAG_CTRL_REG2_M, &buf, 1) < 0)
     {
         perror("Reset failed.");
         return -1;
@@ -171,7 +142,9 @@ int lsm9ds1_reset_mag(lsm9ds1 *dev)
 }
 /**
  * @brief Store the magnetic field readings in the array of shorts, order: X
- * Y Z
+ * Y Z. All six output registers are read in one auto-increment burst, in the same
+ * transaction as the register address; with block data update enabled (see lsm9ds1_init())
+ * the bytes belong to the same sample.
  * 
  * @param dev Pointer to lsm9ds1
  * @param B Pointer to an array of short of length 3 where magnetometer reading is stored
@@ -179,48 +152,19 @@ int lsm9ds1_reset_mag(lsm9ds1 *dev)
  */
 int lsm9ds1_read_mag(lsm9ds1 *dev, short *B)
 {
-    // printf("In read_mag %d\n", __LINE__);
-    uint8_t buf, reg = MAG_OUT_X_L - 1;
-    for (int i = 0; i < 3; i++)
+    uint8_t buf[6];
+    if (i2c_bus_read(dev->bus, dev->mag_addr, MAG_OUT_X_L | MAG_AUTO_INCREMENT, buf, 6) < 0)
     {
-        B[i] = 0; // initialize with 0
-        // printf("In read_mag %d\n", __LINE__);
-        buf = ++reg; // insert the command into buffer
-        // printf("Buf: 0x%x\n", buf);
-        int wr = write(dev->mag_file, &buf, 1);
-        // printf("In read_mag %d\n", __LINE__);
-        if (wr < 1)
-        {
-            perror("read_mag failed");
-            return -1;
-        }
-        // printf("In read_mag %d\n", __LINE__);
-        if (read(dev->mag_file, &buf, 1) < 1)
-        {
-            perror("read_mag failed");
-            return -1;
-        }
-        // printf("In read_mag %d\n", __LINE__);
-        B[i] |= buf;
-        buf = ++reg; // select the next register
-        if (write(dev->mag_file, &buf, 1) < 1)
-        {
-            perror("read_mag failed");
-            return -1;
-        }
-        // printf("In read_mag %d\n", __LINE__);
-        if (read(dev->mag_file, &buf, 1) < 1)
-        {
-            perror("read_mag failed");
-            return -1;
-        }
-        B[i] |= 0xff00 & ((short)buf << 8);
-        // printf("In read_mag %d\n", __LINE__);
+        perror("read_mag failed");
+        return -1;
     }
+    for (int i = 0; i < 3; i++)
+        B[i] = (short)(buf[2 * i] | ((uint16_t)buf[2 * i + 1] << 8));
     return 1;
 }
 /**
- * @brief Set the mag field offsets using the array, order: X Y Z
+ * @brief Set the mag field offsets using the array, order: X Y Z. All six offset
+ * registers are written in one auto-increment burst.
  * 
  * @param dev Pointer to lsm9ds1
  * @param offset Pointer to an array of shorts of length 3 where magnetometer offset is stored
@@ -228,34 +172,154 @@ int lsm9ds1_read_mag(lsm9ds1 *dev, short *B)
  */
 int lsm9ds1_offset_mag(lsm9ds1 *dev, short *offset)
 {
-    uint8_t buf[2], reg = MAG_OFFSET_X_REG_L_M - 1;
+    uint8_t buf[6];
     for (int i = 0; i < 3; i++)
     {
-        buf[0] = ++reg; // insert the command into buffer
-        buf[1] = (uint8_t)offset[i];
-        if (write(dev->mag_file, &buf, 2) < 2)
+        buf[2 * i] = (uint8_t)offset[i];
+        buf[2 * i + 1] = (uint8_t)(offset[i] >> 8);
+    }
+    if (i2c_bus_write(dev->bus, dev->mag_addr, MAG_OFFSET_X_REG_L_M | MAG_AUTO_INCREMENT, buf, 6) < 0)
+    {
+        perror("offset_mag failed");
+        return -1;
+    }
+    return 1;
+}
+/**
+ * @brief Checks the identity of the accelerometer + gyro, powers down the accelerometer and
+ * configures the gyroscope. Enables block data update and register address auto increment,
+ * so that lsm9ds1_read_gyro() reads all axes of the same sample in one burst.
+ * 
+ * @param dev Pointer to lsm9ds1
+ * @param ctrl Data rate, full scale and bandwidth of the gyroscope
+ * @return Returns 1 on success, -1 on failure (the gyroscope is marked unavailable)
+ */
+int lsm9ds1_config_gyro(lsm9ds1 *dev, GYRO_CTRL ctrl)
+{
+    dev->gyro = 0;
+    uint8_t buf = 0;
+    if (i2c_bus_read(dev->bus, dev->xl_addr, LSM9DS1_WHO_AM_I, &buf, 1) < 0)
+    {
+        perror("config_gyro failed");
+        return -1;
+    }
+    if (buf != LSM9DS1_XG_IDENT)
+    {
+        fprintf(stderr, "config_gyro: Identity 0x%02x did not match\n", buf);
+        return -1;
+    }
+    const uint8_t regs[][2] = {
+        {LSM9DS1_CTRL_REG8, LSM9DS1_CTRL_REG8_DATA}, // block data update, auto increment
+        {LSM9DS1_CTRL_REG4, LSM9DS1_GYRO_AXES},      // gyroscope axes on
+        {LSM9DS1_CTRL_REG5_XL, LSM9DS1_XL_PD},       // accelerometer outputs off
+        {LSM9DS1_CTRL_REG6_XL, 0x00},                // accelerometer powered down: gyroscope only mode
+        {LSM9DS1_CTRL_REG1_G, *((uint8_t *)&ctrl)},  // gyroscope data rate and full scale
+    };
+    for (unsigned i = 0; i < sizeof(regs) / sizeof(regs[0]); i++)
+    {
+        if (i2c_bus_write(dev->bus, dev->xl_addr, regs[i][0], &regs[i][1], 1) < 0)
         {
-            perror("offset_mag failed");
+            perror("config_gyro failed");
             return -1;
         }
-        buf[0] = ++reg; // insert the next reg address
-        buf[1] = (uint8_t)(offset[i] >> 8);
-        if (write(dev->mag_file, &buf, 2) < 2)
+    }
+    dev->gyro = ctrl.data_rate != 0;
+    return 1;
+}
+/**
+ * @brief Store the latest angular speed reading in the array of shorts, order: X Y Z.
+ * All six output registers are read in one burst, so the three axes belong to the
+ * same sample.
+ * 
+ * @param dev Pointer to lsm9ds1
+ * @param W Pointer to an array of short of length 3 where gyroscope reading is stored
+ * @return Returns 1 on success, -1 on failure 
+ */
+int lsm9ds1_read_gyro(lsm9ds1 *dev, short *W)
+{
+    if (!dev->gyro)
+        return -1;
+    uint8_t buf[6];
+    if (i2c_bus_read(dev->bus, dev->xl_addr, LSM9DS1_OUT_X_L_G, buf, 6) < 0)
+    {
+        perror("read_gyro failed");
+        return -1;
+    }
+    for (int i = 0; i < 3; i++)
+        W[i] = (short)(buf[2 * i] | ((uint16_t)buf[2 * i + 1] << 8));
+    return 1;
+}
+/**
+ * @brief Enables or disables the FIFO of the gyroscope. Enabled, it runs in continuous mode:
+ * up to LSM9DS1_FIFO_SIZE of the newest samples are queued for lsm9ds1_read_gyro_fifo().
+ * 
+ * @param dev Pointer to lsm9ds1
+ * @param enable 1 to enable the FIFO, 0 to bypass it
+ * @return Returns 1 on success, -1 on failure (the FIFO is marked unavailable)
+ */
+int lsm9ds1_config_fifo(lsm9ds1 *dev, int enable)
+{
+    dev->fifo = 0;
+    const uint8_t regs[][2] = {
+        {LSM9DS1_FIFO_CTRL, LSM9DS1_FIFO_BYPASS},                                  // bypass first, empties the FIFO
+        {LSM9DS1_CTRL_REG9, enable ? LSM9DS1_FIFO_EN : 0x00},                      // FIFO enable
+        {LSM9DS1_FIFO_CTRL, enable ? LSM9DS1_FIFO_CONTINUOUS : LSM9DS1_FIFO_BYPASS}, // FIFO mode
+    };
+    for (unsigned i = 0; i < sizeof(regs) / sizeof(regs[0]); i++)
+    {
+        if (i2c_bus_write(dev->bus, dev->xl_addr, regs[i][0], &regs[i][1], 1) < 0)
         {
-            perror("offset_mag failed");
+            perror("config_fifo failed");
             return -1;
         }
     }
+    dev->fifo = enable;
     return 1;
 }
 /**
- * @brief Closes the file descriptors for the mag and accel and frees the allocated memory.
+ * @brief Store all angular speed samples queued in the FIFO in the array, oldest first,
+ * order: X Y Z. The samples are read in one burst after the FIFO status. Without the FIFO,
+ * reads the latest sample (see lsm9ds1_read_gyro()).
+ * 
+ * @param dev Pointer to lsm9ds1
+ * @param W Array of max samples where the gyroscope readings are stored
+ * @param max Maximum number of samples to read, at most LSM9DS1_FIFO_SIZE are queued
+ * @return Returns the number of samples read, 0 if the FIFO is empty, -1 on failure
+ */
+int lsm9ds1_read_gyro_fifo(lsm9ds1 *dev, short (*W)[3], int max)
+{
+    if (!dev->fifo)
+        return max > 0 ? lsm9ds1_read_gyro(dev, W[0]) : 0;
+    uint8_t buf[6 * LSM9DS1_FIFO_SIZE];
+    if (i2c_bus_read(dev->bus, dev->xl_addr, LSM9DS1_FIFO_SRC, buf, 1) < 0)
+    {
+        perror("read_gyro_fifo failed");
+        return -1;
+    }
+    int n = buf[0] & LSM9DS1_FIFO_FSS; // 32 when full
+    if (n > max)
+        n = max;
+    if (n > LSM9DS1_FIFO_SIZE)
+        n = LSM9DS1_FIFO_SIZE;
+    if (n <= 0)
+        return 0;
+    if (i2c_bus_read(dev->bus, dev->xl_addr, LSM9DS1_OUT_X_L_G, buf, 6 * n) < 0)
+    {
+        perror("read_gyro_fifo failed");
+        return -1;
+    }
+    for (int k = 0; k < n; k++)
+        for (int i = 0; i < 3; i++)
+            W[k][i] = (short)(buf[6 * k + 2 * i] | ((uint16_t)buf[6 * k + 2 * i + 1] << 8));
+    return n;
+}
+/**
+ * @brief Releases the I2C bus and frees the allocated memory.
  * 
  * @param dev Pointer to lsm9ds1
  */
 void lsm9ds1_destroy(lsm9ds1 *dev)
 {
-    close(dev->accel_file);
-    close(dev->mag_file);
+    i2c_bus_close(dev->bus);
     free(dev);
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 /**
  * @file lsm9ds1.h
  * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
- * @brief Function prototypes and data structures for LSM9DS1 Magnetometer I2C driver.
+ * @brief Function prototypes and data structures for LSM9DS1 Magnetometer and Gyroscope I2C driver.
  * @version 0.1
  * @date 2020-03-19
  * 
@@ -12,6 +12,7 @@
 #define LSM9DS1_H
 
 #include <stdint.h>
+#include "i2c_bus.h"
 /**
  * @brief Default I2C device address
  * 
@@ -24,12 +25,72 @@
 /**
  * @brief  * Accelerometer and Gyro registers
  * 
- * NOTE: Few registers are used ONLY TO
- * power down the accelerometer and the gyroscope.
+ * NOTE: The accelerometer is powered down, the
+ * gyroscope runs alone (gyroscope only mode).
  * 
  */
 #define LSM9DS1_CTRL_REG1_G 0x10 // Gyro control register
 #define LSM9DS1_GYRO_PD 0x00     ///< Content of the gyro control register for power down
+/**
+ * @brief Gyroscope data rate, full scale and bandwidth (CTRL_REG1_G).
+ * 
+ */
+typedef struct __attribute__((packed))
+{
+    uint8_t bandwidth : 2;  ///< Bandwidth selection, depends on data_rate. Default: 00
+    uint8_t reserved : 1;   ///< Reserved, must be 0.
+    /**
+     * @brief Full scale selection. Default value: 00
+     * 00: 245 dps
+     * 01: 500 dps
+     * 10: Not available
+     * 11: 2000 dps
+     */
+    uint8_t full_scale : 2;
+    /**
+     * @brief Output data rate. Default value: 000
+     * 000: Power down
+     * 001: 14.9 Hz
+     * 010: 59.5 Hz
+     * 011: 119 Hz (SPACE HAUC setting)
+     * 100: 238 Hz
+     * 101: 476 Hz
+     * 110: 952 Hz
+     */
+    uint8_t data_rate : 3;
+} GYRO_CTRL;
+
+#define LSM9DS1_STATUS_REG 0x17 ///< Status register of the accelerometer and gyroscope
+#define LSM9DS1_GYRO_DA 0x02    ///< Status register: new gyroscope data available
+#define LSM9DS1_OUT_X_L_G 0x18  ///< Gyroscope X axis measurement LOW byte, followed by X HIGH, Y LOW ... Z HIGH
+#define LSM9DS1_CTRL_REG4 0x1e  ///< Gyroscope axes enable register
+#define LSM9DS1_GYRO_AXES 0x38  ///< CTRL_REG4: Zen_G, Yen_G and Xen_G
+#define LSM9DS1_CTRL_REG8 0x22  ///< Accelerometer and gyroscope control register 8
+#define LSM9DS1_CTRL_REG8_DATA 0x44 ///< CTRL_REG8: block data update + register address auto increment
+#define LSM9DS1_WHO_AM_I 0x0f   ///< Address of accelerometer and gyroscope ID register
+#define LSM9DS1_XG_IDENT 0x68   ///< Accelerometer and gyroscope ID
+
+/**
+ * @brief FIFO registers. In gyroscope only mode every FIFO slot holds one gyroscope sample,
+ * read through the gyroscope output registers; with the FIFO enabled the register address
+ * rolls back from OUT_Z_H_G to OUT_X_L_G, so that queued samples are read in one burst.
+ * 
+ */
+#define LSM9DS1_CTRL_REG9 0x23       ///< Control register 9
+#define LSM9DS1_FIFO_EN 0x02         ///< CTRL_REG9: FIFO enable
+#define LSM9DS1_FIFO_CTRL 0x2e       ///< FIFO control register, FMODE[7:5] and FTH[4:0]
+#define LSM9DS1_FIFO_CONTINUOUS 0xc0 ///< FIFO_CTRL: continuous mode, the newest sample overwrites the oldest when full
+#define LSM9DS1_FIFO_BYPASS 0x00     ///< FIFO_CTRL: bypass mode, FIFO off
+#define LSM9DS1_FIFO_SRC 0x2f        ///< FIFO status register
+#define LSM9DS1_FIFO_OVRN 0x40       ///< FIFO_SRC: FIFO is full and at least one sample was overwritten
+#define LSM9DS1_FIFO_FSS 0x3f        ///< FIFO_SRC: number of unread samples
+#define LSM9DS1_FIFO_SIZE 32         ///< FIFO depth in samples
+
+/**
+ * @brief Gyroscope sensitivity at 245 dps full scale, in dps/LSB
+ * 
+ */
+#define LSM9DS1_GYRO_SCALE_245 8.75e-3
 /*
  * Refer to documentation
  */
@@ -164,15 +225,20 @@ typedef enum
     MAG_OUT_Z_L,        ///< Magnetometer Z axis measurement LOW byte
     MAG_OUT_Z_H         ///< Magnetometer Z axis measurement HIGH byte
 } MAG_OUT_DATA;
+
+#define MAG_AUTO_INCREMENT 0x80 ///< Set in the register address for multiple byte reads and writes of the magnetometer
 /**
  * @brief LSM9DS1 Device Struct
  * 
  */
 typedef struct
 {
-    int accel_file; ///< File descriptor for accelerometer + gyro
-    int mag_file;   ///< File descriptor for magnetometer
-    char fname[40]; ///< I2C Bus file name
+    i2c_bus *bus;     ///< I2C bus, shared by accelerometer + gyro, magnetometer and the other devices on it
+    uint8_t xl_addr;  ///< Accelerometer + gyro address
+    uint8_t mag_addr; ///< Magnetometer address
+    char fname[40];   ///< I2C Bus file name
+    int gyro;         ///< 1 if the gyroscope is configured and can be read
+    int fifo;         ///< 1 if the gyroscope samples are queued in the FIFO
 } lsm9ds1;
 
 #define MAG_WHO_AM_I 0x0f ///< Address of magnetometer ID register
@@ -183,6 +249,10 @@ int lsm9ds1_config_mag(lsm9ds1 *, MAG_DATA_RATE, MAG_RESET, MAG_DATA_READ);
 int lsm9ds1_reset_mag(lsm9ds1 *);
 int lsm9ds1_read_mag(lsm9ds1 *, short *);
 int lsm9ds1_offset_mag(lsm9ds1 *, short *);
+int lsm9ds1_config_gyro(lsm9ds1 *, GYRO_CTRL);
+int lsm9ds1_read_gyro(lsm9ds1 *, short *);
+int lsm9ds1_config_fifo(lsm9ds1 *, int);
+int lsm9ds1_read_gyro_fifo(lsm9ds1 *, short (*)[3], int);
 void lsm9ds1_destroy(lsm9ds1 *);
 
 #endif // LSM9DS1_H
\ No newline at end of file
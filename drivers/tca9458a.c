@@ -10,15 +10,13 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
-#include <fcntl.h>
-#include <linux/i2c-dev.h>
 #include <errno.h>
 #include <stdint.h>
-#include <sys/stat.h>
-#include <unistd.h>
 #include <string.h>
-#include <sys/ioctl.h>
 #include "tca9458a.h"
+
+extern inline int tca9458a_set(tca9458a *dev, uint8_t channel_id);
+extern inline void tca9458a_prepare(tca9458a *dev, uint8_t mask, struct i2c_msg *msg);
 /**
  * @brief Initialize a Mux device, returns 1 on success
  *  TODO: Implement a scan function at init where it checks all 3 CSS are
@@ -35,28 +33,30 @@ int tca9458a_init(tca9458a *dev, uint8_t addr)
     {
         perror("[TCA9458A] Device memory not allocated");
     }
-    // open bus
-    dev->fd = open(dev->fname, O_RDWR);
-    if (dev->fd < 0)
+    pthread_mutex_init(&dev->lock, NULL); // before any failure, tca9458a_destroy() destroys it
+    // open (or share) bus
+    dev->bus = i2c_bus_open(dev->fname);
+    if (dev->bus == NULL)
     {
-        status &= 0;
-        perror("[TCA9458A] Error opening FD");
-        return status;
-    }
-    // execute ioctl to associate FD with address
-    if ((status = ioctl(dev->fd, I2C_SLAVE, addr)) < 0)
-    {
-        perror("[TCA9458A] I2C ioctl failed");
+        perror("[TCA9458A] Error opening bus");
         return -1;
     }
-    else
-        status = 1;
+    dev->addr = addr;
     // disable all output
-    status &= tca9458a_set(dev, 8);
+    status = tca9458a_set(dev, 8);
     return status;
 }
+void tca9458a_acquire(tca9458a *dev)
+{
+    pthread_mutex_lock(&dev->lock);
+}
+
+void tca9458a_release(tca9458a *dev)
+{
+    pthread_mutex_unlock(&dev->lock);
+}
 /**
- * @brief Disable all outputs, close file descriptor for the I2C Bus.
+ * @brief Disable all outputs, release the I2C Bus.
  * 
  * @param dev 
  */
@@ -66,8 +66,9 @@ void tca9458a_destroy(tca9458a *dev)
         return;
     // disable mux
     tca9458a_set(dev, 8);
-    // close file descriptor
-    close(dev->fd);
+    // release bus
+    i2c_bus_close(dev->bus);
+    pthread_mutex_destroy(&dev->lock);
     // free allocated memory
     free(dev);
     return;
@@ -11,17 +11,22 @@
 #ifndef TCA9458A_H
 #define TCA9458A_H
 #include <stdint.h>
+#include <pthread.h>
+#include "i2c_bus.h"
 
 #define MUX_I2C_FIle "/dev/i2c-1" ///< I2C Device for Mux
+#define TCA9458A_CHANNEL(i) (0x01 << (i)) ///< Mask of channel i, channels can be combined
 /**
  * @brief TCA9458A Device handle.
  * 
  */
 typedef struct
 {
-    int fd;          ///< File descriptor for I2C Bus
-    char fname[40];  ///< File name for I2C Bus
-    uint8_t channel; ///< Current active channel
+    i2c_bus *bus;         ///< I2C bus, shared with the devices behind the mux
+    uint8_t addr;         ///< Mux address
+    char fname[40];       ///< File name for I2C Bus
+    uint8_t channel;      ///< Current active channel
+    pthread_mutex_t lock; ///< Held by the thread using the active channel, see tca9458a_acquire()
 } tca9458a;
 
 int tca9458a_init(tca9458a *, uint8_t);
@@ -30,12 +35,39 @@ int tca9458a_init(tca9458a *, uint8_t);
  * 
  * @param dev 
  * @param channel_id Channel to enable
- * @return Returns 1 on success, 0 or -1 on error (see write())
+ * @return Returns 1 on success, -1 on error
  */
 inline int tca9458a_set(tca9458a *dev, uint8_t channel_id)
 {
     dev->channel = channel_id < 8 ? 0x01 << channel_id : 0x00;
-    return write(dev->fd, &(dev->channel), 1);
+    return i2c_bus_send(dev->bus, dev->addr, &(dev->channel), 1);
 }
+/**
+ * @brief Fills in the message that enables the channels of the mask, to be combined with
+ * the messages to the devices behind them in one transaction.
+ * 
+ * @param dev 
+ * @param mask Channels to enable, see TCA9458A_CHANNEL()
+ * @param msg Message to fill in
+ */
+inline void tca9458a_prepare(tca9458a *dev, uint8_t mask, struct i2c_msg *msg)
+{
+    dev->channel = mask;
+    *msg = (struct i2c_msg){.addr = dev->addr, .flags = 0, .len = 1, .buf = &(dev->channel)};
+}
+/**
+ * @brief Waits until no other thread uses the mux. The channels selected until
+ * tca9458a_release() stay active, so that the devices behind them are read on the
+ * channel they were selected on. Other devices on the bus are not held back.
+ * 
+ * @param dev 
+ */
+void tca9458a_acquire(tca9458a *dev);
+/**
+ * @brief Releases the mux acquired with tca9458a_acquire().
+ * 
+ * @param dev 
+ */
+void tca9458a_release(tca9458a *dev);
 void tca9458a_destroy(tca9458a *);
 #endif
\ No newline at end of file
@@ -13,93 +13,58 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <fcntl.h>
 #include <errno.h>
-#include <sys/ioctl.h>
-#include <linux/types.h>
-#include <linux/i2c-dev.h>
 #include "tsl2561.h"
 // #include </usr/src/linux-headers-4.4.0-171-generic/include/config/i2c/smbus.h>
 // #include <i2c/smbus.h>
 #include <signal.h>
 
+static uint8_t tsl2561_power_off[2] = {0x80, 0x00}; // control register: power down
+static uint8_t tsl2561_power_on[2] = {0x80, 0x03};  // control register: power up, starts an integration
+static uint8_t tsl2561_data[2] = {0xac, 0xae};      // word reads of channel 0 (broadband) and channel 1 (ir)
+static uint8_t tsl2561_clear[1] = {0xc0};           // clears a pending interrupt
+
+// channel scale and clipping threshold by integration time (timing & TSL2561_TIMING_INTEG)
+static const uint32_t tsl2561_lux_chscale[4] = {TSL2561_LUX_CHSCALE_TINT0, TSL2561_LUX_CHSCALE_TINT1, 1 << TSL2561_LUX_CHSCALE, 1 << TSL2561_LUX_CHSCALE};
+static const uint32_t tsl2561_lux_clip[4] = {TSL2561_CLIPPING_13MS, TSL2561_CLIPPING_101MS, TSL2561_CLIPPING_402MS, TSL2561_CLIPPING_402MS};
+// segments of the ratio of the channels: upper bounds K (as 2K + 1, see tsl2561_calc_lux_batch()) and coefficients B, M
+#ifdef TSL2561_PACKAGE_CS
+static const uint32_t tsl2561_lux_k[TSL2561_LUX_SEGMENTS - 1] = {2 * TSL2561_LUX_K1C + 1, 2 * TSL2561_LUX_K2C + 1, 2 * TSL2561_LUX_K3C + 1, 2 * TSL2561_LUX_K4C + 1, 2 * TSL2561_LUX_K5C + 1, 2 * TSL2561_LUX_K6C + 1, 2 * TSL2561_LUX_K7C + 1};
+static const uint32_t tsl2561_lux_b[TSL2561_LUX_SEGMENTS] = {TSL2561_LUX_B1C, TSL2561_LUX_B2C, TSL2561_LUX_B3C, TSL2561_LUX_B4C, TSL2561_LUX_B5C, TSL2561_LUX_B6C, TSL2561_LUX_B7C, TSL2561_LUX_B8C};
+static const uint32_t tsl2561_lux_m[TSL2561_LUX_SEGMENTS] = {TSL2561_LUX_M1C, TSL2561_LUX_M2C, TSL2561_LUX_M3C, TSL2561_LUX_M4C, TSL2561_LUX_M5C, TSL2561_LUX_M6C, TSL2561_LUX_M7C, TSL2561_LUX_M8C};
+#else
+static const uint32_t tsl2561_lux_k[TSL2561_LUX_SEGMENTS - 1] = {2 * TSL2561_LUX_K1T + 1, 2 * TSL2561_LUX_K2T + 1, 2 * TSL2561_LUX_K3T + 1, 2 * TSL2561_LUX_K4T + 1, 2 * TSL2561_LUX_K5T + 1, 2 * TSL2561_LUX_K6T + 1, 2 * TSL2561_LUX_K7T + 1};
+static const uint32_t tsl2561_lux_b[TSL2561_LUX_SEGMENTS] = {TSL2561_LUX_B1T, TSL2561_LUX_B2T, TSL2561_LUX_B3T, TSL2561_LUX_B4T, TSL2561_LUX_B5T, TSL2561_LUX_B6T, TSL2561_LUX_B7T, TSL2561_LUX_B8T};
+static const uint32_t tsl2561_lux_m[TSL2561_LUX_SEGMENTS] = {TSL2561_LUX_M1T, TSL2561_LUX_M2T, TSL2561_LUX_M3T, TSL2561_LUX_M4T, TSL2561_LUX_M5T, TSL2561_LUX_M6T, TSL2561_LUX_M7T, TSL2561_LUX_M8T};
+#endif
+
 /**
- * @brief write 8 bytes to the device represented by the file descriptor.
- * 
- * @param fd 
- * @param val 
- */
-static inline void write8(int fd, uint8_t val)
-{
-    uint8_t buf = val;
-    int res = write(fd, &buf, 1);
-    if (res != 1)
-        perror(__FUNCTION__);
-}
-/**
- * @brief Write a command to the register on the device represented by fd
+ * @brief Write a command to the register on the device
  * 
- * @param fd File descriptor
+ * @param dev Pointer to tsl2561
  * @param reg Register address
  * @param val Value to write at register address
  */
-static inline void writecmd8(int fd, uint8_t reg, uint8_t val)
+static inline void writecmd8(tsl2561 *dev, uint8_t reg, uint8_t val)
 {
-    uint8_t buf[2] = {0x0};
-    buf[0] = reg;
-    buf[1] = val;
-    int res = write(fd, &buf, 2);
-    if (res != 2)
+    if (i2c_bus_write(dev->bus, dev->addr, reg, &val, 1) < 0)
         perror(__FUNCTION__);
 }
 /**
- * @brief Read a byte from the specified register on the device represented by fd
+ * @brief Read a byte from the specified register on the device, register write
+ * and read in one transaction
  * 
- * @param fd 
+ * @param dev Pointer to tsl2561
  * @param reg Register address
  * @return Byte read over serial 
  */
-static inline uint8_t read8(int fd, uint8_t reg)
+static inline uint8_t read8(tsl2561 *dev, uint8_t reg)
 {
-    write8(fd, reg);
     uint8_t buf = 0x00;
-    int res = read(fd, &buf, 1);
-    if (res != 1)
+    if (i2c_bus_read(dev->bus, dev->addr, reg, &buf, 1) < 0)
         perror(__FUNCTION__);
     return buf;
 }
-/**
- * @brief Write 16 bits to the device (very similar to writecmd8())
- * 
- * @param fd 
- * @param val 
- */
-static inline void write16(int fd, uint16_t val)
-{
-    uint8_t buf[2];
-    buf[0] = val >> 8;
-    buf[1] = 0x00ff & val;
-    int res = write(fd, buf, 2);
-    if (res != 2)
-        perror(__FUNCTION__);
-    return;
-}
-/**
- * @brief Read 2 bytes in LE format from reg on the device represented by fd 
- * 
- * @param fd 
- * @param cmd 
- * @return uint16_t 
- */
-static inline uint16_t read16(int fd, uint8_t cmd)
-{
-    uint8_t buf[2] = {0x0};
-    write8(fd, cmd);
-    int res = read(fd, buf, 2);
-    if (res != 2)
-        perror(__FUNCTION__);
-    return buf[0] | ((unsigned short)buf[1]) << 8;
-}
 
 /**
  * @brief Init function for the TSL2561 device. Default: I2C_BUS
@@ -112,68 +77,345 @@ static inline uint16_t read16(int fd, uint8_t cmd)
  */
 int tsl2561_init(tsl2561 *dev, uint8_t s_address)
 {
-    // Create the file descriptor handle to the device
-    dev->fd = open(I2C_BUS, O_RDWR);
-    if (dev->fd < 0)
+    // Take the shared handle to the bus
+    dev->bus = i2c_bus_open(I2C_BUS);
+    if (dev->bus == NULL)
     {
-        perror("[ERROR] TSL2561 Could not create a file descriptor.");
-        return -1;
-    }
-
-    // Configure file descriptor handle as a slave device w/input address
-    if (ioctl(dev->fd, I2C_SLAVE, s_address) < 0)
-    {
-        perror("[ERROR] TSL2561 Could not assign device.");
+        perror("[ERROR] TSL2561 Could not open the I2C bus.");
         return -1;
     }
+    dev->addr = s_address;
 
     // Power the device - write to control register
-    writecmd8(dev->fd, 0x80, 0x03);
+    writecmd8(dev, 0x80, 0x03);
     usleep(100000);
     // Verify that device is powered
-    if ((read8(dev->fd, 0x80) & 0x3) != 0x3)
+    if ((read8(dev, 0x80) & 0x3) != 0x3)
     {
         perror("Device not powered up");
         return -1;
     }
     /* DO NOT READ THE DEVICE REGISTER */
-#ifdef CSS_LOW_GAIN
-    // Set the timing and gain
-    writecmd8(dev->fd, 0x81, 0x00);
-    if (read8(dev->fd, 0x81))
+    // Set the timing and gain the sensors were calibrated at, adapted later by tsl2561_autogain()
+    if (tsl2561_set_timing(dev, TSL2561_TIMING_DEFAULT) < 0 || read8(dev, 0x81) != TSL2561_TIMING_DEFAULT)
     {
         perror("Could not set timing and gain");
         return -1;
     }
-#endif
-    return dev->fd; // should be > 0 in this case
+    return 1;
+}
+/**
+ * @brief Sets the gain and integration time of the device. The data registers hold
+ * readings of the previous timing until the first integration at the new one completes,
+ * tsl2561_integ_wait() later.
+ * 
+ * @param dev 
+ * @param timing Timing register value, integration time (tsl2561IntegrationTime_t) | gain (tsl2561Gain_t)
+ * @return 1 on success, -1 on failure (the timing of the device is unchanged)
+ */
+int tsl2561_set_timing(tsl2561 *dev, uint8_t timing)
+{
+    timing &= TSL2561_TIMING_INTEG | TSL2561_TIMING_GAIN;
+    if (i2c_bus_write(dev->bus, dev->addr, 0x81, &timing, 1) < 0)
+    {
+        perror(__FUNCTION__);
+        return -1;
+    }
+    dev->timing = timing;
+    return 1;
+}
+/**
+ * @brief Time an integration at the timing takes, with margin, in usec.
+ * 
+ * @param timing Timing register value
+ * @return Wait in usec
+ */
+uint32_t tsl2561_integ_wait(uint8_t timing)
+{
+    switch (timing & TSL2561_TIMING_INTEG)
+    {
+    case TSL2561_INTEGRATIONTIME_13MS:
+        return TSL2561_DELAY_INTTIME_13MS * 1000;
+    case TSL2561_INTEGRATIONTIME_101MS:
+        return TSL2561_DELAY_INTTIME_101MS * 1000;
+    default:
+        return TSL2561_DELAY_INTTIME_402MS * 1000;
+    }
+}
+/**
+ * @brief Relative sensitivity of a timing: integration time in units of the internal
+ * oscillator (11, 81, 322 for 13.7, 101, 402 ms) times the gain.
+ * 
+ */
+static inline uint32_t tsl2561_sensitivity(uint8_t timing)
+{
+    static const uint32_t integ[4] = {11, 81, 322, 322};
+    return integ[timing & TSL2561_TIMING_INTEG] * ((timing & TSL2561_TIMING_GAIN) ? 16 : 1);
+}
+/**
+ * @brief Lowest and highest usable counts at a timing (auto-gain thresholds).
+ * 
+ */
+static inline void tsl2561_agc_range(uint8_t timing, uint32_t *lo, uint32_t *hi)
+{
+    switch (timing & TSL2561_TIMING_INTEG)
+    {
+    case TSL2561_INTEGRATIONTIME_13MS:
+        *lo = TSL2561_AGC_TLO_13MS;
+        *hi = TSL2561_AGC_THI_13MS;
+        break;
+    case TSL2561_INTEGRATIONTIME_101MS:
+        *lo = TSL2561_AGC_TLO_101MS;
+        *hi = TSL2561_AGC_THI_101MS;
+        break;
+    default:
+        *lo = TSL2561_AGC_TLO_402MS;
+        *hi = TSL2561_AGC_THI_402MS;
+        break;
+    }
+}
+/**
+ * @brief Picks the timing for the next reading of a sensor from its last reading: the
+ * shortest integration time, and at it the highest gain, at which the counts of both
+ * channels are predicted to stay within the auto-gain thresholds. The current timing is
+ * kept while its counts are within the thresholds, unless a shorter integration time
+ * has twice the lowest usable counts, so that the timing does not toggle on noise.
+ * A saturated reading drops to the least sensitive timing; a reading too dark for every
+ * timing up to TSL2561_AGC_INTEG_MAX gets the most sensitive one.
+ * 
+ * @param timing Timing the reading was taken at
+ * @param measure Reading, see tsl2561_measure()
+ * @return Timing for the next reading
+ */
+uint8_t tsl2561_autogain(uint8_t timing, uint32_t measure)
+{
+    uint32_t broadband = measure >> 16, ir = measure & 0xffff;
+    uint32_t counts = broadband > ir ? broadband : ir, lo, hi;
+    tsl2561_agc_range(timing, &lo, &hi);
+    int in_range = counts >= lo && counts <= hi;
+    uint32_t sens = tsl2561_sensitivity(timing);
+    for (uint8_t integ = TSL2561_INTEGRATIONTIME_13MS; integ <= TSL2561_AGC_INTEG_MAX; integ++)
+    {
+        for (int g = 0; g < 2; g++)
+        {
+            uint8_t next = integ | (g ? TSL2561_GAIN_1X : TSL2561_GAIN_16X);
+            uint32_t next_lo, next_hi, predicted = counts * tsl2561_sensitivity(next) / sens;
+            tsl2561_agc_range(next, &next_lo, &next_hi);
+            if (predicted < next_lo || predicted > next_hi)
+                continue;
+            if (next == timing || !in_range)
+                return next;
+            if (integ < (timing & TSL2561_TIMING_INTEG) && predicted >= 2 * next_lo) // shorter with margin
+                return next;
+            return timing;
+        }
+    }
+    if (in_range)
+        return timing;
+    if (counts > hi)
+        return TSL2561_INTEGRATIONTIME_13MS | TSL2561_GAIN_1X;
+    return TSL2561_AGC_INTEG_MAX | TSL2561_GAIN_16X;
+}
+/**
+ * @brief Restarts the integration of the device: power down and power up in one
+ * transaction. The new reading is ready tsl2561_integ_wait() usec later.
+ * 
+ * @param dev 
+ * @return 1 on success, -1 on failure
+ */
+int tsl2561_start(tsl2561 *dev)
+{
+    struct i2c_msg msgs[TSL2561_START_MSGS];
+    tsl2561_start_prepare(dev->addr, msgs);
+    return i2c_bus_transfer(dev->bus, msgs, TSL2561_START_MSGS);
+}
+/**
+ * @brief Fills in the TSL2561_START_MSGS messages of tsl2561_start() for the address,
+ * to be combined with other messages in one transaction. With several mux channels
+ * enabled, the messages restart the sensors at this address on all of them.
+ * 
+ * @param s_address Address of the device
+ * @param msgs Array of TSL2561_START_MSGS messages
+ */
+void tsl2561_start_prepare(uint8_t s_address, struct i2c_msg *msgs)
+{
+    msgs[0] = (struct i2c_msg){.addr = s_address, .flags = 0, .len = 2, .buf = tsl2561_power_off};
+    msgs[1] = (struct i2c_msg){.addr = s_address, .flags = 0, .len = 2, .buf = tsl2561_power_on};
+}
+/**
+ * @brief Configures the threshold interrupt of the device and clears a pending one. The
+ * interrupt compares channel 0 (broadband) counts at the timing of the device, see
+ * tsl2561_lux_threshold().
+ * 
+ * @param dev 
+ * @param low Interrupt below this channel 0 count
+ * @param high Interrupt above this channel 0 count
+ * @param control TSL2561_INTR_OFF, or TSL2561_INTR_LEVEL | persistence
+ * @return 1 on success, -1 on failure
+ */
+int tsl2561_set_interrupt(tsl2561 *dev, uint16_t low, uint16_t high, uint8_t control)
+{
+    struct i2c_msg msgs[TSL2561_INTERRUPT_MSGS];
+    uint8_t buf[TSL2561_INTERRUPT_BUF];
+    tsl2561_interrupt_prepare(dev->addr, dev->timing, low, high, control, msgs, buf);
+    return i2c_bus_transfer(dev->bus, msgs, TSL2561_INTERRUPT_MSGS);
+}
+/**
+ * @brief Fills in the TSL2561_INTERRUPT_MSGS messages of tsl2561_set_interrupt() for the
+ * address, to be combined with other messages in one transaction. The timing is written
+ * too, since the thresholds only hold at the timing they were computed for. With several
+ * mux channels enabled, the messages configure the sensors at this address on all of them.
+ * 
+ * @param s_address Address of the device
+ * @param timing Timing register value
+ * @param low Interrupt below this channel 0 count
+ * @param high Interrupt above this channel 0 count
+ * @param control TSL2561_INTR_OFF, or TSL2561_INTR_LEVEL | persistence
+ * @param msgs Array of TSL2561_INTERRUPT_MSGS messages
+ * @param buf Buffer of TSL2561_INTERRUPT_BUF bytes, has to stay valid until the transfer
+ */
+void tsl2561_interrupt_prepare(uint8_t s_address, uint8_t timing, uint16_t low, uint16_t high, uint8_t control, struct i2c_msg *msgs, uint8_t *buf)
+{
+    buf[0] = TSL2561_COMMAND_BIT | TSL2561_REGISTER_TIMING;
+    buf[1] = timing & (TSL2561_TIMING_INTEG | TSL2561_TIMING_GAIN);
+    buf[2] = TSL2561_COMMAND_BIT | TSL2561_WORD_BIT | TSL2561_REGISTER_THRESHHOLDL_LOW;
+    buf[3] = low;
+    buf[4] = low >> 8;
+    buf[5] = TSL2561_COMMAND_BIT | TSL2561_WORD_BIT | TSL2561_REGISTER_THRESHHOLDH_LOW;
+    buf[6] = high;
+    buf[7] = high >> 8;
+    buf[8] = TSL2561_COMMAND_BIT | TSL2561_REGISTER_INTERRUPT;
+    buf[9] = control & (TSL2561_INTR_LEVEL | TSL2561_INTR_PERSIST);
+    msgs[0] = (struct i2c_msg){.addr = s_address, .flags = 0, .len = 2, .buf = &buf[0]}; // timing
+    msgs[1] = (struct i2c_msg){.addr = s_address, .flags = 0, .len = 3, .buf = &buf[2]}; // low threshold
+    msgs[2] = (struct i2c_msg){.addr = s_address, .flags = 0, .len = 3, .buf = &buf[5]}; // high threshold
+    msgs[3] = (struct i2c_msg){.addr = s_address, .flags = 0, .len = 2, .buf = &buf[8]}; // control
+    msgs[4] = (struct i2c_msg){.addr = s_address, .flags = 0, .len = 1, .buf = tsl2561_clear};
 }
 /**
  * @brief Read I2C data into the uint32_t measure var.\
  * Format: (MSB) broadband | ir (LSB)
+ * Both channels are read in one combined transaction.
  * 
  * @param dev 
  * @param measure Pointer to unsigned 32 bit integer where measurement is stored
  */
 void tsl2561_measure(tsl2561 *dev, uint32_t *measure)
 {
-    *measure = ((uint32_t)read16(dev->fd, 0xac)) << 16 | read16(dev->fd, 0xae);
+    uint8_t buf[4] = {0x0};
+    struct i2c_msg msgs[TSL2561_MEASURE_MSGS];
+    tsl2561_measure_prepare(dev, msgs, buf);
+    if (i2c_bus_transfer(dev->bus, msgs, TSL2561_MEASURE_MSGS) < 0)
+        perror(__FUNCTION__);
+    *measure = tsl2561_measure_decode(buf);
     return;
 }
 /**
- * @brief Calculate lux using value measured using tsl2561_measure()
+ * @brief Fills in the TSL2561_MEASURE_MSGS messages of tsl2561_measure(), to be combined
+ * with other messages in one transaction. Decode the result with tsl2561_measure_decode().
+ * 
+ * @param dev 
+ * @param msgs Array of TSL2561_MEASURE_MSGS messages
+ * @param buf Buffer of 4 bytes the channels are read into
+ */
+void tsl2561_measure_prepare(tsl2561 *dev, struct i2c_msg *msgs, uint8_t *buf)
+{
+    msgs[0] = (struct i2c_msg){.addr = dev->addr, .flags = 0, .len = 1, .buf = &tsl2561_data[0]}; // broadband
+    msgs[1] = (struct i2c_msg){.addr = dev->addr, .flags = I2C_M_RD, .len = 2, .buf = &buf[0]};
+    msgs[2] = (struct i2c_msg){.addr = dev->addr, .flags = 0, .len = 1, .buf = &tsl2561_data[1]}; // ir
+    msgs[3] = (struct i2c_msg){.addr = dev->addr, .flags = I2C_M_RD, .len = 2, .buf = &buf[2]};
+}
+/**
+ * @brief Converts the buffer read with the messages of tsl2561_measure_prepare() to the
+ * format of tsl2561_measure().
+ * 
+ * @param buf Buffer of 4 bytes
+ * @return (MSB) broadband | ir (LSB)
+ */
+uint32_t tsl2561_measure_decode(const uint8_t *buf)
+{
+    return ((uint32_t)(buf[0] | ((unsigned short)buf[1]) << 8)) << 16 | (buf[2] | ((unsigned short)buf[3]) << 8);
+}
+/**
+ * @brief Calculate lux using value measured using tsl2561_measure() at the
+ * default timing, TSL2561_TIMING_DEFAULT
  * 
  * @param measure 
  * @return Lux value 
  */
 uint32_t tsl2561_get_lux(uint32_t measure)
+{
+    return tsl2561_calc_lux(measure, TSL2561_TIMING_DEFAULT);
+}
+/**
+ * @brief Channel 0 threshold for an interrupt at the lux value: the largest count at the
+ * timing whose reading without infrared is below lux. A reading with infrared at the
+ * same count is dimmer, so the interrupt never fires late.
+ * 
+ * @param lux Lux value
+ * @param timing Timing register value
+ * @return Channel 0 count, the clipping threshold if lux saturates the sensor
+ */
+uint16_t tsl2561_lux_threshold(uint32_t lux, uint8_t timing)
+{
+    uint32_t lo = 0, hi;
+    switch (timing & TSL2561_TIMING_INTEG)
+    {
+    case TSL2561_INTEGRATIONTIME_13MS:
+        hi = TSL2561_CLIPPING_13MS;
+        break;
+    case TSL2561_INTEGRATIONTIME_101MS:
+        hi = TSL2561_CLIPPING_101MS;
+        break;
+    default:
+        hi = TSL2561_CLIPPING_402MS;
+        break;
+    }
+    if (tsl2561_calc_lux(hi << 16, timing) < lux)
+        return hi;
+    while (lo < hi) // smallest count that reaches lux, the lux value grows with the count
+    {
+        uint32_t mid = (lo + hi) / 2;
+        if (tsl2561_calc_lux(mid << 16, timing) < lux)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo > 0 ? lo - 1 : 0;
+}
+/**
+ * @brief Calculate lux using value measured using tsl2561_measure() at the
+ * given gain and integration time
+ * 
+ * @param measure 
+ * @param timing Timing register value the measurement was taken at
+ * @return Lux value, 65536 if the sensor is saturated
+ */
+uint32_t tsl2561_calc_lux(uint32_t measure, uint8_t timing)
 {
     unsigned long chScale;
     unsigned long channel1;
     unsigned long channel0;
+    uint16_t clipThreshold;
+
+    /* Get the clipping threshold and the correct scale depending on the intergration time */
+    switch (timing & TSL2561_TIMING_INTEG)
+    {
+    case TSL2561_INTEGRATIONTIME_13MS:
+        clipThreshold = TSL2561_CLIPPING_13MS;
+        chScale = TSL2561_LUX_CHSCALE_TINT0;
+        break;
+    case TSL2561_INTEGRATIONTIME_101MS:
+        clipThreshold = TSL2561_CLIPPING_101MS;
+        chScale = TSL2561_LUX_CHSCALE_TINT1;
+        break;
+    default: // no scaling
+        clipThreshold = TSL2561_CLIPPING_402MS;
+        chScale = (1 << TSL2561_LUX_CHSCALE);
+        break;
+    }
 
     /* Make sure the sensor isn't saturated! */
-    uint16_t clipThreshold = TSL2561_CLIPPING_13MS;
     uint16_t broadband = measure >> 16;
     uint16_t ir = measure;
     /* Return 65536 lux if the sensor is saturated */
@@ -182,14 +424,9 @@ uint32_t tsl2561_get_lux(uint32_t measure)
         return 65536;
     }
 
-    /* Get the correct scale depending on the intergration time */
-
-    chScale = TSL2561_LUX_CHSCALE_TINT0;
-
     /* Scale for gain (1x or 16x) */
-    // if (!_tsl2561Gain)
-    // Gain 1x -> _tsl2561Gain == 0 so the if statement evaluates true
-    chScale = chScale << 4;
+    if (!(timing & TSL2561_TIMING_GAIN))
+        chScale = chScale << 4;
 
     /* Scale the channel values */
     channel0 = (broadband * chScale) >> TSL2561_LUX_CHSCALE;
@@ -308,14 +545,64 @@ uint32_t tsl2561_get_lux(uint32_t measure)
     return lux;
 }
 /**
- * @brief Destroy function for the TSL2561 device. Closes the file descriptor
+ * @brief Sets up the lux conversion coefficients of a sensor, with its calibration gain
+ * folded in. A gain of 1 converts bit for bit like tsl2561_calc_lux().
+ * 
+ * @param tab Table to fill in
+ * @param gain Calibration gain, the lux values are multiplied by it (resolution 2^-TSL2561_LUX_GAINSCALE)
+ */
+void tsl2561_lux_table_init(tsl2561_lux_table *tab, float gain)
+{
+    uint32_t g = gain > 0 ? (uint32_t)(gain * (1 << TSL2561_LUX_GAINSCALE) + 0.5f) : 0;
+    for (int j = 0; j < TSL2561_LUX_SEGMENTS; j++)
+    {
+        tab->b[j] = tsl2561_lux_b[j] * g;
+        tab->m[j] = tsl2561_lux_m[j] * g;
+    }
+}
+/**
+ * @brief Converts n measurements of tsl2561_measure() to lux in one pass, without
+ * branches: the segment of the ratio of the channels is counted from the bounds instead
+ * of searched, and ratio > K is tested as channel1 * 2^(RATIOSCALE + 1) >= (2K + 1) * channel0,
+ * which is the rounded ratio of tsl2561_calc_lux() without the division. With unity gains
+ * the result is bit for bit that of tsl2561_calc_lux().
+ * 
+ * @param tab Lux conversion table of each measurement, see tsl2561_lux_table_init()
+ * @param measure Measurements, (MSB) broadband | ir (LSB)
+ * @param timing Timing register value of each measurement
+ * @param lux Lux values, 65536 where the sensor is saturated
+ * @param n Number of measurements
+ */
+void tsl2561_calc_lux_batch(const tsl2561_lux_table *tab, const uint32_t *measure, const uint8_t *timing, uint32_t *lux, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        uint32_t broadband = measure[i] >> 16;
+        uint32_t ir = measure[i] & 0xffff;
+        uint32_t integ = timing[i] & TSL2561_TIMING_INTEG;
+        uint64_t chScale = tsl2561_lux_chscale[integ] << ((timing[i] & TSL2561_TIMING_GAIN) ? 0 : 4);
+        uint64_t channel0 = (broadband * chScale) >> TSL2561_LUX_CHSCALE;
+        uint64_t channel1 = (ir * chScale) >> TSL2561_LUX_CHSCALE;
+        uint32_t seg = 0;
+        for (int j = 0; j < TSL2561_LUX_SEGMENTS - 1; j++)
+            seg += (channel1 << (TSL2561_LUX_RATIOSCALE + 1)) >= tsl2561_lux_k[j] * channel0;
+        seg &= -(uint32_t)(channel0 != 0); // ratio 0 without light on channel 0
+        uint64_t pos = channel0 * tab[i].b[seg];
+        uint64_t neg = channel1 * tab[i].m[seg];
+        uint64_t temp = (pos > neg ? pos - neg : 0) + (1ULL << (TSL2561_LUX_LUXSCALE + TSL2561_LUX_GAINSCALE - 1));
+        uint32_t clip = tsl2561_lux_clip[integ];
+        lux[i] = (broadband > clip || ir > clip) ? 65536 : (uint32_t)(temp >> (TSL2561_LUX_LUXSCALE + TSL2561_LUX_GAINSCALE));
+    }
+}
+/**
+ * @brief Destroy function for the TSL2561 device. Releases the I2C bus
  *  and powers down the device
  * 
  * @param dev 
  */
 void tsl2561_destroy(tsl2561 *dev)
 {
-    writecmd8(dev->fd, 0x80, 0x00);
-    close(dev->fd);
+    writecmd8(dev, 0x80, 0x00);
+    i2c_bus_close(dev->bus);
     free(dev);
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 #define TSL2561_H
 
 #include <stdint.h>
+#include "i2c_bus.h"
 
 /******************************************************************************/
 #define TSL2561_VISIBLE 2      ///< channel 0 - channel 1
@@ -41,6 +42,8 @@
 #define TSL2561_LUX_CHSCALE (10)           ///< Scale channel values by 2^10
 #define TSL2561_LUX_CHSCALE_TINT0 (0x7517) ///< 322/11 * 2^TSL2561_LUX_CHSCALE
 #define TSL2561_LUX_CHSCALE_TINT1 (0x0FE7) ///< 322/81 * 2^TSL2561_LUX_CHSCALE
+#define TSL2561_LUX_GAINSCALE (12)         ///< Scale calibration gains by 2^12, see tsl2561_lux_table
+#define TSL2561_LUX_SEGMENTS (8)           ///< Segments of the ratio of the channels in the lux conversion
 
 // T, FN and CL package values
 #define TSL2561_LUX_K1T (0x0040) ///< 0.125 * 2^RATIO_SCALE
@@ -154,6 +157,18 @@ typedef enum
     TSL2561_GAIN_16X = 0x10, ///< 16x gain
 } tsl2561Gain_t;
 
+#define TSL2561_TIMING_INTEG 0x03                                           ///< Integration time bits of the timing register, see tsl2561IntegrationTime_t
+#define TSL2561_TIMING_GAIN 0x10                                            ///< Gain bit of the timing register, see tsl2561Gain_t
+#define TSL2561_TIMING_DEFAULT (TSL2561_INTEGRATIONTIME_13MS | TSL2561_GAIN_1X) ///< Timing set by tsl2561_init()
+
+/**
+ * @brief Longest integration time tsl2561_autogain() picks.
+ * 
+ */
+#ifndef TSL2561_AGC_INTEG_MAX
+#define TSL2561_AGC_INTEG_MAX TSL2561_INTEGRATIONTIME_402MS
+#endif
+
 /******************************************************************************/
 #define I2C_BUS "/dev/i2c-1"    ///< I2C bus name
 #define TSL2561_BLOCK_READ 0x0B ///< Block read mask
@@ -164,12 +179,48 @@ typedef enum
  */
 typedef struct
 {
-    int fd;         ///< File descriptor for I2C bus
+    i2c_bus *bus;   ///< I2C bus, shared with the other devices on it
+    uint8_t addr;   ///< Device address
+    uint8_t timing; ///< Gain and integration time (timing register), see tsl2561_set_timing()
     char fname[40]; ///< I2C Device name
 } tsl2561;
 
+/**
+ * @brief Lux conversion coefficients of one sensor for tsl2561_calc_lux_batch(): the
+ * coefficients of each segment of the ratio of the channels, multiplied by the calibration
+ * gain of the sensor. Set up with tsl2561_lux_table_init().
+ * 
+ */
+typedef struct
+{
+    uint32_t b[TSL2561_LUX_SEGMENTS]; ///< Channel 0 coefficients, 2^(LUX_SCALE + LUX_GAINSCALE)
+    uint32_t m[TSL2561_LUX_SEGMENTS]; ///< Channel 1 coefficients, 2^(LUX_SCALE + LUX_GAINSCALE)
+} tsl2561_lux_table;
+
+#define TSL2561_START_MSGS 2      ///< Messages of an integration restart, see tsl2561_start_prepare()
+#define TSL2561_MEASURE_MSGS 4    ///< Messages of a measurement, see tsl2561_measure_prepare()
+#define TSL2561_INTERRUPT_MSGS 5  ///< Messages of the interrupt setup, see tsl2561_interrupt_prepare()
+#define TSL2561_INTERRUPT_BUF 10  ///< Buffer bytes of the interrupt setup, see tsl2561_interrupt_prepare()
+
+#define TSL2561_INTR_OFF 0x00     ///< Interrupt control: interrupt output disabled
+#define TSL2561_INTR_LEVEL 0x10   ///< Interrupt control: level interrupt (INT pin low until cleared), | persistence
+#define TSL2561_INTR_PERSIST 0x0f ///< Interrupt control: integrations in a row outside the thresholds before the interrupt (0: every integration)
+
 int tsl2561_init(tsl2561 *dev, uint8_t s_address);
+int tsl2561_start(tsl2561 *dev);
+void tsl2561_start_prepare(uint8_t s_address, struct i2c_msg *msgs);
+int tsl2561_set_timing(tsl2561 *dev, uint8_t timing);
+uint32_t tsl2561_integ_wait(uint8_t timing);
+uint8_t tsl2561_autogain(uint8_t timing, uint32_t measure);
 void tsl2561_measure(tsl2561 *dev, uint32_t *measure);
+void tsl2561_measure_prepare(tsl2561 *dev, struct i2c_msg *msgs, uint8_t *buf);
+uint32_t tsl2561_measure_decode(const uint8_t *buf);
 uint32_t tsl2561_get_lux(uint32_t measure);
+uint32_t tsl2561_calc_lux(uint32_t measure, uint8_t timing);
+void tsl2561_lux_table_init(tsl2561_lux_table *tab, float gain);
+void tsl2561_calc_lux_batch(const tsl2561_lux_table *tab, const uint32_t *measure, const uint8_t *timing, uint32_t *lux, int n);
+uint16_t tsl2561_lux_threshold(uint32_t lux, uint8_t timing);
+int tsl2561_set_interrupt(tsl2561 *dev, uint16_t low, uint16_t high, uint8_t control);
+void tsl2561_interrupt_prepare(uint8_t s_address, uint8_t timing, uint16_t low, uint16_t high, uint8_t control, struct i2c_msg *msgs, uint8_t *buf);
 void tsl2561_destroy(tsl2561 *dev);
 #endif // TSL2561_H
\ No newline at end of file
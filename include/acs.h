@@ -11,66 +11,8 @@
 #ifndef ACS_H
 #define ACS_H
 #include <acs_extern.h> // will define SH_BUFFER_SIZE
-/**
- * @brief Dipole moment of the magnetorquer rods
- * 
- */
-#define DIPOLE_MOMENT 0.22 // A m^-2
-/**
- * @brief ACS loop time period
- * 
- */
-#define DETUMBLE_TIME_STEP 100000 // 100 ms for full loop
-/**
- * @brief ACS readSensors() max execute time per cycle
- * 
- */
-#define MEASURE_TIME 20000 // 20 ms to measure
-/**
- * @brief ACS max actuation time per cycle
- * 
- */
-#define MAX_DETUMBLE_FIRING_TIME (DETUMBLE_TIME_STEP - MEASURE_TIME) // Max allowed detumble fire time
-/**
- * @brief Minimum magnetorquer firing time
- * 
- */
-#define MIN_DETUMBLE_FIRING_TIME 10000 // 10 ms
-/**
- * @brief Sunpointing magnetorquer PWM duty cycle
- * 
- */
-#define SUNPOINT_DUTY_CYCLE 20000 // 20 msec, in usec
-/**
- * @brief Course sun sensing mode loop time for ACS
- * 
- */
-#define COARSE_TIME_STEP DETUMBLE_TIME_STEP // 100 ms, in usec
-/**
- * @brief Coarse sun sensor minimum lux threshold for valid measurement
- * 
- */
-#ifdef SITL
-#define CSS_MIN_LUX_THRESHOLD 5000 * 0.5 // 5000 lux is max sun, half of that is our threshold (subject to change)
-#else
-#define CSS_MIN_LUX_THRESHOLD 5000 * 0.5 // 5000 lux is max sun, half of that is our threshold (subject to change)
-#endif                                   // SITL
-/**
- * @brief Acceptable leeway of the angular speed target
- * 
- */
-#define OMEGA_TARGET_LEEWAY z_g_W_target * 0.1 // 10% leeway in the value of omega_z
-/**
- * @brief Sunpointing angle target (in degrees)
- * 
- */
-#define MIN_SOL_ANGLE 4 // minimum solar angle for sunpointing to be a success
-/**
- * @brief Detumble angle target (in degrees)
- * 
- */
-#define MIN_DETUMBLE_ANGLE 4 // minimum angle for detumble to be a success
-
+#include <acs_core.h>   // control law context, input and command types
+#include <acs_clock.h>  // clock backend for the actuation
 /**
  * @brief Initializes the devices required to run the attitude control system.
  * 
@@ -101,12 +43,19 @@ void *acs_thread(void *id);
 void acs_destroy(void);
 
 /**
- * @brief Sorts the first array and reorders the second array according to the first array.
+ * @brief Executes a magnetorquer command calculated by acs_step() in the calling thread,
+ * using the event timeline of the command (acs_timeline_build()). Every switching of the
+ * torquers happens at an absolute time relative to the start of the actuation window, and
+ * the function blocks (or advances the virtual clock) until the end of the window,
+ * start + DETUMBLE_TIME_STEP - MEASURE_TIME. If the window started late, switching times
+ * already in the past are executed immediately, so the window is shortened instead of
+ * delaying the next cycle.
  * 
- * @param a1 Pointer to integer array to sort.
- * @param a2 Pointer to integer array to reorder.
+ * @param clk Clock used to time the firing
+ * @param cmd Command to execute
+ * @param start Start of the actuation window, in usec (see acs_sched_actuate())
  */
-void insertionSort(int a1[], int a2[]);
+void acs_actuate(acs_clock *clk, const acs_cmd *cmd, uint64_t start);
 
 /**
  * @brief Fire magnetorquer in the direction dictated by the input vector.
@@ -136,39 +85,109 @@ int hbridge_enable(int x, int y, int z);
 int HBRIDGE_DISABLE(int num);
 
 /**
- * @brief Calculates \f$\omega\f$ using \f$\dot{\vec{B}}\f$ and stores in the circular buffer.
+ * @brief Reads the magnetometer (or the value received over serial in SITL) into
+ * the input structure for the control law, and the gyroscope of the LSM9DS1 if it is
+ * configured (not in SITL). The gyroscope samples queued in the FIFO since the last
+ * cycle are averaged into one reading. Has to be called with the torquers off.
+ * A failed read sets ACS_FAULT_MAG, and the magnetometer is re-initialized after
+ * ACS_FAULT_REINIT failures in a row. A failed gyroscope read sets ACS_FAULT_GYRO.
+ * Clears the soft faults of the input.
  * 
- * Calculates current angular speed. Requires current and previous measurements of \f$\dot{\vec{B}}\f$.
- * The calculated angular speed is put inside the global circular buffer. Sets W_full to indicate the
- * buffer becoming full the first time.
+ * @param in Pointer to the input structure to fill in
+ * @return int Status of the input, 1 (faults are flagged separately).
+ */
+int readMag(acs_input *in);
+
+/**
+ * @brief Number of failed reads in a row of a sensor after which the device is re-initialized.
  * 
  */
-void getOmega(void);
+#ifndef ACS_FAULT_REINIT
+#define ACS_FAULT_REINIT 5
+#endif
 
 /**
- * @brief Calculates sun vector using coarse sun sensor and fine sun sensor measurements.
- * Favors the fine sun sensor measurements if exists. The value is inserted into a circular
- * buffer.
+ * @brief Longest wait for the coarse sun sensor integrations, in usec, for which the
+ * integrations are restarted and waited for at every acquisition. Sensors integrating
+ * longer run free and the latest completed integration is read. Either way the nine
+ * sensors integrate concurrently, so an acquisition takes at most one integration time
+ * plus the bus time, independent of the number of sensors. The gain and integration time
+ * of every sensor follow its last reading (see tsl2561_autogain()) and are reported with
+ * every sun sample.
  * 
+ */
+#ifndef ACS_CSS_RESTART_MAX
+#define ACS_CSS_RESTART_MAX (TSL2561_DELAY_INTTIME_13MS * 1000)
+#endif
+
+/**
+ * @brief Calibration gains of the nine coarse sun sensors, their lux values are multiplied
+ * by them (folded into the lux conversion tables, see tsl2561_lux_table_init()). Set from
+ * the calibration of the sensors against the reference lamp (calibration/css.py).
  * 
  */
-void getSVec(void);
+#ifndef CSS_LUX_GAINS
+#define CSS_LUX_GAINS {1, 1, 1, 1, 1, 1, 1, 1, 1}
+#endif
 
 /**
- * @brief Reads hardware sensors and puts the values in the global storage, upon which
- * calls the getOmega() and getSVec() functions to calculate angular speed and sun vector.
+ * @brief GPIO chip and line the interrupt outputs of the coarse sun sensors are wired to
+ * (open drain, wired together). Used with CSS_INT.
  * 
- * @return int Returns 1 for success, and -1 for error.
  */
-int readSensors(void);
+#ifndef CSS_INT_CHIP
+#define CSS_INT_CHIP "/dev/gpiochip0"
+#endif
+#ifndef CSS_INT_LINE
+#define CSS_INT_LINE 17
+#endif
 
 /**
- * @brief This function checks if the ACS should transition from one state to the other at
- * every iteration. The function executes only when the \f$\vec{\omega}\f$ and sun vector
- * buffers are full.
+ * @brief Lux value of a coarse sun sensor that ends the night with CSS_INT. While the ACS
+ * declares day, at least one sensor reads CSS_MIN_LUX_THRESHOLD / sqrt(3), so the interrupt
+ * fires before the readings would end the night.
  * 
  */
-void checkTransition(void);
+#ifndef ACS_CSS_WAKE_LUX
+#define ACS_CSS_WAKE_LUX (CSS_MIN_LUX_THRESHOLD / 2)
+#endif
+
+/**
+ * @brief Integrations in a row above ACS_CSS_WAKE_LUX before a coarse sun sensor interrupts
+ * (TSL2561 persistence, 1 to 15), rejects glints.
+ * 
+ */
+#ifndef ACS_CSS_WAKE_PERSIST
+#define ACS_CSS_WAKE_PERSIST 2
+#endif
+
+/**
+ * @brief Zero rate level of the gyroscope measured on the ground, in LSB at 245 dps,
+ * subtracted from every reading. What is left of the bias is estimated by builds with ACS_EKF.
+ * 
+ */
+#ifndef ACS_GYRO_OFFSET_X
+#define ACS_GYRO_OFFSET_X 0
+#endif
+#ifndef ACS_GYRO_OFFSET_Y
+#define ACS_GYRO_OFFSET_Y 0
+#endif
+#ifndef ACS_GYRO_OFFSET_Z
+#define ACS_GYRO_OFFSET_Z 0
+#endif
+
+/**
+ * @brief Reads the coarse and fine sun sensors (or the values received over serial in SITL)
+ * into the input structure for the control law. Called by the acquisition thread, can run
+ * while the torquers fire. A coarse sun sensor that fails to read keeps its last reading
+ * and sets ACS_FAULT_CSS, and is re-initialized after ACS_FAULT_REINIT failures in a row.
+ * 
+ * @param in Pointer to the input structure to fill in
+ * @param read_css Read the coarse sun sensors, 0 leaves the coarse sun sensor readings of the input unchanged
+ * @return int Status of the input, 1 (faults are flagged separately).
+ */
+int readSun(acs_input *in, int read_css);
+
 #ifndef I2C_BUS
 /**
  * @brief I2C Bus device file used for ACS sensors
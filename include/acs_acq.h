@@ -0,0 +1,91 @@
+/**
+ * @file acs_acq.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Sun sensor acquisition stage of the Attitude Control System. The slow sun
+ * sensor readings are taken by the acquisition thread while the torquers fire, and
+ * handed to the ACS thread through a lock-free triple buffer.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef ACS_ACQ_H
+#define ACS_ACQ_H
+#include <acs_core.h> // DETUMBLE_TIME_STEP
+#include <stdint.h>
+
+/**
+ * @brief Age beyond which a sun sample is not used by the ACS, in usec.
+ *
+ */
+#ifndef ACS_ACQ_MAX_AGE
+#define ACS_ACQ_MAX_AGE (2 * DETUMBLE_TIME_STEP)
+#endif
+
+/**
+ * @brief Timestamped sun sensor readings.
+ *
+ */
+typedef struct
+{
+    uint64_t t;            ///< Time at which the acquisition started, in usec
+    uint64_t seq;          ///< Sequence number of the sample, starts at 1
+    int status;            ///< Acquisition status, negative indicates the readings are invalid
+    int fault;             ///< Soft faults of the readings, flags of ACS_FAULT
+    float CSS[9];          ///< Coarse sun sensor lux values
+    uint8_t CSS_timing[9]; ///< Gain and integration time of the CSS values, see acs_input
+    float FSS[2];          ///< Fine sun sensor angles
+} acs_sun_sample;
+
+/**
+ * @brief Single producer, single consumer triple buffer. The producer always has a buffer
+ * to write to and the consumer always gets the freshest complete sample; neither blocks
+ * the other. Has to be initialized with acs_tbuf_init().
+ *
+ */
+typedef struct
+{
+    acs_sun_sample buf[3]; ///< Back, middle and front buffers, in an order that changes
+    uint8_t middle;        ///< Index of the middle buffer, with ACS_TBUF_FRESH set when it holds an unread sample; accessed atomically
+    uint8_t back;          ///< Index of the buffer owned by the producer
+    uint8_t front;         ///< Index of the buffer owned by the consumer
+} acs_tbuf;
+
+/**
+ * @brief Flag in acs_tbuf::middle marking an unread sample.
+ *
+ */
+#define ACS_TBUF_FRESH 0x4
+
+/**
+ * @brief Initializes an empty triple buffer.
+ *
+ * @param tb Pointer to the buffer
+ */
+void acs_tbuf_init(acs_tbuf *tb);
+
+/**
+ * @brief Returns the buffer the producer writes the next sample to.
+ *
+ * @param tb Pointer to the buffer
+ * @return acs_sun_sample* Sample to fill in before acs_tbuf_publish()
+ */
+acs_sun_sample *acs_tbuf_back(acs_tbuf *tb);
+
+/**
+ * @brief Publishes the sample written to acs_tbuf_back(), replacing an unread older sample.
+ *
+ * @param tb Pointer to the buffer
+ */
+void acs_tbuf_publish(acs_tbuf *tb);
+
+/**
+ * @brief Takes the freshest published sample.
+ *
+ * @param tb Pointer to the buffer
+ * @param fresh Set to 1 if the sample was published after the last call, 0 otherwise (can be NULL)
+ * @return const acs_sun_sample* Freshest sample, valid until the next call. Has sequence number 0 if nothing was published yet.
+ */
+const acs_sun_sample *acs_tbuf_read(acs_tbuf *tb, int *fresh);
+#endif // ACS_ACQ_H
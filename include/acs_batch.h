@@ -0,0 +1,120 @@
+/**
+ * @file acs_batch.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Structure-of-arrays variant of the ACS control law math, which evaluates
+ * ACS_BATCH_LANES independent contexts at once using the SIMD unit of the target
+ * (SSE/AVX2 on x86, NEON on aarch64) through GCC vector extensions.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef ACS_BATCH_H
+#define ACS_BATCH_H
+#include <acs_core.h>
+#include <stdint.h>
+
+/**
+ * @brief Number of contexts evaluated at once. 8 fills one AVX2 register with floats,
+ * and two SSE or NEON registers. Has to be a power of two.
+ *
+ */
+#ifndef ACS_BATCH_LANES
+#define ACS_BATCH_LANES 8
+#endif
+
+/**
+ * @brief One float per lane.
+ *
+ */
+typedef float acs_vf __attribute__((vector_size(ACS_BATCH_LANES * sizeof(float))));
+/**
+ * @brief One double per lane.
+ *
+ */
+typedef double acs_vd __attribute__((vector_size(ACS_BATCH_LANES * sizeof(double))));
+/**
+ * @brief One 32-bit integer per lane, also the mask type of float comparisons.
+ *
+ */
+typedef int32_t acs_vi __attribute__((vector_size(ACS_BATCH_LANES * sizeof(int32_t))));
+
+/**
+ * @brief Inputs of the control law for ACS_BATCH_LANES contexts, in structure-of-arrays layout.
+ * Each member holds the current value of the corresponding context buffer for every lane.
+ * Dynamically allocated batches have to be aligned to _Alignof(acs_batch).
+ *
+ */
+typedef struct
+{
+    DECLARE_VECTOR2(B, acs_vd);        ///< Current (filtered) magnetic field
+    DECLARE_VECTOR2(Bt0, acs_vd);      ///< Previous \f$\dot{\vec{B}}\f$
+    DECLARE_VECTOR2(Bt1, acs_vd);      ///< Current \f$\dot{\vec{B}}\f$
+    acs_vf Bt_rate;                    ///< Rate between the previous and current \f$\dot{\vec{B}}\f$ (acs_rate()), in Hz
+    DECLARE_VECTOR2(W, acs_vf);        ///< Current angular speed
+    DECLARE_VECTOR2(S, acs_vf);        ///< Current sun vector
+    DECLARE_VECTOR2(L_target, acs_vf); ///< Target angular momentum
+    acs_vf MOI[3][3];                  ///< Moment of inertia
+} acs_batch;
+
+/**
+ * @brief Outputs of the batched command calculation, in structure-of-arrays layout.
+ *
+ */
+typedef struct
+{
+    DECLARE_VECTOR2(fire, acs_vi);      ///< Firing direction per axis (-1, 0 or +1)
+    DECLARE_VECTOR2(firingCmd, acs_vi); ///< Detumble firing time per axis, in usec
+    acs_vi time_on;                     ///< Sunpoint on time per SUNPOINT_DUTY_CYCLE, in usec
+} acs_batch_cmd;
+
+/**
+ * @brief Loads the current buffer values and parameters of a context into a lane.
+ * Buffers with a negative index are loaded as zero.
+ *
+ * @param b Pointer to the batch
+ * @param lane Lane to load into, 0 ... ACS_BATCH_LANES - 1
+ * @param ctx Pointer to the context
+ */
+void acs_batch_load(acs_batch *b, int lane, const acs_ctx *ctx);
+
+/**
+ * @brief Calculates the unfiltered angular speed from the current and previous
+ * \f$\dot{\vec{B}}\f$ of every lane and stores it in the W member of the batch.
+ * Bit-identical to the value getOmega() puts in the buffer before the Bessel filter;
+ * lanes where it is not finite keep the W they were loaded with.
+ *
+ * @param b Pointer to the batch
+ */
+void acs_batch_omega(acs_batch *b);
+
+/**
+ * @brief Calculates the detumble command of every lane. Bit-identical to detumbleCommand().
+ *
+ * @param b Pointer to the batch
+ * @param cmd Fills in fire and firingCmd
+ */
+void acs_batch_detumble(const acs_batch *b, acs_batch_cmd *cmd);
+
+/**
+ * @brief Calculates the sunpointing command of every lane. Bit-identical to sunpointCommand().
+ *
+ * @param b Pointer to the batch
+ * @param cmd Fills in z_fire and time_on
+ */
+void acs_batch_sunpoint(const acs_batch *b, acs_batch_cmd *cmd);
+
+/**
+ * @brief Executes one cycle of the control law on n independent contexts. Equivalent to
+ * calling acs_step() on every context, with the detumble and sunpointing commands
+ * calculated ACS_BATCH_LANES contexts at a time.
+ *
+ * @param ctx Array of n pointers to contexts
+ * @param in Array of n sensor readings
+ * @param now Array of n timestamps, in usec
+ * @param cmd Array of n commands to fill in
+ * @param n Number of contexts
+ */
+void acs_step_batch(acs_ctx *ctx[], const acs_input in[], const uint64_t now[], acs_cmd cmd[], int n);
+#endif // ACS_BATCH_H
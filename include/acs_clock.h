@@ -0,0 +1,69 @@
+/**
+ * @file acs_clock.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Clock and sleep backends for the Attitude Control System loop.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef ACS_CLOCK_H
+#define ACS_CLOCK_H
+#include <stdint.h>
+/**
+ * @brief Available clock backends.
+ *
+ */
+typedef enum
+{
+    ACS_CLOCK_WALL,   ///< Time is read from the monotonic time source (see sh_time.h), sleeps block the thread until an absolute time
+    ACS_CLOCK_VIRTUAL ///< Time is a counter, sleeps advance the counter and return immediately
+} ACS_CLOCK_TYPE;
+
+/**
+ * @brief Clock used by the ACS loop to timestamp readings and time the actuation.
+ *
+ */
+typedef struct
+{
+    uint8_t type; ///< One of ACS_CLOCK_TYPE
+    uint64_t t;   ///< Current time of the virtual clock, in usec
+} acs_clock;
+
+/**
+ * @brief Initializes a clock.
+ *
+ * @param clk Pointer to the clock
+ * @param type One of ACS_CLOCK_TYPE
+ * @param start Start time of the virtual clock in usec, ignored by the wall clock
+ */
+void acs_clock_init(acs_clock *clk, uint8_t type, uint64_t start);
+
+/**
+ * @brief Returns the current time of the clock.
+ *
+ * @param clk Pointer to the clock
+ * @return uint64_t Current time, in usec
+ */
+uint64_t acs_clock_now(acs_clock *clk);
+
+/**
+ * @brief Sleeps for the given amount of time. The virtual clock advances by
+ * the given amount and returns immediately.
+ *
+ * @param clk Pointer to the clock
+ * @param usec Time to sleep, in usec
+ */
+void acs_clock_sleep(acs_clock *clk, uint64_t usec);
+
+/**
+ * @brief Sleeps until the clock reaches the given time. Returns immediately
+ * if the time is in the past. The wall clock sleeps with an absolute deadline,
+ * so that wake up latency and interruptions do not accumulate.
+ *
+ * @param clk Pointer to the clock
+ * @param t Time to wake up at, in usec
+ */
+void acs_clock_sleep_until(acs_clock *clk, uint64_t t);
+#endif // ACS_CLOCK_H
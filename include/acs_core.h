@@ -0,0 +1,415 @@
+/**
+ * @file acs_core.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Re-entrant Attitude Control System control law. All state of the control
+ * law lives in an acs_ctx, so that several instances can run in one process.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#ifndef ACS_CORE_H
+#define ACS_CORE_H
+#include <stdint.h>
+#include <acs_extern.h> // will define SH_BUFFER_SIZE
+#include <bessel.h>     // Bessel filter taps and histories
+#include <acs_ekf.h>    // Kalman filter of the angular speed
+#include <macros.h>     // vector macros
+#include <main.h>       // ACS states
+/**
+ * @brief Dipole moment of the magnetorquer rods
+ * 
+ */
+#define DIPOLE_MOMENT 0.22 // A m^-2
+/**
+ * @brief ACS loop time period
+ * 
+ */
+#define DETUMBLE_TIME_STEP 100000 // 100 ms for full loop
+/**
+ * @brief ACS measurement (readMag()) and control law max execute time per cycle
+ * 
+ */
+#define MEASURE_TIME 20000 // 20 ms to measure
+/**
+ * @brief ACS max actuation time per cycle
+ * 
+ */
+#define MAX_DETUMBLE_FIRING_TIME (DETUMBLE_TIME_STEP - MEASURE_TIME) // Max allowed detumble fire time
+/**
+ * @brief Minimum magnetorquer firing time
+ * 
+ */
+#define MIN_DETUMBLE_FIRING_TIME 10000 // 10 ms
+/**
+ * @brief Sunpointing magnetorquer PWM duty cycle
+ * 
+ */
+#define SUNPOINT_DUTY_CYCLE 20000 // 20 msec, in usec
+/**
+ * @brief Course sun sensing mode loop time for ACS
+ * 
+ */
+#define COARSE_TIME_STEP DETUMBLE_TIME_STEP // 100 ms, in usec
+/**
+ * @brief Coarse sun sensor minimum lux threshold for valid measurement
+ * 
+ */
+#ifdef SITL
+#define CSS_MIN_LUX_THRESHOLD 5000 * 0.5 // 5000 lux is max sun, half of that is our threshold (subject to change)
+#else
+#define CSS_MIN_LUX_THRESHOLD 5000 * 0.5 // 5000 lux is max sun, half of that is our threshold (subject to change)
+#endif                                   // SITL
+/**
+ * @brief Acceptable leeway of the angular speed target
+ * 
+ */
+#define OMEGA_TARGET_LEEWAY z_W_target * 0.1 // 10% leeway in the value of omega_z
+/**
+ * @brief Sunpointing angle target (in degrees)
+ * 
+ */
+#define MIN_SOL_ANGLE 4 // minimum solar angle for sunpointing to be a success
+/**
+ * @brief Detumble angle target (in degrees)
+ * 
+ */
+#define MIN_DETUMBLE_ANGLE 4 // minimum angle for detumble to be a success
+
+/**
+ * @brief Number of consecutive cycles without a magnetometer reading after which the
+ * buffers are flushed.
+ * 
+ */
+#ifndef ACS_FAULT_MAG_LIMIT
+#define ACS_FAULT_MAG_LIMIT 3
+#endif
+
+/**
+ * @brief Standard deviation of the noise of one gyroscope reading, in rad/s. Set for a single
+ * LSM9DS1 sample at 245 dps; readings averaged over the FIFO of a cycle are less noisy.
+ * 
+ */
+#ifndef ACS_GYRO_NOISE
+#define ACS_GYRO_NOISE 0.002
+#endif
+
+/**
+ * @brief Soft sensor faults of an ACS cycle, flags of acs_input::fault. A soft fault
+ * costs at most the affected samples, unlike a hard fault (negative acs_input::status)
+ * which flushes every buffer of the context.
+ * 
+ */
+typedef enum
+{
+    ACS_FAULT_MAG = 0x1, ///< Magnetometer reading missing: the sample of the cycle is invalidated, becomes hard after ACS_FAULT_MAG_LIMIT cycles in a row
+    ACS_FAULT_CSS = 0x2, ///< Coarse sun sensor readings missing: held at their last values by the acquisition stage
+    ACS_FAULT_FSS = 0x4, ///< Fine sun sensor reading missing: reads out of the field of view, the coarse sun sensors are used
+    ACS_FAULT_GYRO = 0x8 ///< Gyroscope reading missing: the angular speed of the cycle is estimated from the magnetic field
+} ACS_FAULT;
+
+/**
+ * @brief Sensor readings for one ACS cycle, filled in by the acquisition stage (readMag() and readSun()).
+ * 
+ */
+typedef struct
+{
+    int status;                 ///< Acquisition status, negative indicates a hard fault and the readings are invalid
+    int fault;                  ///< Soft faults of the readings, flags of ACS_FAULT
+    DECLARE_VECTOR2(B, double); ///< Magnetic field, in milliGauss
+    uint64_t t_B;               ///< Time the magnetic field was read at, in usec on the ACS clock
+    int gyro;                   ///< 1 if G holds a gyroscope reading
+    DECLARE_VECTOR2(G, double); ///< Angular speed measured by the gyroscope, in rad/s
+    float CSS[9];               ///< Coarse sun sensor lux values
+    uint8_t CSS_timing[9];      ///< Gain and integration time the CSS values were read at (TSL2561 timing register), 0 in SITL
+    float FSS[2];               ///< Fine sun sensor angles (radians in SITL, degrees in HITL)
+} acs_input;
+
+/**
+ * @brief Type of actuation requested by acs_step().
+ * 
+ */
+typedef enum
+{
+    ACS_CMD_IDLE,     ///< Keep the torquers off for the actuation window
+    ACS_CMD_DETUMBLE, ///< Fire the torquers in direction fire for firingCmd usec per axis
+    ACS_CMD_SUNPOINT  ///< Fire the Z torquer for time_on usec every SUNPOINT_DUTY_CYCLE
+} ACS_CMD_TYPE;
+
+/**
+ * @brief Magnetorquer command generated by one ACS cycle.
+ * 
+ */
+typedef struct
+{
+    uint8_t type;                    ///< One of ACS_CMD_TYPE
+    int status;                      ///< Status of the cycle, negative indicates the buffers were flushed
+    DECLARE_VECTOR2(fire, int8_t);   ///< Firing direction per axis (-1, 0 or +1)
+    DECLARE_VECTOR2(firingCmd, int); ///< Detumble firing time per axis, in usec
+    int time_on;                     ///< Sunpoint on time per SUNPOINT_DUTY_CYCLE, in usec
+} acs_cmd;
+
+/**
+ * @brief Source of the sun vector calculated in the last cycle, used for status printing.
+ * 
+ */
+typedef enum
+{
+    ACS_SUN_NONE,  ///< Sun vector was not calculated
+    ACS_SUN_FSS,   ///< Sun vector from fine sun sensor
+    ACS_SUN_CSS,   ///< Sun vector from coarse sun sensors
+    ACS_SUN_NIGHT  ///< Coarse sun sensors are below CSS_MIN_LUX_THRESHOLD
+} ACS_SUN_SOURCE;
+
+/**
+ * @brief Returns the sample rate between two measurement times, in Hz. Falls back to
+ * the nominal rate 1 / DETUMBLE_TIME_STEP if the times are not increasing.
+ * 
+ * @param t0 Time of the earlier measurement, in usec
+ * @param t1 Time of the later measurement, in usec
+ * @return double Sample rate, in Hz
+ */
+static inline double acs_rate(uint64_t t0, uint64_t t1)
+{
+    return 1e6 / (double)(t1 > t0 ? t1 - t0 : DETUMBLE_TIME_STEP);
+}
+
+/**
+ * @brief Attitude Control System context. Holds the circular buffers, indices,
+ * system state and parameters of one instance of the control law.
+ * 
+ */
+typedef struct
+{
+    DECLARE_BUFFER(B, double);         ///< \f$\vec{B}\f$ circular buffer
+    DECLARE_BUFFER(Bt, double);        ///< \f$\vec{\dot{B}}\f$ circular buffer
+    DECLARE_BUFFER(W, float);          ///< \f$\vec{\omega}\f$ circular buffer
+    DECLARE_BUFFER(S, float);          ///< Sun vector circular buffer
+    uint64_t t_B[SH_BUFFER_SIZE];      ///< Measurement times of the \f$\vec{B}\f$ buffer, in usec
+    uint64_t t_Bt[SH_BUFFER_SIZE];     ///< Times of the \f$\vec{\dot{B}}\f$ buffer (midpoint of the two measurements), in usec
+    DECLARE_VECTOR2(L_target, float);  ///< Target angular momentum
+    DECLARE_VECTOR2(W_target, float);  ///< Target angular speed
+    float CSS[9];                      ///< Current coarse sun sensor lux values
+    float FSS[2];                      ///< Current fine sun sensor angles
+    DECLARE_VECTOR2(G, float);         ///< Current gyroscope reading, in rad/s
+    int gyro;                          ///< Set if G holds a reading of the current cycle
+    int mag_index;                     ///< Current index of the \f$\vec{B}\f$ buffer, -1 indicates empty buffer
+    int bdot_index;                    ///< Current index of the \f$\vec{\dot{B}}\f$ buffer
+    int omega_index;                   ///< Current index of the \f$\vec{\omega}\f$ buffer
+    int sol_index;                     ///< Current index of the sun vector buffer
+    int B_full;                        ///< Indicates if the \f$\vec{B}\f$ buffer is full
+    int W_full;                        ///< Indicates if the \f$\vec{\omega}\f$ buffer is full
+    int S_full;                        ///< Indicates if the sun vector buffer is full
+    uint8_t night;                     ///< Set by getSVec() if the satellite does not detect the sun
+    uint8_t mode;                      ///< Current ACS state, one of SH_ACS_MODES
+    uint8_t first_detumble;            ///< Unset when the system is detumbled for the first time after a power cycle
+    uint8_t sun_source;                ///< Source of the last sun vector, one of ACS_SUN_SOURCE
+    int mag_faults;                    ///< Number of consecutive cycles without a magnetometer reading
+    unsigned long long soft_faults;    ///< Number of cycles with a soft sensor fault
+    unsigned long long hard_faults;    ///< Number of cycles with a hard sensor fault (buffers flushed)
+    float MOI[3][3];                   ///< Moment of inertia of the satellite (SI)
+    float IMOI[3][3];                  ///< Inverse of the moment of inertia of the satellite (SI)
+#ifndef BESSEL_IIR
+    float bessel_coeff[SH_BUFFER_SIZE]; ///< Bessel filter coefficients
+#endif
+    bessel_filter filter;              ///< Bessel filter (normalized taps, or IIR sections with BESSEL_IIR)
+    bessel_dstate B_hist;              ///< Filter state (history) of the \f$\vec{B}\f$ buffer
+    bessel_dstate Bt_hist;             ///< Filter state (history) of the \f$\vec{\dot{B}}\f$ buffer
+    bessel_fstate W_hist;              ///< Filter state (history) of the \f$\vec{\omega}\f$ buffer
+#ifdef ACS_EKF
+    acs_ekf ekf;                       ///< Kalman filter of the angular speed
+#endif
+    unsigned long long step;           ///< Number of cycles executed
+    uint64_t t_acs;                    ///< Timestamp of the last cycle, in usec
+} acs_ctx;
+
+/**
+ * @brief Default moment of inertia of the satellite (SI).
+ * 
+ */
+extern const float acs_default_MOI[3][3];
+
+/**
+ * @brief Default inverse of the moment of inertia of the satellite (SI).
+ * 
+ */
+extern const float acs_default_IMOI[3][3];
+
+/**
+ * @brief Initializes an ACS context with empty buffers, the default moment of inertia,
+ * Bessel coefficients and the target angular speed of 1 rad/s about Z. The target
+ * angular momentum is calculated from MOI, so callers that change MOI have to call
+ * acs_ctx_set_target() afterwards.
+ * 
+ * @param ctx Pointer to the context to initialize
+ */
+void acs_ctx_init(acs_ctx *ctx);
+
+/**
+ * @brief Sets the target angular speed of the context and updates the target angular momentum
+ * using the MOI stored in the context.
+ * 
+ * @param ctx Pointer to the context
+ * @param wx Target angular speed about X (rad/s)
+ * @param wy Target angular speed about Y (rad/s)
+ * @param wz Target angular speed about Z (rad/s)
+ */
+void acs_ctx_set_target(acs_ctx *ctx, float wx, float wy, float wz);
+
+/**
+ * @brief Recalculates the Bessel filter of the context (BESSEL_ORDER) for a cutoff frequency.
+ * Builds with BESSEL_IIR design the IIR filter instead of the coefficients and taps.
+ * 
+ * @param ctx Pointer to the context
+ * @param freq_cutoff Cut-off frequency of the Bessel filter, see BESSEL_FREQ_CUTOFF
+ */
+void acs_ctx_set_cutoff(acs_ctx *ctx, float freq_cutoff);
+
+/**
+ * @brief Flushes all circular buffers of the context, resets the indices and
+ * falls back to night mode, which is the safe mode.
+ * 
+ * @param ctx Pointer to the context
+ */
+void acs_ctx_flush(acs_ctx *ctx);
+
+/**
+ * @brief Calculates \f$\omega\f$ using \f$\dot{\vec{B}}\f$ and stores in the circular buffer.
+ * 
+ * Calculates current angular speed. Requires current and previous measurements of \f$\dot{\vec{B}}\f$,
+ * and divides by the measured time between them (t_Bt) instead of assuming DETUMBLE_TIME_STEP.
+ * A gyroscope reading of the cycle is taken as the angular speed instead, from the first sample
+ * and whatever the direction of the field, without the Bessel filter. Builds with ACS_EKF take the angular speed estimated by the Kalman filter of the context
+ * (see acs_ekf.h) instead, without the Bessel filter.
+ * The calculated angular speed is put inside the circular buffer of the context. Sets W_full to indicate the
+ * buffer becoming full the first time.
+ * 
+ * @param ctx Pointer to the context
+ */
+void getOmega(acs_ctx *ctx);
+
+/**
+ * @brief Calculates sun vector using coarse sun sensor and fine sun sensor measurements.
+ * Favors the fine sun sensor measurements if exists. The value is inserted into a circular
+ * buffer.
+ * 
+ * @param ctx Pointer to the context
+ */
+void getSVec(acs_ctx *ctx);
+
+/**
+ * @brief Puts the sensor readings into the circular buffers of the context, upon which
+ * calls the getOmega() and getSVec() functions to calculate angular speed and sun vector.
+ * 
+ * Soft faults are recovered in place: without a magnetometer reading the cycle adds no
+ * sample and the next derivatives span the gap; without a gyroscope reading the angular
+ * speed is estimated from the magnetic field; a NaN sun vector holds the
+ * last sun vector, a NaN angular speed holds the last angular speed (see getOmega()).
+ * A hard fault, a NaN magnetic field or ACS_FAULT_MAG_LIMIT missing magnetometer
+ * readings in a row return -1, upon which the caller flushes the buffers.
+ * 
+ * @param ctx Pointer to the context
+ * @param in Sensor readings for the current cycle
+ * @return int Returns 1 for success, 0 if the cycle added no sample, and -1 for error.
+ */
+int processSensors(acs_ctx *ctx, const acs_input *in);
+
+/**
+ * @brief This function checks if the ACS should transition from one state to the other at
+ * every iteration. The function executes only when the \f$\vec{\omega}\f$ and sun vector
+ * buffers are full.
+ * 
+ * @param ctx Pointer to the context
+ */
+void checkTransition(acs_ctx *ctx);
+
+/**
+ * @brief This function calculates the detumble command.
+ * 
+ * The detumble algorithm calculates the direction and time
+ * for which the magnetorquers fire. The direction is determined
+ * by first calculating the vector \f$\hat{B}\times\hat{L_0 - L}\f$,
+ * which is a unit vector, and then checking which of the components have
+ * a magnitude greater than 0.01. A component with magnitude greater than
+ * 0.01 indicates that torquer can be fired, in the direction indicated by
+ * the sign of the component. Further, the torque that is generated by
+ * the firing decision is estimated for the current value of the magnetic
+ * field by calculating \f$\vec{\tau}=\vec{\mu}\times\vec{B}\f$, where
+ * \f$\vec{mu}\f$ is calculated by multiplying the firing direction vector
+ * with the dipole moment of the magnetorquers (0.21 A\f$\cdot\f$m\f$^2\f$).
+ * Then for each direction, the firing time is estimated by
+ * \f$ t_i = \frac{\Delta L_i}{\tau_i}\f$. The torquer in any direction is fired
+ * only if the firing time is greater than MIN_DETUMBLE_FIRING_TIME, and any
+ * torquer is fired for at most MAX_DETUMBLE_FIRING_TIME.
+ * 
+ * @param ctx Pointer to the context
+ * @param cmd Command to fill in
+ */
+void detumbleCommand(acs_ctx *ctx, acs_cmd *cmd);
+
+/**
+ * @brief This function calculates the sunpointing command.
+ * 
+ * The sunpointing algoritm calculates the duty cycle of the
+ * Z-magnetorquer firing. The duty cycle is determined by calculating
+ * the vector \f$(\hat{S}(\hat{S}\cdot\hat{B}))\times((\hat{L}(\hat{L}\cdot\hat{B}))\f$.
+ * The Z component of this vector upon normalization specifies the duty
+ * cycle. However, due to lowering of efficiency as the spacecraft aligns
+ * with the sun, the gain is increased.
+ * 
+ * @param ctx Pointer to the context
+ * @param cmd Command to fill in
+ */
+void sunpointCommand(acs_ctx *ctx, acs_cmd *cmd);
+
+/**
+ * @brief Processes the sensor readings of a cycle and flushes the buffers on error,
+ * i.e. acs_update() without checkTransition(). The command is initialized to
+ * ACS_CMD_IDLE with the status of the cycle.
+ * 
+ * @param ctx Pointer to the context
+ * @param in Sensor readings for the current cycle
+ * @param now Timestamp of the readings, in usec
+ * @param cmd Command to initialize
+ */
+void acs_estimate(acs_ctx *ctx, const acs_input *in, uint64_t now, acs_cmd *cmd);
+
+/**
+ * @brief Fills in the command for the current state with detumbleCommand() or
+ * sunpointCommand(), i.e. the second half of acs_step(). Cycles that added no sample
+ * (status 0) stay idle.
+ * 
+ * @param ctx Pointer to the context
+ * @param cmd Command initialized by acs_update()
+ */
+void acs_command(acs_ctx *ctx, acs_cmd *cmd);
+
+/**
+ * @brief Executes the first half of acs_step(): processes the sensor readings, flushes
+ * the buffers on error and checks for state transitions. The command is initialized
+ * to ACS_CMD_IDLE with the status of the cycle, and is filled in by detumbleCommand()
+ * or sunpointCommand() according to the new state.
+ * 
+ * @param ctx Pointer to the context
+ * @param in Sensor readings for the current cycle
+ * @param now Timestamp of the readings, in usec
+ * @param cmd Command to initialize
+ */
+void acs_update(acs_ctx *ctx, const acs_input *in, uint64_t now, acs_cmd *cmd);
+
+/**
+ * @brief Executes one cycle of the control law.
+ * 
+ * Processes the sensor readings, flushes the buffers on error, checks for state
+ * transitions and calculates the magnetorquer command for the new state. Touches
+ * no state outside of the context and performs no I/O, so the caller is responsible
+ * for executing the returned command.
+ * 
+ * @param ctx Pointer to the context
+ * @param in Sensor readings for the current cycle
+ * @param now Timestamp of the readings, in usec
+ * @return acs_cmd Magnetorquer command for the actuation window of this cycle
+ */
+acs_cmd acs_step(acs_ctx *ctx, const acs_input *in, uint64_t now);
+#endif // ACS_CORE_H
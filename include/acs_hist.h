@@ -0,0 +1,114 @@
+/**
+ * @file acs_hist.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Lock-free latency histograms with logarithmic buckets for the phases of the ACS cycle.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef ACS_HIST_H
+#define ACS_HIST_H
+#include <stdint.h>
+
+/**
+ * @brief Number of bits of precision of the buckets. Every power of two is split into
+ * 2^ACS_HIST_SUB_BITS buckets, so a bucket spans at most 1/2^ACS_HIST_SUB_BITS of its value.
+ *
+ */
+#ifndef ACS_HIST_SUB_BITS
+#define ACS_HIST_SUB_BITS 3
+#endif
+
+/**
+ * @brief Values at or above 2^ACS_HIST_MAX_BITS go into the last bucket.
+ *
+ */
+#ifndef ACS_HIST_MAX_BITS
+#define ACS_HIST_MAX_BITS 40
+#endif
+
+/**
+ * @brief Number of buckets of a histogram.
+ *
+ */
+#define ACS_HIST_BUCKETS ((ACS_HIST_MAX_BITS - ACS_HIST_SUB_BITS + 1) << ACS_HIST_SUB_BITS)
+
+/**
+ * @brief Latencies measured in the ACS cycle, in nanoseconds.
+ *
+ */
+typedef enum
+{
+    ACS_HIST_SENSE,      ///< Magnetometer read and merge of the sun sample (readMag(), mergeSun())
+    ACS_HIST_ESTIMATE,   ///< Sensor processing, getOmega() and getSVec() (acs_estimate())
+    ACS_HIST_TRANSITION, ///< State machine (checkTransition())
+    ACS_HIST_COMMAND,    ///< Torquer command of the control law (acs_command())
+    ACS_HIST_ACTUATE,    ///< Hand off of the actuation window to the torquer thread
+    ACS_HIST_SWITCH,     ///< Absolute switching error of the torquer events
+    ACS_HIST_PERIOD,     ///< Time between the starts of consecutive cycles
+    ACS_HIST_COUNT       ///< Number of histograms
+} ACS_HIST;
+
+/**
+ * @brief Histogram of non-negative values. A histogram has a single writer, and can be
+ * read by any thread at any time without locks; a reader sees every bucket either
+ * before or after a concurrent update.
+ *
+ */
+typedef struct
+{
+    uint32_t bucket[ACS_HIST_BUCKETS]; ///< Number of values in each bucket
+    uint64_t count;                    ///< Number of values
+    uint64_t max;                      ///< Largest value
+} acs_hist;
+
+/**
+ * @brief Clears a histogram.
+ *
+ * @param h Pointer to the histogram
+ */
+void acs_hist_init(acs_hist *h);
+
+/**
+ * @brief Adds a value to the histogram. Must only be called by the writer of the histogram.
+ *
+ * @param h Pointer to the histogram
+ * @param v Value
+ */
+void acs_hist_add(acs_hist *h, uint64_t v);
+
+/**
+ * @brief Returns the number of values in the histogram.
+ *
+ * @param h Pointer to the histogram
+ * @return uint64_t Number of values
+ */
+uint64_t acs_hist_count(const acs_hist *h);
+
+/**
+ * @brief Returns the largest value in the histogram.
+ *
+ * @param h Pointer to the histogram
+ * @return uint64_t Largest value, 0 for an empty histogram
+ */
+uint64_t acs_hist_max(const acs_hist *h);
+
+/**
+ * @brief Returns the value below which the given percentage of the values falls, rounded
+ * up to the upper end of its bucket (but not above the largest value).
+ *
+ * @param h Pointer to the histogram
+ * @param p Percentile, from 0 to 100
+ * @return uint64_t Value at the percentile, 0 for an empty histogram
+ */
+uint64_t acs_hist_percentile(const acs_hist *h, double p);
+
+/**
+ * @brief Returns the time of the monotonic time source (sh_time_nsec()), for the latency measurements.
+ *
+ * @return uint64_t Time in nanoseconds
+ */
+uint64_t acs_hist_now(void);
+#endif // ACS_HIST_H
@@ -13,7 +13,11 @@
 #define ACS_IFACE_H
 #include <pthread.h>
 extern pthread_cond_t data_available; // wake up from lock to SIGINT
+extern pthread_cond_t torquer_ready;  // wake up from lock to SIGINT
+extern pthread_cond_t torquer_idle;   // wake up from lock to SIGINT
 int acs_init(void);                   // init function for module
 void acs_destroy(void);               // destroy function for module
 void *acs_thread(void *);             // exec function for module
+void *acs_torquer_thread(void *);     // exec function for the magnetorquer event timeline
+void *acs_acq_thread(void *);         // exec function for the sun sensor acquisition
 #endif                                // ACS_IFACE_H
\ No newline at end of file
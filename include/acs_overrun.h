@@ -0,0 +1,91 @@
+/**
+ * @file acs_overrun.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Degraded cycle policy of the Attitude Control System: decides what happens to the
+ * actuation window when the measurement overruns MEASURE_TIME, so that the control period
+ * stays DETUMBLE_TIME_STEP, and sheds the coarse sun sensor reads while the budget is tight.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef ACS_OVERRUN_H
+#define ACS_OVERRUN_H
+#include <acs_core.h>
+#include <acs_torquer.h>
+#include <stdint.h>
+
+/**
+ * @brief Shortest remainder of an actuation window that is still executed after an
+ * overrun, in usec. Shorter remainders are skipped.
+ *
+ */
+#ifndef ACS_OVERRUN_MIN_WINDOW
+#define ACS_OVERRUN_MIN_WINDOW MIN_DETUMBLE_FIRING_TIME
+#endif
+
+/**
+ * @brief Number of cycles after an overrun during which the coarse sun sensors are not read.
+ *
+ */
+#ifndef ACS_OVERRUN_HOLD
+#define ACS_OVERRUN_HOLD 10
+#endif
+
+/**
+ * @brief Outcome of the actuation window of a cycle.
+ *
+ */
+typedef enum
+{
+    ACS_WINDOW_FULL,    ///< Measurement done in time, the window is executed as commanded
+    ACS_WINDOW_SHRUNK,  ///< Measurement overran, the window starts late but ends on time
+    ACS_WINDOW_SKIPPED  ///< Measurement overran, too little of the window is left to be worth firing
+} ACS_WINDOW;
+
+/**
+ * @brief State and statistics of the degraded cycle policy. Written by the ACS thread,
+ * except css_dropped which is written by the acquisition thread.
+ *
+ */
+typedef struct
+{
+    uint64_t overruns;    ///< Number of cycles where the measurement overran the start of the actuation window
+    uint64_t shrunk;      ///< Number of actuation windows shortened
+    uint64_t skipped;     ///< Number of actuation windows skipped
+    uint64_t css_dropped; ///< Number of sun samples taken without the coarse sun sensors
+    int hold;             ///< Cycles left without coarse sun sensor reads; accessed atomically
+} acs_overrun;
+
+/**
+ * @brief Clears the policy state.
+ *
+ * @param o Pointer to the policy state
+ */
+void acs_overrun_init(acs_overrun *o);
+
+/**
+ * @brief Decides the actuation window of a cycle once the command is known, and applies
+ * the decision to its timeline. A shrunk window has every event due before now merged
+ * into one event at now (see acs_timeline_clip()); a skipped window is emptied, the
+ * torquers stay off from the previous window. An overrun starts ACS_OVERRUN_HOLD cycles
+ * without coarse sun sensor reads, every cycle in time counts one down.
+ *
+ * @param o Pointer to the policy state
+ * @param now Current time, in usec
+ * @param tl Timeline of the actuation window, starting at its deadline
+ * @param start Start of the actuation window, in usec
+ * @return ACS_WINDOW Outcome of the window
+ */
+ACS_WINDOW acs_overrun_window(acs_overrun *o, uint64_t now, acs_timeline *tl, uint64_t start);
+
+/**
+ * @brief Decides if the acquisition thread reads the coarse sun sensors for the next sample.
+ * Must only be called by the acquisition thread.
+ *
+ * @param o Pointer to the policy state
+ * @return int 1 to read the coarse sun sensors, 0 to keep the previous readings
+ */
+int acs_overrun_read_css(acs_overrun *o);
+#endif // ACS_OVERRUN_H
@@ -0,0 +1,37 @@
+/**
+ * @file acs_record.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Recording of ACS sensor inputs and commands for replay.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#ifndef ACS_RECORD_H
+#define ACS_RECORD_H
+#include <stdio.h>
+#include <acs_core.h>
+/**
+ * @brief Writes one ACS cycle (timestamp, sensor input and resulting command) to the record file.
+ * Floating point values are written in hexadecimal notation so that a replay sees the exact same bits.
+ * 
+ * @param fp Record file
+ * @param t Timestamp passed to acs_step(), in usec (acs_input::t_B on the flight software)
+ * @param in Sensor input passed to acs_step()
+ * @param cmd Command returned by acs_step()
+ * @return int Number of characters written, negative on error (see fprintf())
+ */
+int acs_record_write(FILE *fp, uint64_t t, const acs_input *in, const acs_cmd *cmd);
+
+/**
+ * @brief Reads one ACS cycle written by acs_record_write().
+ * 
+ * @param fp Record file
+ * @param t Timestamp of the cycle, in usec
+ * @param in Sensor input of the cycle
+ * @param cmd Command that was calculated in the recorded run
+ * @return int 1 on success, 0 at end of file, -1 on malformed record
+ */
+int acs_record_read(FILE *fp, uint64_t *t, acs_input *in, acs_cmd *cmd);
+#endif // ACS_RECORD_H
@@ -0,0 +1,122 @@
+/**
+ * @file acs_sched.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Periodic scheduler with absolute deadlines for the Attitude Control System loop.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef ACS_SCHED_H
+#define ACS_SCHED_H
+#include <acs_clock.h>
+#include <stdint.h>
+
+/**
+ * @brief Lateness beyond which a phase counts as having missed its deadline, in usec.
+ * Covers the usual wake up latency of the operating system.
+ *
+ */
+#ifndef ACS_SCHED_TOLERANCE
+#define ACS_SCHED_TOLERANCE 1000
+#endif
+
+/**
+ * @brief Phases of a control cycle. Every phase has a deadline relative to the
+ * start of the cycle, and the lateness of each phase is measured against it.
+ *
+ */
+typedef enum
+{
+    ACS_PHASE_MEASURE, ///< Sensors are read; starts at the start of the cycle
+    ACS_PHASE_DECIDE,  ///< Control law is evaluated; has to finish MEASURE_TIME after the start of the cycle
+    ACS_PHASE_ACTUATE, ///< Torquers are driven; starts MEASURE_TIME after the start of the cycle
+    ACS_PHASE_COUNT    ///< Number of phases
+} ACS_PHASE;
+
+/**
+ * @brief Lateness statistics of a phase, in usec. Negative lateness is slack.
+ *
+ */
+typedef struct
+{
+    int64_t last;   ///< Lateness of the last deadline
+    int64_t max;    ///< Maximum lateness
+    int64_t sum;    ///< Sum of lateness, for the mean
+    uint64_t count; ///< Number of deadlines
+    uint64_t late;  ///< Number of deadlines missed by more than the tolerance
+} acs_lateness;
+
+/**
+ * @brief Adds the lateness of a deadline to the statistics.
+ *
+ * @param l Pointer to the statistics
+ * @param late Lateness, in usec
+ * @param tolerance Lateness beyond which the deadline counts as missed, in usec
+ */
+void acs_lateness_add(acs_lateness *l, int64_t late, int64_t tolerance);
+
+/**
+ * @brief Periodic scheduler of the ACS loop. Cycles start at absolute times
+ * t0 + n * period on the clock, so that the time the loop takes does not
+ * accumulate into drift.
+ *
+ */
+typedef struct
+{
+    acs_clock *clk;                          ///< Clock the deadlines are on
+    uint64_t period;                         ///< Control period, in usec
+    uint64_t offset[ACS_PHASE_COUNT];        ///< Deadline of each phase relative to the start of the cycle, in usec
+    uint64_t t0;                             ///< Start of the current cycle, in usec
+    uint64_t cycles;                         ///< Number of cycles started
+    uint64_t skipped;                        ///< Number of cycles skipped because the loop fell more than a period behind
+    acs_lateness lateness[ACS_PHASE_COUNT];  ///< Lateness of each phase
+} acs_sched;
+
+/**
+ * @brief Initializes the scheduler with the ACS timing, DETUMBLE_TIME_STEP period
+ * and MEASURE_TIME measurement window. The first cycle starts at the first call
+ * to acs_sched_wait().
+ *
+ * @param s Pointer to the scheduler
+ * @param clk Clock to schedule on
+ */
+void acs_sched_init(acs_sched *s, acs_clock *clk);
+
+/**
+ * @brief Sleeps until the start of the next cycle (measure phase). If the loop fell
+ * more than a period behind, the missed cycles are skipped and counted, keeping the
+ * cycles aligned to the original start time.
+ *
+ * @param s Pointer to the scheduler
+ * @return uint64_t Time at which the measurement starts, in usec
+ */
+uint64_t acs_sched_wait(acs_sched *s);
+
+/**
+ * @brief Marks the end of the decide phase, and measures its lateness against the
+ * end of the measurement window.
+ *
+ * @param s Pointer to the scheduler
+ */
+void acs_sched_decided(acs_sched *s);
+
+/**
+ * @brief Sleeps until the start of the actuation phase.
+ *
+ * @param s Pointer to the scheduler
+ * @return uint64_t Deadline of the actuation phase (start of the actuation window), in usec
+ */
+uint64_t acs_sched_actuate(acs_sched *s);
+
+/**
+ * @brief Hands the actuation phase off to another thread without sleeping. The lateness
+ * of the actuation phase is the time of the hand off relative to its deadline, i.e. it
+ * is negative while the actuation is handed off in time.
+ *
+ * @param s Pointer to the scheduler
+ * @return uint64_t Deadline of the actuation phase (start of the actuation window), in usec
+ */
+uint64_t acs_sched_handoff(acs_sched *s);
+#endif // ACS_SCHED_H
@@ -0,0 +1,105 @@
+/**
+ * @file acs_torquer.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Event timeline of the magnetorquers: the commands of the control law are
+ * converted into switching events at absolute times, which are then executed by
+ * the torquer thread (or in place by acs_actuate()).
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef ACS_TORQUER_H
+#define ACS_TORQUER_H
+#include <acs_core.h>
+#include <acs_clock.h>
+#include <acs_sched.h>
+#include <acs_hist.h>
+#include <stdint.h>
+
+/**
+ * @brief Maximum number of events in a timeline.
+ *
+ */
+#ifndef ACS_TIMELINE_MAX
+#define ACS_TIMELINE_MAX 48
+#endif
+
+/**
+ * @brief Time before an event at which the wall clock stops sleeping and busy waits
+ * for the event instead, in usec. Hides the wake up latency of the operating system.
+ *
+ */
+#ifndef ACS_TORQUER_SPIN
+#define ACS_TORQUER_SPIN 200
+#endif
+
+/**
+ * @brief Switching error beyond which an event counts as late, in usec.
+ *
+ */
+#ifndef ACS_TORQUER_TOLERANCE
+#define ACS_TORQUER_TOLERANCE 100
+#endif
+
+/**
+ * @brief Switching event of one magnetorquer.
+ *
+ */
+typedef struct
+{
+    uint64_t t;   ///< Time of the event, in usec
+    uint8_t axis; ///< Torquer, 0 == X, 1 == Y, 2 == Z
+    int8_t dir;   ///< Direction to drive the torquer in (-1 or +1), 0 turns it off
+} acs_event;
+
+/**
+ * @brief Events of an actuation window, sorted by time. Events with the same time
+ * are applied together.
+ *
+ */
+typedef struct
+{
+    int n;                            ///< Number of events
+    acs_event ev[ACS_TIMELINE_MAX];   ///< Events
+} acs_timeline;
+
+/**
+ * @brief Converts a command of the control law into the events of the actuation window.
+ *
+ * Detumble: the torquers are turned on at the start of the window in the directions of the
+ * command, each is turned off after its firing time, and all are turned off at the end of
+ * the window (start + MAX_DETUMBLE_FIRING_TIME). Sunpointing: the torquers are turned on
+ * at the start of every SUNPOINT_DUTY_CYCLE and turned off after the on time. Any other
+ * command only turns the torquers off at the end of the window.
+ *
+ * @param cmd Command calculated by acs_step()
+ * @param start Start of the actuation window, in usec
+ * @param tl Timeline to fill in
+ */
+void acs_timeline_build(const acs_cmd *cmd, uint64_t start, acs_timeline *tl);
+
+/**
+ * @brief Merges the events of a timeline due at or before the given time into one event
+ * per torquer at that time, holding the state the torquers would have at that time. The
+ * pulses that would have ended before that time are dropped instead of being fired back
+ * to back.
+ *
+ * @param tl Timeline to clip
+ * @param t Time, in usec
+ */
+void acs_timeline_clip(acs_timeline *tl, uint64_t t);
+
+/**
+ * @brief Executes the events of a timeline in order. Every group of events with the same
+ * time is applied with one write to the H-bridge, at that time. Events already in the past
+ * are applied immediately.
+ *
+ * @param clk Clock the event times are on
+ * @param tl Timeline to execute
+ * @param err Switching error statistics of the events (can be NULL), with tolerance ACS_TORQUER_TOLERANCE
+ * @param hist Histogram of the absolute switching error of the events in nanoseconds (can be NULL)
+ */
+void acs_timeline_run(acs_clock *clk, const acs_timeline *tl, acs_lateness *err, acs_hist *hist);
+#endif // ACS_TORQUER_H
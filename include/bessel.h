@@ -25,8 +25,109 @@
 #ifndef BESSEL_FREQ_CUTOFF
 #define BESSEL_FREQ_CUTOFF 5 // cutoff frequency 5 == 5*DETUMBLE_TIME_STEP seconds cycle == 2 Hz at 100ms loop speed
 #endif
+/**
+ * @brief Bessel filter order
+ * 
+ */
+#ifndef BESSEL_ORDER
+#define BESSEL_ORDER 3
+#endif
+/**
+ * @brief Maximum order of the IIR Bessel filter.
+ * 
+ */
+#ifndef BESSEL_IIR_MAX_ORDER
+#define BESSEL_IIR_MAX_ORDER 8
+#endif
+/**
+ * @brief Number of second order sections of the IIR Bessel filter.
+ * 
+ */
+#define BESSEL_IIR_SECTIONS ((BESSEL_IIR_MAX_ORDER + 1) / 2)
 
-extern float bessel_coeff[SH_BUFFER_SIZE]; // coefficients for Bessel filter, declared as floating point
+/**
+ * @brief Size of the SIMD registers used by the fused filter kernels, in bytes.
+ * 32 fills one AVX register, and two SSE or NEON registers.
+ * 
+ */
+#ifndef BESSEL_SIMD_BYTES
+#define BESSEL_SIMD_BYTES 32
+#endif
+
+/**
+ * @brief Bessel filter taps for the fused filter kernels, truncated at BESSEL_MIN_THRESHOLD
+ * and normalized to unity gain once by bessel_fir_init().
+ * 
+ */
+typedef struct
+{
+    int ntaps;                    ///< Number of taps used, 1 ... SH_BUFFER_SIZE
+    double dtaps[SH_BUFFER_SIZE]; ///< Normalized taps in double precision, oldest sample first
+    float ftaps[SH_BUFFER_SIZE];  ///< Normalized taps in single precision, oldest sample first
+} bessel_fir;
+
+/**
+ * @brief Linearized double precision history of a three-axis buffer. Every sample is
+ * written at index and index + SH_BUFFER_SIZE, so that the filter window is always
+ * contiguous in memory.
+ * 
+ */
+typedef struct
+{
+    double x[2 * SH_BUFFER_SIZE]; ///< X axis history
+    double y[2 * SH_BUFFER_SIZE]; ///< Y axis history
+    double z[2 * SH_BUFFER_SIZE]; ///< Z axis history
+} bessel_dhist;
+
+/**
+ * @brief Linearized single precision history of a three-axis buffer, see bessel_dhist.
+ * 
+ */
+typedef struct
+{
+    float x[2 * SH_BUFFER_SIZE]; ///< X axis history
+    float y[2 * SH_BUFFER_SIZE]; ///< Y axis history
+    float z[2 * SH_BUFFER_SIZE]; ///< Z axis history
+} bessel_fhist;
+
+/**
+ * @brief IIR Bessel filter as a cascade of second order sections (biquads), with
+ * unity DC gain. Section i filters as
+ * \f$ H_i(z) = \frac{b_0 + b_1 z^{-1} + b_2 z^{-2}}{1 + a_1 z^{-1} + a_2 z^{-2}}\f$.
+ * Odd orders end with a first order section (\f$b_2 = a_2 = 0\f$).
+ * 
+ */
+typedef struct
+{
+    int nsec;                              ///< Number of sections used, 0 (pass through) ... BESSEL_IIR_SECTIONS
+    double db[BESSEL_IIR_SECTIONS][3];     ///< Numerators b0, b1, b2 in double precision
+    double da[BESSEL_IIR_SECTIONS][2];     ///< Denominators a1, a2 in double precision
+    float fb[BESSEL_IIR_SECTIONS][3];      ///< Numerators in single precision
+    float fa[BESSEL_IIR_SECTIONS][2];      ///< Denominators in single precision
+} bessel_iir;
+
+/**
+ * @brief Double precision state of the IIR filter for a three-axis buffer
+ * (two delay elements per section, transposed direct form II).
+ * 
+ */
+typedef struct
+{
+    double x[BESSEL_IIR_SECTIONS][2]; ///< X axis state
+    double y[BESSEL_IIR_SECTIONS][2]; ///< Y axis state
+    double z[BESSEL_IIR_SECTIONS][2]; ///< Z axis state
+} bessel_diir;
+
+/**
+ * @brief Single precision state of the IIR filter for a three-axis buffer, see bessel_diir.
+ * 
+ */
+typedef struct
+{
+    float x[BESSEL_IIR_SECTIONS][2]; ///< X axis state
+    float y[BESSEL_IIR_SECTIONS][2]; ///< Y axis state
+    float z[BESSEL_IIR_SECTIONS][2]; ///< Z axis state
+} bessel_fiir;
 
 /**
  * @brief Calculates discrete Bessel filter coefficients for the given order and cutoff frequency.
@@ -41,45 +142,196 @@ void calculateBessel(float arr[], int size, int order, float freq_cutoff);
 /**
  * @brief Returns the filtered value at the current index using past values
  * 
+ * @param coeff Filter coefficients, calculated using calculateBessel()
  * @param arr Input array
  * @param index Index of current value in the array
  * @return double Filtered value
  */
-double dfilterBessel(double arr[], int index);
+double dfilterBessel(const float coeff[], double arr[], int index);
 
 /**
  * @brief Returns the filtered value at the current index using past values
  * 
+ * @param coeff Filter coefficients, calculated using calculateBessel()
  * @param arr Input array
  * @param index Index of current value in the array
- * @return double Filtered value
+ * @return float Filtered value
+ */
+float ffilterBessel(const float coeff[], float arr[], int index);
+
+/**
+ * @brief Truncates the filter coefficients the same way dfilterBessel() and ffilterBessel()
+ * do, and normalizes them to unity gain.
+ * 
+ * @param f Filter taps to initialize
+ * @param coeff Filter coefficients (SH_BUFFER_SIZE), calculated using calculateBessel()
+ */
+void bessel_fir_init(bessel_fir *f, const float coeff[]);
+
+/**
+ * @brief Filters the current sample of all three axes of a double precision buffer in one pass.
+ * 
+ * The new samples are put into the history at index, filtered using the previous
+ * values in the history, and the filtered values are stored back into the history
+ * and returned in place. Equivalent to dfilterBessel() on each axis of a buffer that
+ * mirrors the history, up to rounding.
+ * 
+ * @param f Filter taps, initialized using bessel_fir_init()
+ * @param h History of the buffer
+ * @param index Index of current value in the buffer
+ * @param x Current X sample, replaced by the filtered value
+ * @param y Current Y sample, replaced by the filtered value
+ * @param z Current Z sample, replaced by the filtered value
  */
-float ffilterBessel(float arr[], int index);
+void bessel_dfilter3(const bessel_fir *f, bessel_dhist *h, int index, double *x, double *y, double *z);
+
+/**
+ * @brief Filters the current sample of all three axes of a single precision buffer in one pass,
+ * see bessel_dfilter3().
+ * 
+ * @param f Filter taps, initialized using bessel_fir_init()
+ * @param h History of the buffer
+ * @param index Index of current value in the buffer
+ * @param x Current X sample, replaced by the filtered value
+ * @param y Current Y sample, replaced by the filtered value
+ * @param z Current Z sample, replaced by the filtered value
+ */
+void bessel_ffilter3(const bessel_fir *f, bessel_fhist *h, int index, float *x, float *y, float *z);
+
+/**
+ * @brief Designs the IIR Bessel filter of the given order and cutoff.
+ * 
+ * The poles of the analog Bessel filter are found as the roots of the reverse Bessel
+ * polynomial, scaled for -3 dB at the cutoff, and mapped to the z-plane with the bilinear
+ * transform prewarped at the cutoff. The cutoff is in the unit of calculateBessel(), i.e.
+ * a cutoff of 5 is a period of 5 samples; it is limited to just below the Nyquist frequency.
+ * 
+ * @param f Filter to initialize
+ * @param order Order of the filter, 0 (pass through) ... BESSEL_IIR_MAX_ORDER
+ * @param freq_cutoff Cut-off frequency of the Bessel filter
+ * @return int 1 on success, -1 if the order or the cutoff is invalid (the filter is set to pass through)
+ */
+int bessel_iir_init(bessel_iir *f, int order, float freq_cutoff);
+
+/**
+ * @brief Filters the current sample of all three axes of a double precision buffer
+ * with the IIR filter. O(order) operations per sample.
+ * 
+ * @param f Filter, initialized using bessel_iir_init()
+ * @param s Filter state of the buffer
+ * @param x Current X sample, replaced by the filtered value
+ * @param y Current Y sample, replaced by the filtered value
+ * @param z Current Z sample, replaced by the filtered value
+ */
+void bessel_diir3(const bessel_iir *f, bessel_diir *s, double *x, double *y, double *z);
+
+/**
+ * @brief Filters the current sample of all three axes of a single precision buffer
+ * with the IIR filter, see bessel_diir3().
+ * 
+ * @param f Filter, initialized using bessel_iir_init()
+ * @param s Filter state of the buffer
+ * @param x Current X sample, replaced by the filtered value
+ * @param y Current Y sample, replaced by the filtered value
+ * @param z Current Z sample, replaced by the filtered value
+ */
+void bessel_fiir3(const bessel_iir *f, bessel_fiir *s, float *x, float *y, float *z);
 
 /**
  * @brief Applies double precision Bessel filter on a buffer declared using DECLARE_BUFFER(), and stores the filtered value at the current index.
  * 
+ * @param coeff Filter coefficients, calculated using calculateBessel()
  * @param name Name of the buffer
  * @param index Index of the current value in the buffer
  * 
  * 
  */
-#define APPLY_DBESSEL(name, index)                    \
-    x_##name[index] = dfilterBessel(x_##name, index); \
-    y_##name[index] = dfilterBessel(y_##name, index); \
-    z_##name[index] = dfilterBessel(z_##name, index)
+#define APPLY_DBESSEL(coeff, name, index)                    \
+    x_##name[index] = dfilterBessel(coeff, x_##name, index); \
+    y_##name[index] = dfilterBessel(coeff, y_##name, index); \
+    z_##name[index] = dfilterBessel(coeff, z_##name, index)
 
 /**
  * @brief Applies floating point Bessel filter on a buffer declared using DECLARE_BUFFER(), and stores the filtered value at the current index.
  * 
+ * @param coeff Filter coefficients, calculated using calculateBessel()
+ * @param name Name of the buffer
+ * @param index Index of the current value in the buffer
+ * 
+ * 
+ */
+#define APPLY_FBESSEL(coeff, name, index)                    \
+    x_##name[index] = ffilterBessel(coeff, x_##name, index); \
+    y_##name[index] = ffilterBessel(coeff, y_##name, index); \
+    z_##name[index] = ffilterBessel(coeff, z_##name, index)
+
+/**
+ * @brief Applies the fused double precision Bessel filter on a buffer declared using DECLARE_BUFFER(),
+ * and stores the filtered value at the current index.
+ * 
+ * @param fir Filter taps, initialized using bessel_fir_init()
+ * @param hist History of the buffer (bessel_dhist)
+ * @param name Name of the buffer
+ * @param index Index of the current value in the buffer
+ * 
+ */
+#define APPLY_DBESSEL3(fir, hist, name, index) \
+    bessel_dfilter3(fir, hist, index, &x_##name[index], &y_##name[index], &z_##name[index])
+
+/**
+ * @brief Applies the fused single precision Bessel filter on a buffer declared using DECLARE_BUFFER(),
+ * and stores the filtered value at the current index.
+ * 
+ * @param fir Filter taps, initialized using bessel_fir_init()
+ * @param hist History of the buffer (bessel_fhist)
+ * @param name Name of the buffer
+ * @param index Index of the current value in the buffer
+ * 
+ */
+#define APPLY_FBESSEL3(fir, hist, name, index) \
+    bessel_ffilter3(fir, hist, index, &x_##name[index], &y_##name[index], &z_##name[index])
+
+/**
+ * @brief Applies the double precision IIR Bessel filter on a buffer declared using DECLARE_BUFFER(),
+ * and stores the filtered value at the current index.
+ * 
+ * @param iir Filter, initialized using bessel_iir_init()
+ * @param state Filter state of the buffer (bessel_diir)
  * @param name Name of the buffer
  * @param index Index of the current value in the buffer
  * 
+ */
+#define APPLY_DBESSEL_IIR(iir, state, name, index) \
+    bessel_diir3(iir, state, &x_##name[index], &y_##name[index], &z_##name[index])
+
+/**
+ * @brief Applies the single precision IIR Bessel filter on a buffer declared using DECLARE_BUFFER(),
+ * and stores the filtered value at the current index.
+ * 
+ * @param iir Filter, initialized using bessel_iir_init()
+ * @param state Filter state of the buffer (bessel_fiir)
+ * @param name Name of the buffer
+ * @param index Index of the current value in the buffer
  * 
  */
-#define APPLY_FBESSEL(name, index)                    \
-    x_##name[index] = ffilterBessel(x_##name, index); \
-    y_##name[index] = ffilterBessel(y_##name, index); \
-    z_##name[index] = ffilterBessel(z_##name, index)
+#define APPLY_FBESSEL_IIR(iir, state, name, index) \
+    bessel_fiir3(iir, state, &x_##name[index], &y_##name[index], &z_##name[index])
+
+/*
+ * Filter used by the ACS: the fused FIR kernels by default, the IIR filter with BESSEL_IIR.
+ */
+#ifdef BESSEL_IIR
+typedef bessel_iir bessel_filter;                     ///< Filter used by the ACS
+typedef bessel_diir bessel_dstate;                    ///< Double precision filter state used by the ACS
+typedef bessel_fiir bessel_fstate;                    ///< Single precision filter state used by the ACS
+#define APPLY_DFILTER(filter, state, name, index) APPLY_DBESSEL_IIR(filter, state, name, index)
+#define APPLY_FFILTER(filter, state, name, index) APPLY_FBESSEL_IIR(filter, state, name, index)
+#else
+typedef bessel_fir bessel_filter;                     ///< Filter used by the ACS
+typedef bessel_dhist bessel_dstate;                   ///< Double precision filter state used by the ACS
+typedef bessel_fhist bessel_fstate;                   ///< Single precision filter state used by the ACS
+#define APPLY_DFILTER(filter, state, name, index) APPLY_DBESSEL3(filter, state, name, index)
+#define APPLY_FFILTER(filter, state, name, index) APPLY_FBESSEL3(filter, state, name, index)
+#endif // BESSEL_IIR
 
-#endif // __SHFLIGHT_BESSEL_H
\ No newline at end of file
+#endif // __SHFLIGHT_BESSEL_H
@@ -19,6 +19,7 @@
 #endif
 #include <stdint.h>
 #include <macros.h>
+#include <acs_hist.h> // ACS_HIST_COUNT
 /**
  * @brief Internal data structure of a DataVis packet. 
  */
@@ -54,6 +55,21 @@ typedef struct
      * 
      */
     DECLARE_VECTOR2(S, float); // Sun vector
+    /**
+     * @brief Median latency of the phases of the ACS cycle (ACS_HIST order), in usec
+     * 
+     */
+    float lat_p50[ACS_HIST_COUNT];
+    /**
+     * @brief 99th percentile latency of the phases of the ACS cycle, in usec
+     * 
+     */
+    float lat_p99[ACS_HIST_COUNT];
+    /**
+     * @brief Maximum latency of the phases of the ACS cycle, in usec
+     * 
+     */
+    float lat_max[ACS_HIST_COUNT];
 } datavis_p;
 /**
  * @brief Size of the datavis_p struct
@@ -25,6 +25,10 @@
 
 #define EPS_I2C_ADDR 0x7d        // Temporary designation
 #define EPS_I2C_BUS "/dev/i2c-0" // I2C bus
+#define EPS_REPLY_TIME 10000 // usec the EPS takes to prepare a reply
+#define EPS_BYTE_TIME 90       // usec per byte on the bus at 100 kHz, 8 bits and the acknowledge
+#define EPS_XFER_TIME(len) (((len) + 1) * EPS_BYTE_TIME) // usec of a message of len bytes, with the address byte
+#define EPS_EXCHANGE_TIME(outsize, insize) (EPS_XFER_TIME(outsize) + ((insize) > 0 ? EPS_REPLY_TIME + EPS_XFER_TIME(insize) : 0)) // usec of a command, the reply wait and the reply, kept out of the ACS quiet window
 
 // Enumeration describing the return error codes of an EPS I2C transaction
 typedef enum
@@ -256,13 +260,13 @@ typedef union {
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
-#include <linux/i2c-dev.h>
-#include <i2c/smbus.h>
+#include <unistd.h>
+#include <i2c_bus.h>
 #include <errno.h>
 
 typedef struct
 {
-    int file;                    //! I2C File Descriptor
+    i2c_bus *bus;                //! I2C bus, shared with the other devices on it
     char fname[40];              //! I2C File Name
     uint8_t addr;                //! Device Address
     hkparam_t hkparam;           //! hkparam_t structure memory
@@ -274,11 +278,11 @@ typedef struct
 } p31u;
 
 /*
- * Initializes the EPS device file descriptor for communication over the I2C bus.
+ * Opens the I2C bus of the EPS device for communication.
  */
 int p31u_init(p31u *);
 /*
- * Close the EPS I2C file descriptor and free memory for the EPS device.
+ * Release the EPS I2C bus and free memory for the EPS device.
  */
 void p31u_destroy(p31u *);
 /* 
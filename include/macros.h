@@ -51,15 +51,17 @@ inline float q2isqrt(float x)
 #endif // MATH_SQRT
 
 /**
- * @brief Returns time elapsed from 1970-1-1, 00:00:00 UTC to now (UTC) in microseconds.
- * Execution time ~18 us on RPi.
+ * @brief Returns the time of CLOCK_MONOTONIC in microseconds. Read through the vDSO,
+ * it does not enter the kernel and does not step with the wall clock. Use it to measure
+ * intervals; timestamps of the flight software come from sh_time.h, which also maps them
+ * to UTC for the logs.
  * 
- * @return uint64_t Number of microseconds elapsed from epoch.
+ * @return uint64_t Number of microseconds elapsed from an arbitrary point (usually boot).
  */
 inline uint64_t get_usec(void)
 {
     struct timespec ts;
-    timespec_get(&ts, TIME_UTC);
+    clock_gettime(CLOCK_MONOTONIC, &ts);
     return (uint64_t)ts.tv_sec * 1000000L + ((uint64_t)ts.tv_nsec) / 1000;
 }
 
@@ -105,6 +107,28 @@ inline double daverage(double arr[], int size)
 #define DECLARE_BUFFER(name, type) \
     type x_##name[SH_BUFFER_SIZE], y_##name[SH_BUFFER_SIZE], z_##name[SH_BUFFER_SIZE]
 
+/**
+ * @brief Declares local pointers x_name, y_name and z_name to a buffer declared using DECLARE_BUFFER()
+ * as a member of a struct, so that the vector macros can operate on the buffer directly.
+ *
+ * @param name Name of the buffer member
+ * @param src  Pointer to the struct containing the buffer
+ * @param type Data type of the buffer
+ */
+#define ALIAS_BUFFER(name, src, type) \
+    type *x_##name = (src)->x_##name, *y_##name = (src)->y_##name, *z_##name = (src)->z_##name
+
+/**
+ * @brief Declares a local copy of a vector declared using DECLARE_VECTOR2() as a member of a struct.
+ * Changes to the local copy are not written back to the struct.
+ *
+ * @param name Name of the vector member
+ * @param src  Pointer to the struct containing the vector
+ * @param type Data type of the vector
+ */
+#define ALIAS_VECTOR(name, src, type) \
+    type x_##name = (src)->x_##name, y_##name = (src)->y_##name, z_##name = (src)->z_##name
+
 /**
  * @brief Clears a vector.
  * 
@@ -13,12 +13,33 @@
 #define __SH_MODULES_H
 #ifdef MAIN_PRIVATE
 #include <pthread.h>
+#include <sched.h>
 #include <acs_iface.h>
 #include <datavis_iface.h>
 #include <sitl_comm_iface.h>
 typedef int (*init_func)(void);     // typedef to create array of init functions
 typedef void (*destroy_func)(void); // typedef to create array of destroy functions
 
+/**
+ * @brief Real-time execution profile of a module thread.
+ *
+ */
+typedef struct
+{
+    int policy;         ///< Scheduling policy, SCHED_OTHER or SCHED_FIFO
+    int priority;       ///< SCHED_FIFO priority (1 - 99), ignored for SCHED_OTHER
+    unsigned long cpus; ///< Mask of the CPUs the thread may run on, bit n == CPU n, 0 for any CPU
+    size_t stack;       ///< Stack size in bytes, 0 for the system default
+} module_rt;
+
+/**
+ * @brief Default stack size of the module threads. All stacks are locked in memory and
+ * prefaulted, so the default stack size of the system (usually 8 MiB) is not used.
+ */
+#ifndef MODULE_STACK_SIZE
+#define MODULE_STACK_SIZE (256 * 1024)
+#endif
+
 /**
  * @brief Registers init functions of a given module
  */
@@ -43,7 +64,9 @@ const int num_destroy = sizeof(module_destroy) / sizeof(destroy_func);
  * @brief Registers exec functions of a given module
  */
 void *module_exec[] = {
-    acs_thread
+    acs_thread,
+    acs_torquer_thread,
+    acs_acq_thread
 #ifdef DATAVIS
     ,
     datavis_thread
@@ -58,11 +81,35 @@ void *module_exec[] = {
  */
 const int num_systems = sizeof(module_exec) / sizeof(void *);
 
+/**
+ * @brief Real-time profiles of the modules, in the order of module_exec[]. The torquer
+ * thread preempts everything to switch on time, the ACS thread preempts the sun sensor
+ * acquisition, and the control threads share a CPU away from the communication threads
+ * (CPUs missing on the system are ignored).
+ */
+module_rt module_profile[] = {
+    {SCHED_FIFO, 80, 0x8, MODULE_STACK_SIZE}, // acs_thread
+    {SCHED_FIFO, 90, 0x8, MODULE_STACK_SIZE}, // acs_torquer_thread
+    {SCHED_FIFO, 70, 0x4, MODULE_STACK_SIZE}  // acs_acq_thread
+#ifdef DATAVIS
+    ,
+    {SCHED_OTHER, 0, 0x3, MODULE_STACK_SIZE} // datavis_thread
+#endif
+#ifdef SITL
+    ,
+    {SCHED_FIFO, 60, 0x3, MODULE_STACK_SIZE} // sitl_comm
+#endif
+};
+_Static_assert(sizeof(module_profile) / sizeof(module_rt) == sizeof(module_exec) / sizeof(void *), "module_profile[] must have one entry per module_exec[] entry");
+
 /**
  * @brief List of condition locks for modules to be woken up by signal handler
  */
 pthread_cond_t *wakeups[] = {
+    &torquer_ready,
+    &torquer_idle
 #ifdef SITL
+    ,
     &data_available
 #endif // SITL
 #ifdef DATAVIS
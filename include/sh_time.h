@@ -0,0 +1,75 @@
+/**
+ * @file sh_time.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Time source of the flight software. All scheduling and latency math runs on
+ * CLOCK_MONOTONIC, which never steps, read through the vDSO or, with SH_TIME_CYCLES, from
+ * the cycle counter of the CPU calibrated against CLOCK_MONOTONIC. UTC is only used to
+ * stamp logs.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef SH_TIME_H
+#define SH_TIME_H
+#include <stdint.h>
+
+/**
+ * @brief Interval between two re-calibrations of the cycle counter against CLOCK_MONOTONIC,
+ * in nsec. Bounds the drift of the cycle counter path and follows the NTP frequency
+ * corrections of CLOCK_MONOTONIC.
+ *
+ */
+#ifndef SH_TIME_RESYNC
+#define SH_TIME_RESYNC 1000000000ULL
+#endif
+
+/**
+ * @brief Duration of the initial calibration of the cycle counter, in nsec.
+ *
+ */
+#ifndef SH_TIME_CALIBRATE
+#define SH_TIME_CALIBRATE 10000000ULL
+#endif
+
+/**
+ * @brief Calibrates the cycle counter if SH_TIME_CYCLES is set and the CPU has a usable one
+ * (CNTVCT on aarch64, invariant TSC on x86-64). Call once before the threads are started;
+ * the time source falls back to CLOCK_MONOTONIC until then and on every other target.
+ *
+ * @return int 1 if the cycle counter is used, 0 if CLOCK_MONOTONIC is used
+ */
+int sh_time_init(void);
+
+/**
+ * @brief Returns the name of the time source in use.
+ *
+ * @return const char* "cntvct", "tsc" or "clock_monotonic"
+ */
+const char *sh_time_source(void);
+
+/**
+ * @brief Returns the current monotonic time. Has the same origin as CLOCK_MONOTONIC, so it
+ * can be used as an absolute deadline for clock_nanosleep() on CLOCK_MONOTONIC.
+ *
+ * @return uint64_t Monotonic time, in nsec
+ */
+uint64_t sh_time_nsec(void);
+
+/**
+ * @brief Returns the current monotonic time, see sh_time_nsec().
+ *
+ * @return uint64_t Monotonic time, in usec
+ */
+uint64_t sh_time_usec(void);
+
+/**
+ * @brief Converts a monotonic time to UTC, for stamping logs only. The mapping is read at
+ * every call and follows the steps of the wall clock.
+ *
+ * @param usec Monotonic time, in usec
+ * @return uint64_t Time elapsed from 1970-1-1, 00:00:00 UTC, in usec
+ */
+uint64_t sh_time_utc(uint64_t usec);
+#endif // SH_TIME_H
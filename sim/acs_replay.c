@@ -0,0 +1,157 @@
+/**
+ * @file acs_replay.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Replays sensor inputs recorded with ACS_RECORD through the ACS control law
+ * and actuation, on a virtual clock (default) or at the recorded pace.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#include <acs.h>
+#include <acs_clock.h>
+#include <acs_record.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Clock used by the replay, also used to time the simulated torquers.
+ * 
+ */
+static acs_clock replay_clock;
+/**
+ * @brief Current state of the simulated torquers (-1, 0, +1 per axis).
+ * 
+ */
+static int torquer_state[3];
+/**
+ * @brief Time at which the simulated torquer state last changed, in usec.
+ * 
+ */
+static uint64_t torquer_t;
+/**
+ * @brief Accumulated on time of the simulated torquers per axis, in usec.
+ * 
+ */
+static uint64_t torquer_on_time[3];
+
+/**
+ * @brief Accumulates the on time of the torquers since the last state change.
+ * 
+ */
+static inline void torquer_update(void)
+{
+    uint64_t now = acs_clock_now(&replay_clock);
+    for (int i = 0; i < 3; i++)
+        if (torquer_state[i])
+            torquer_on_time[i] += now - torquer_t;
+    torquer_t = now;
+}
+
+int hbridge_enable(int x, int y, int z)
+{
+    torquer_update();
+    torquer_state[0] = x;
+    torquer_state[1] = y;
+    torquer_state[2] = z;
+    return 1;
+}
+
+int HBRIDGE_DISABLE(int num)
+{
+    torquer_update();
+    for (int i = 0; i < 3; i++)
+        if (num == i || num > 2)
+            torquer_state[i] = 0;
+    return 1;
+}
+
+/**
+ * @brief Compares two commands field by field.
+ * 
+ * @return int 1 if the commands are identical, 0 otherwise
+ */
+static inline int cmd_equal(const acs_cmd *a, const acs_cmd *b)
+{
+    return a->status == b->status && a->type == b->type &&
+           a->x_fire == b->x_fire && a->y_fire == b->y_fire && a->z_fire == b->z_fire &&
+           a->x_firingCmd == b->x_firingCmd && a->y_firingCmd == b->y_firingCmd && a->z_firingCmd == b->z_firingCmd &&
+           a->time_on == b->time_on;
+}
+
+int main(int argc, char *argv[])
+{
+    char *fname = NULL, *oname = NULL;
+    int realtime = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-r"))
+            realtime = 1;
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+            oname = argv[++i];
+        else
+            fname = argv[i];
+    }
+    if (fname == NULL)
+    {
+        fprintf(stderr, "Usage: %s [-r] [-o datalog] <acsrecord file>\n"
+                        "\t-r: Replay at the recorded pace using the wall clock\n"
+                        "\t-o: Write ACS data in the ACS_DATALOG format\n",
+                argv[0]);
+        return -1;
+    }
+    FILE *fp = fopen(fname, "r");
+    if (fp == NULL)
+    {
+        perror("Replay: Could not open record");
+        return -1;
+    }
+    FILE *op = NULL;
+    if (oname != NULL && (op = fopen(oname, "w")) == NULL)
+    {
+        perror("Replay: Could not open datalog");
+        return -1;
+    }
+
+    acs_ctx ctx;
+    acs_ctx_init(&ctx);
+    acs_input in;
+    acs_cmd rec_cmd;
+    uint64_t t, t0 = 0, clk_t0 = 0, wall_t0 = get_usec();
+    unsigned long long cycles = 0, mismatches = 0;
+    int status;
+    while ((status = acs_record_read(fp, &t, &in, &rec_cmd)) > 0)
+    {
+        if (cycles == 0)
+        {
+            t0 = t;
+            acs_clock_init(&replay_clock, realtime ? ACS_CLOCK_WALL : ACS_CLOCK_VIRTUAL, t);
+            clk_t0 = torquer_t = acs_clock_now(&replay_clock);
+        }
+        uint64_t s = clk_t0 + (t - t0);          // recorded time on the replay clock
+        acs_clock_sleep_until(&replay_clock, s); // keeps the recorded pace on the wall clock, jumps on the virtual clock
+        acs_cmd cmd = acs_step(&ctx, &in, t);
+        if (!cmd_equal(&cmd, &rec_cmd))
+        {
+            if (mismatches == 0)
+                fprintf(stderr, "Replay: Command mismatch at cycle %llu (t = %llu)\n", cycles, (unsigned long long)t);
+            mismatches++;
+        }
+        if (op != NULL && ctx.omega_index >= 0)
+            fprintf(op, "%llu %d %e %e %e %e %e %e %e %e %e\n", ctx.step, ctx.mode, ctx.x_B[ctx.mag_index], ctx.y_B[ctx.mag_index], ctx.z_B[ctx.mag_index], ctx.x_W[ctx.omega_index], ctx.y_W[ctx.omega_index], ctx.z_W[ctx.omega_index], ctx.x_S[ctx.sol_index], ctx.y_S[ctx.sol_index], ctx.z_S[ctx.sol_index]);
+        acs_clock_sleep_until(&replay_clock, s + MEASURE_TIME);
+        acs_actuate(&replay_clock, &cmd, s + MEASURE_TIME);
+        cycles++;
+    }
+    fclose(fp);
+    if (op != NULL)
+        fclose(op);
+    if (status < 0)
+        fprintf(stderr, "Replay: Malformed record after cycle %llu\n", cycles);
+    uint64_t wall = get_usec() - wall_t0;
+    printf("Replayed %llu cycles (%.3f s recorded) in %.3f s, %llu command mismatches\n", cycles, cycles ? (t - t0) / 1e6 : 0, wall / 1e6, mismatches);
+    printf("Torquer on time: X %.3f s, Y %.3f s, Z %.3f s\n", torquer_on_time[0] / 1e6, torquer_on_time[1] / 1e6, torquer_on_time[2] / 1e6);
+    return (mismatches > 0 || status < 0) ? 1 : 0;
+}
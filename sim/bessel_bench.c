@@ -0,0 +1,241 @@
+/**
+ * @file bessel_bench.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Benchmarks the fused three-axis Bessel filter kernels against the per-axis
+ * circular buffer filters, and reports the deviation between the two.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include <bessel.h>
+#include <macros.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Returns the next number of a xorshift64 sequence in [-1, 1).
+ *
+ */
+static inline double bench_rand(uint64_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return (*s >> 11) * (2.0 / 9007199254740992.0) - 1;
+}
+
+/**
+ * @brief Monotonic time in nanoseconds.
+ *
+ */
+static inline uint64_t bench_nsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Filters a three-axis signal with both implementations in double precision.
+ *
+ * @param out Time per three-axis sample of the per-axis and the fused filter, in ns
+ * @return double Maximum absolute deviation between the two outputs
+ */
+static double bench_double(const float coeff[], const bessel_fir *fir, const double sig[][3], double res[][3], int len, double out[2])
+{
+    static DECLARE_BUFFER(B, double);
+    static bessel_dhist hist;
+    FLUSH_BUFFER(B);
+    memset(&hist, 0, sizeof(hist));
+    uint64_t t0 = bench_nsec();
+    for (int n = 0; n < len; n++)
+    {
+        int index = n % SH_BUFFER_SIZE;
+        x_B[index] = sig[n][0];
+        y_B[index] = sig[n][1];
+        z_B[index] = sig[n][2];
+        APPLY_DBESSEL(coeff, B, index);
+        res[n][0] = x_B[index];
+        res[n][1] = y_B[index];
+        res[n][2] = z_B[index];
+    }
+    uint64_t t1 = bench_nsec();
+    double dev = 0;
+    for (int n = 0; n < len; n++)
+    {
+        int index = n % SH_BUFFER_SIZE;
+        double x = sig[n][0], y = sig[n][1], z = sig[n][2];
+        bessel_dfilter3(fir, &hist, index, &x, &y, &z);
+        res[n][0] -= x; // reference minus fused, checked after the timed loop
+        res[n][1] -= y;
+        res[n][2] -= z;
+    }
+    uint64_t t2 = bench_nsec();
+    for (int n = 0; n < len; n++)
+        for (int i = 0; i < 3; i++)
+            if (fabs(res[n][i]) > dev)
+                dev = fabs(res[n][i]);
+    out[0] = (double)(t1 - t0) / len;
+    out[1] = (double)(t2 - t1) / len;
+    return dev;
+}
+
+/**
+ * @brief Filters a three-axis signal with both implementations in single precision.
+ *
+ * @param out Time per three-axis sample of the per-axis and the fused filter, in ns
+ * @return double Maximum absolute deviation between the two outputs
+ */
+static double bench_float(const float coeff[], const bessel_fir *fir, const double sig[][3], double res[][3], int len, double out[2])
+{
+    static DECLARE_BUFFER(W, float);
+    static bessel_fhist hist;
+    FLUSH_BUFFER(W);
+    memset(&hist, 0, sizeof(hist));
+    uint64_t t0 = bench_nsec();
+    for (int n = 0; n < len; n++)
+    {
+        int index = n % SH_BUFFER_SIZE;
+        x_W[index] = sig[n][0];
+        y_W[index] = sig[n][1];
+        z_W[index] = sig[n][2];
+        APPLY_FBESSEL(coeff, W, index);
+        res[n][0] = x_W[index];
+        res[n][1] = y_W[index];
+        res[n][2] = z_W[index];
+    }
+    uint64_t t1 = bench_nsec();
+    double dev = 0;
+    for (int n = 0; n < len; n++)
+    {
+        int index = n % SH_BUFFER_SIZE;
+        float x = sig[n][0], y = sig[n][1], z = sig[n][2];
+        bessel_ffilter3(fir, &hist, index, &x, &y, &z);
+        res[n][0] -= x;
+        res[n][1] -= y;
+        res[n][2] -= z;
+    }
+    uint64_t t2 = bench_nsec();
+    for (int n = 0; n < len; n++)
+        for (int i = 0; i < 3; i++)
+            if (fabs(res[n][i]) > dev)
+                dev = fabs(res[n][i]);
+    out[0] = (double)(t1 - t0) / len;
+    out[1] = (double)(t2 - t1) / len;
+    return dev;
+}
+
+/**
+ * @brief Filters a three-axis signal with the IIR filter in double and single precision.
+ *
+ * @param out Time per three-axis sample in double and single precision, in ns
+ */
+static void bench_iir(const bessel_iir *iir, const double sig[][3], double res[][3], int len, double out[2])
+{
+    static bessel_diir dstate;
+    static bessel_fiir fstate;
+    memset(&dstate, 0, sizeof(dstate));
+    memset(&fstate, 0, sizeof(fstate));
+    uint64_t t0 = bench_nsec();
+    for (int n = 0; n < len; n++)
+    {
+        double x = sig[n][0], y = sig[n][1], z = sig[n][2];
+        bessel_diir3(iir, &dstate, &x, &y, &z);
+        res[n][0] = x;
+        res[n][1] = y;
+        res[n][2] = z;
+    }
+    uint64_t t1 = bench_nsec();
+    for (int n = 0; n < len; n++)
+    {
+        float x = sig[n][0], y = sig[n][1], z = sig[n][2];
+        bessel_fiir3(iir, &fstate, &x, &y, &z);
+        res[n][0] -= x; // keeps the loop from being optimized out
+    }
+    uint64_t t2 = bench_nsec();
+    out[0] = (double)(t1 - t0) / len;
+    out[1] = (double)(t2 - t1) / len;
+}
+
+/**
+ * @brief Lag of a filter at low frequencies (DC group delay) in samples, estimated as
+ * the centroid of the response to a unit step, \f$\sum_n (1 - y_n)\f$.
+ *
+ */
+static double bench_lag(const bessel_fir *fir, const bessel_iir *iir)
+{
+    static bessel_dhist hist;
+    static bessel_diir state;
+    memset(&hist, 0, sizeof(hist));
+    memset(&state, 0, sizeof(state));
+    double lag = 0;
+    for (int n = 0; n < 100 * SH_BUFFER_SIZE; n++)
+    {
+        double x = 1, y = 1, z = 1;
+        if (fir != NULL)
+            bessel_dfilter3(fir, &hist, n % SH_BUFFER_SIZE, &x, &y, &z);
+        else
+            bessel_diir3(iir, &state, &x, &y, &z);
+        lag += 1 - x;
+    }
+    return lag;
+}
+
+int main(int argc, char *argv[])
+{
+    int len = argc > 1 ? atoi(argv[1]) : 200000;
+    if (len < SH_BUFFER_SIZE)
+    {
+        fprintf(stderr, "Usage: %s [number of samples >= %d]\n", argv[0], SH_BUFFER_SIZE);
+        return -1;
+    }
+    double(*sig)[3] = malloc(len * sizeof(*sig));
+    double(*res)[3] = malloc(len * sizeof(*res));
+    if (sig == NULL || res == NULL)
+    {
+        perror("Bench: Allocation failed");
+        return -1;
+    }
+    uint64_t s = 0x5eed;
+    for (int n = 0; n < len; n++) // slowly rotating field with noise, amplitude 1
+        for (int i = 0; i < 3; i++)
+            sig[n][i] = 0.9 * sin(0.01 * n + 2.1 * i) + 0.1 * bench_rand(&s);
+
+    printf("Bessel filter, %d samples per axis, %d byte SIMD registers\n", len, BESSEL_SIMD_BYTES);
+    printf("%8s %6s | %12s %12s %8s %10s | %12s %12s %8s %10s\n", "cutoff", "taps", "double ns", "fused ns", "speedup", "deviation", "float ns", "fused ns", "speedup", "deviation");
+    const float cutoffs[] = {2, 3, BESSEL_FREQ_CUTOFF, 8, 12, 20};
+    for (unsigned c = 0; c < sizeof(cutoffs) / sizeof(cutoffs[0]); c++)
+    {
+        float coeff[SH_BUFFER_SIZE];
+        bessel_fir fir;
+        calculateBessel(coeff, SH_BUFFER_SIZE, BESSEL_ORDER, cutoffs[c]);
+        bessel_fir_init(&fir, coeff);
+        double td[2], tf[2];
+        double dd = bench_double(coeff, &fir, (const double(*)[3])sig, res, len, td);
+        double df = bench_float(coeff, &fir, (const double(*)[3])sig, res, len, tf);
+        printf("%8.1f %6d | %12.1f %12.1f %7.2fx %10.2e | %12.1f %12.1f %7.2fx %10.2e\n", cutoffs[c], fir.ntaps, td[0], td[1], td[0] / td[1], dd, tf[0], tf[1], tf[0] / tf[1], df);
+    }
+
+    printf("\nIIR Bessel filter (BESSEL_IIR), order %d\n", BESSEL_ORDER);
+    printf("%8s %6s | %12s %12s | %10s %10s\n", "cutoff", "biquad", "double ns", "float ns", "FIR lag", "IIR lag");
+    for (unsigned c = 0; c < sizeof(cutoffs) / sizeof(cutoffs[0]); c++)
+    {
+        float coeff[SH_BUFFER_SIZE];
+        bessel_fir fir;
+        bessel_iir iir;
+        calculateBessel(coeff, SH_BUFFER_SIZE, BESSEL_ORDER, cutoffs[c]);
+        bessel_fir_init(&fir, coeff);
+        bessel_iir_init(&iir, BESSEL_ORDER, cutoffs[c]);
+        double t[2];
+        bench_iir(&iir, (const double(*)[3])sig, res, len, t);
+        printf("%8.1f %6d | %12.1f %12.1f | %10.2f %10.2f\n", cutoffs[c], iir.nsec, t[0], t[1], bench_lag(&fir, NULL), bench_lag(NULL, &iir));
+    }
+    free(sig);
+    free(res);
+    return 0;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file lsm9ds1_bench.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Benchmarks the I2C bus time per sample of the LSM9DS1 reads on the flight
+ * computer: the magnetometer read one register per transaction against the burst read,
+ * and the gyroscope read one sample at a time against the FIFO drain.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include <lsm9ds1.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Time between FIFO drains, in usec, one ACS cycle.
+ *
+ */
+#define BENCH_FIFO_PERIOD 100000
+
+/**
+ * @brief Monotonic time in nanoseconds.
+ *
+ */
+static inline uint64_t bench_nsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Reads the magnetometer one register at a time, a write of the register address
+ * and a separate read of one byte for each of the six output registers.
+ *
+ */
+static int read_mag_bytewise(lsm9ds1 *dev, short *B)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        uint8_t buf = MAG_OUT_X_L + i;
+        if (i2c_bus_send(dev->bus, dev->mag_addr, &buf, 1) < 0 || i2c_bus_recv(dev->bus, dev->mag_addr, &buf, 1) < 0)
+            return -1;
+        if (i & 1)
+            B[i / 2] |= (short)(buf << 8);
+        else
+            B[i / 2] = buf;
+    }
+    return 1;
+}
+
+static int ucompare(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Prints the statistics of n timed reads of samples samples in total, in usec.
+ *
+ */
+static void bench_report(const char *name, int calls, uint64_t t[], int n, long samples)
+{
+    if (n == 0 || samples == 0)
+    {
+        printf("%-26s %6d %10s\n", name, calls, "-");
+        return;
+    }
+    uint64_t sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += t[i];
+    qsort(t, n, sizeof(uint64_t), ucompare);
+    printf("%-26s %6d %10.1f %10.1f %10.1f %10.1f %12.1f\n", name, calls, sum * 1e-3 / n, t[n / 2] * 1e-3, t[(int)(0.99 * (n - 1))] * 1e-3, t[n - 1] * 1e-3, sum * 1e-3 / samples);
+}
+
+int main(int argc, char *argv[])
+{
+    int reads = 1000, drains = 50;
+    const char *bus = MAG_I2C_FIle;
+    int c;
+    while ((c = getopt(argc, argv, "n:d:b:h")) != -1)
+    {
+        switch (c)
+        {
+        case 'n':
+            reads = atoi(optarg);
+            break;
+        case 'd':
+            drains = atoi(optarg);
+            break;
+        case 'b':
+            bus = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [options]\n"
+                            "\t-n: Number of timed reads of each kind (%d)\n"
+                            "\t-d: Number of gyroscope FIFO drains, %d ms apart (%d)\n"
+                            "\t-b: I2C bus device file (%s)\n",
+                    argv[0], reads, BENCH_FIFO_PERIOD / 1000, drains, bus);
+            return c == 'h' ? 0 : -1;
+        }
+    }
+    if (reads < 1 || drains < 0)
+    {
+        fprintf(stderr, "LSM9DS1 bench: Invalid options\n");
+        return -1;
+    }
+    lsm9ds1 *dev = (lsm9ds1 *)calloc(1, sizeof(lsm9ds1));
+    uint64_t *t = (uint64_t *)calloc(reads > drains ? reads : drains, sizeof(uint64_t));
+    if (dev == NULL || t == NULL)
+    {
+        perror("LSM9DS1 bench: Allocation failed");
+        return -1;
+    }
+    snprintf(dev->fname, sizeof(dev->fname), "%s", bus);
+    if (lsm9ds1_init(dev, LSM9DS1_XL_ADDR, LSM9DS1_MAG_ADDR) < 0)
+    {
+        fprintf(stderr, "LSM9DS1 bench: Could not initialize the LSM9DS1 on %s\n", bus);
+        return 1;
+    }
+    printf("LSM9DS1 on %s, %d reads, times in usec\n", bus, reads);
+    printf("%-26s %6s %10s %10s %10s %10s %12s\n", "read", "calls", "mean", "median", "p99", "max", "per sample");
+
+    short B[3], W[LSM9DS1_FIFO_SIZE][3];
+    int n = 0;
+    for (int i = 0; i < reads; i++)
+    {
+        uint64_t t0 = bench_nsec();
+        if (read_mag_bytewise(dev, B) > 0)
+            t[n++] = bench_nsec() - t0;
+    }
+    bench_report("magnetometer, bytewise", 12, t, n, n);
+    n = 0;
+    for (int i = 0; i < reads; i++)
+    {
+        uint64_t t0 = bench_nsec();
+        if (lsm9ds1_read_mag(dev, B) > 0)
+            t[n++] = bench_nsec() - t0;
+    }
+    bench_report("magnetometer, burst", 1, t, n, n);
+
+    if (!dev->gyro)
+    {
+        printf("Gyroscope not available\n");
+        lsm9ds1_destroy(dev);
+        free(t);
+        return 0;
+    }
+    n = 0;
+    for (int i = 0; i < reads; i++)
+    {
+        uint64_t t0 = bench_nsec();
+        if (lsm9ds1_read_gyro(dev, W[0]) > 0)
+            t[n++] = bench_nsec() - t0;
+    }
+    bench_report("gyroscope, one sample", 1, t, n, n);
+    if (dev->fifo)
+    {
+        long samples = 0;
+        n = 0;
+        lsm9ds1_read_gyro_fifo(dev, W, LSM9DS1_FIFO_SIZE); // start from an empty FIFO
+        for (int i = 0; i < drains; i++)
+        {
+            usleep(BENCH_FIFO_PERIOD);
+            uint64_t t0 = bench_nsec();
+            int m = lsm9ds1_read_gyro_fifo(dev, W, LSM9DS1_FIFO_SIZE);
+            uint64_t t1 = bench_nsec();
+            if (m > 0)
+            {
+                t[n++] = t1 - t0;
+                samples += m;
+            }
+        }
+        bench_report("gyroscope, FIFO drain", 2, t, n, samples);
+        if (n > 0)
+            printf("%.1f samples per drain\n", (double)samples / n);
+    }
+    else
+        printf("Gyroscope FIFO not available\n");
+    lsm9ds1_destroy(dev);
+    free(t);
+    return 0;
+}
@@ -0,0 +1,809 @@
+/**
+ * @file montecarlo.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Monte Carlo campaign runner. Runs randomized detumble and sunpointing
+ * scenarios through the ACS control law and actuation against the spacecraft
+ * model, on virtual clocks across all cores, and reports aggregate statistics.
+ *
+ * The initial angular speed, moment of inertia perturbation, sensor noise and Bessel
+ * cutoff are randomized per scenario; scenario i depends only on the seed and i, so
+ * results do not depend on the number of threads. Reports time to detumble, time to
+ * STATE_ACS_READY, torquer on time and energy, and mode transitions. -B runs
+ * ACS_BATCH_LANES scenarios in lockstep per thread with the structure-of-arrays control
+ * law (acs_step_batch()), which produces the same results as the scalar path; -V checks
+ * the batched kernels bit by bit against the scalar path, reports the speedup, and checks
+ * the angular speed across a lost gyroscope reading. Build with e.g. CFLAGS="-mavx2" to
+ * let the compiler use wider SIMD registers.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include <acs.h>
+#include <acs_batch.h>
+#include <acs_clock.h>
+#include <acs_sched.h>
+#include <bessel.h>
+#include "spacecraft.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @brief Power drawn by one magnetorquer while it is on, in W, used to convert on time to energy
+ *
+ */
+#ifndef MC_COIL_POWER
+#define MC_COIL_POWER 0.25 // nominal, override with -DMC_COIL_POWER=
+#endif
+/**
+ * @brief Number of ACS states, for the transition matrix
+ *
+ */
+#define MC_NUM_MODES (STATE_XBAND_READY + 1)
+
+/**
+ * @brief Campaign options.
+ *
+ */
+typedef struct
+{
+    int runs;             ///< Number of scenarios
+    int threads;          ///< Number of worker threads
+    double max_time;      ///< Maximum simulated time per scenario, in s
+    uint64_t seed;        ///< Seed of the campaign, scenario i is a function of (seed, i) only
+    double W_max;         ///< Maximum initial angular speed per axis, in rad/s
+    double moi_pert;      ///< Maximum relative perturbation of the MOI table
+    double B_noise_max;   ///< Maximum magnetometer noise standard deviation, in milliGauss
+    double CSS_noise_max; ///< Maximum coarse sun sensor noise standard deviation, in lux
+    double G_noise;       ///< Gyroscope noise standard deviation, in rad/s, negative for no gyroscope
+    double G_bias_max;    ///< Maximum gyroscope bias per axis, in rad/s
+    double cutoff_min;    ///< Minimum Bessel cutoff
+    double cutoff_max;    ///< Maximum Bessel cutoff
+    const char *csv;      ///< File to write per scenario results into, NULL for none
+    int batch;            ///< Run ACS_BATCH_LANES scenarios in lockstep per thread using acs_step_batch()
+} mc_opts;
+
+/**
+ * @brief Results of one scenario.
+ *
+ */
+typedef struct
+{
+    sc_params p;                                      ///< Scenario parameters
+    double cutoff;                                    ///< Bessel cutoff of the scenario
+    double t_detumble;                                ///< Time to first detumble in s, negative if not reached
+    double t_ready;                                   ///< Time to STATE_ACS_READY in s, negative if not reached
+    double t_end;                                     ///< Simulated time in s
+    double on_time;                                   ///< Total torquer on time in s
+    double energy;                                    ///< Torquer energy in J
+    int transitions;                                  ///< Number of ACS state transitions
+    int flushes;                                      ///< Number of cycles that flushed the buffers
+    int transition[MC_NUM_MODES][MC_NUM_MODES];       ///< Transition counts [from][to]
+} mc_result;
+
+/**
+ * @brief Shared state of the worker threads.
+ *
+ */
+typedef struct
+{
+    const mc_opts *o;  ///< Campaign options
+    mc_result *res;    ///< Results, one per scenario
+    int next;          ///< Next scenario to run, incremented atomically
+} mc_campaign;
+
+/**
+ * @brief Satellite driven by the torquers of the calling thread.
+ *
+ */
+static __thread spacecraft *mc_sc;
+/**
+ * @brief Clock of the calling thread.
+ *
+ */
+static __thread acs_clock *mc_clk;
+
+int hbridge_enable(int x, int y, int z)
+{
+    sc_advance(mc_sc, acs_clock_now(mc_clk)); // integrate up to the switching time under the old state
+    sc_set_torquer(mc_sc, x, y, z);
+    return 1;
+}
+
+int HBRIDGE_DISABLE(int num)
+{
+    sc_advance(mc_sc, acs_clock_now(mc_clk));
+    int *t = mc_sc->torquer;
+    for (int i = 0; i < 3; i++)
+        if (num == i || num > 2)
+            t[i] = 0;
+    return 1;
+}
+
+/**
+ * @brief Draws the parameters of scenario idx.
+ *
+ */
+static void mc_draw(const mc_opts *o, int idx, mc_result *r)
+{
+    uint64_t s = (o->seed << 32) ^ idx;
+    s = sc_rand(&s); // hash (seed, idx) so the streams of the scenarios do not overlap
+    sc_params *p = &r->p;
+    memset(p, 0, sizeof(sc_params));
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+            p->MOI[i][j] = acs_default_MOI[i][j];
+        p->MOI[i][i] *= 1 + sc_uniform(&s, -o->moi_pert, o->moi_pert);
+    }
+    // products of inertia, kept small w.r.t. the principal moments
+    double Ixy = 0.1 * o->moi_pert * p->MOI[0][0] * sc_uniform(&s, -1, 1);
+    double Ixz = 0.1 * o->moi_pert * p->MOI[0][0] * sc_uniform(&s, -1, 1);
+    double Iyz = 0.1 * o->moi_pert * p->MOI[1][1] * sc_uniform(&s, -1, 1);
+    p->MOI[0][1] = p->MOI[1][0] = Ixy;
+    p->MOI[0][2] = p->MOI[2][0] = Ixz;
+    p->MOI[1][2] = p->MOI[2][1] = Iyz;
+    for (int i = 0; i < 3; i++)
+        p->W0[i] = sc_uniform(&s, -o->W_max, o->W_max);
+    for (int i = 0; i < 4; i++)
+        p->q0[i] = sc_gauss(&s, 1); // uniform on the 3-sphere after normalization
+    p->altitude = sc_uniform(&s, 400e3, 600e3);
+    p->inclination = sc_uniform(&s, 0, M_PI);
+    p->phase = sc_uniform(&s, 0, 2 * M_PI);
+    double sz = sc_uniform(&s, -1, 1), sa = sc_uniform(&s, 0, 2 * M_PI);
+    p->sun[0] = sqrt(1 - sz * sz) * cos(sa);
+    p->sun[1] = sqrt(1 - sz * sz) * sin(sa);
+    p->sun[2] = sz;
+    p->B_noise = sc_uniform(&s, 0, o->B_noise_max);
+    p->CSS_noise = sc_uniform(&s, 0, o->CSS_noise_max);
+    p->seed = sc_rand(&s);
+    r->cutoff = sc_uniform(&s, o->cutoff_min, o->cutoff_max);
+    p->G_noise = o->G_noise;
+    for (int i = 0; i < 3 && o->G_noise >= 0; i++) // drawn last, scenarios without a gyroscope are unchanged
+        p->G_bias[i] = sc_uniform(&s, -o->G_bias_max, o->G_bias_max);
+}
+
+/**
+ * @brief Simulation state of one scenario.
+ *
+ */
+typedef struct
+{
+    spacecraft sc;   ///< Satellite
+    acs_ctx ctx;     ///< Control law
+    acs_clock clk;   ///< Virtual clock of the scenario
+    acs_sched sched; ///< Cycle deadlines on the virtual clock
+    mc_result *r;    ///< Results of the scenario
+    uint64_t t;      ///< Start of the current cycle, in usec
+    uint64_t t_max;  ///< End of the scenario, in usec
+} mc_lane;
+
+/**
+ * @brief Draws scenario idx and initializes its simulation state.
+ *
+ * @return int 1 if the scenario is ready to run, 0 if it can not be run
+ */
+static int mc_begin(const mc_opts *o, int idx, mc_result *r, mc_lane *l)
+{
+    memset(r, 0, sizeof(mc_result));
+    mc_draw(o, idx, r);
+    r->t_detumble = -1;
+    r->t_ready = -1;
+    l->r = r;
+    if (sc_init(&l->sc, &r->p) < 0)
+        return 0;
+    acs_ctx_init(&l->ctx);
+    acs_ctx_set_cutoff(&l->ctx, r->cutoff);
+    acs_clock_init(&l->clk, ACS_CLOCK_VIRTUAL, 0);
+    acs_sched_init(&l->sched, &l->clk);
+    l->t_max = o->max_time * 1e6;
+    return 1;
+}
+
+/**
+ * @brief Starts a cycle: advances the satellite to the current time and reads the sensors.
+ *
+ * @return int 1 if the cycle can run, 0 if the scenario ran out of time
+ */
+static int mc_sense(mc_lane *l, acs_input *in)
+{
+    l->t = acs_sched_wait(&l->sched);
+    if (l->t >= l->t_max)
+        return 0;
+    sc_advance(&l->sc, l->t);
+    sc_sense(&l->sc, in);
+    return 1;
+}
+
+/**
+ * @brief Records the outcome of the control law for the cycle.
+ *
+ * @param mode State of the context before the cycle
+ * @return int 1 if the scenario continues, 0 if it reached STATE_ACS_READY
+ */
+static int mc_record(mc_lane *l, uint8_t mode, const acs_cmd *cmd)
+{
+    mc_result *r = l->r;
+    uint8_t next = l->ctx.mode;
+    if (cmd->status < 0)
+        r->flushes++;
+    if (next != mode)
+    {
+        r->transitions++;
+        if (mode < MC_NUM_MODES && next < MC_NUM_MODES)
+            r->transition[mode][next]++;
+    }
+    if (r->t_detumble < 0 && !l->ctx.first_detumble)
+        r->t_detumble = l->t * 1e-6;
+    if (next == STATE_ACS_READY)
+    {
+        r->t_ready = l->t * 1e-6;
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Executes the command of the cycle on the satellite until the end of the cycle.
+ *
+ */
+static void mc_actuate(mc_lane *l, const acs_cmd *cmd)
+{
+    mc_sc = &l->sc;
+    mc_clk = &l->clk;
+    acs_sched_decided(&l->sched);
+    acs_actuate(&l->clk, cmd, acs_sched_actuate(&l->sched));
+}
+
+/**
+ * @brief Finalizes the results of the scenario.
+ *
+ */
+static void mc_end(mc_lane *l)
+{
+    mc_result *r = l->r;
+    sc_advance(&l->sc, acs_clock_now(&l->clk));
+    r->t_end = l->sc.t * 1e-6;
+    r->on_time = (l->sc.torquer_on[0] + l->sc.torquer_on[1] + l->sc.torquer_on[2]) * 1e-6;
+    r->energy = r->on_time * MC_COIL_POWER;
+}
+
+/**
+ * @brief Runs scenario idx until the ACS reaches STATE_ACS_READY or the time runs out.
+ *
+ */
+static void mc_run(const mc_opts *o, int idx, mc_result *r)
+{
+    mc_lane l;
+    if (!mc_begin(o, idx, r, &l))
+        return;
+    acs_input in;
+    while (mc_sense(&l, &in))
+    {
+        uint8_t mode = l.ctx.mode;
+        acs_cmd cmd = acs_step(&l.ctx, &in, l.t);
+        if (!mc_record(&l, mode, &cmd))
+            break;
+        mc_actuate(&l, &cmd);
+    }
+    mc_end(&l);
+}
+
+/**
+ * @brief Runs scenarios idx ... idx + n - 1 in lockstep, with the control law of
+ * all running scenarios evaluated by acs_step_batch().
+ *
+ */
+static void mc_run_batch(const mc_opts *o, int idx, int n, mc_result *res)
+{
+    mc_lane l[ACS_BATCH_LANES];
+    acs_ctx *ctx[ACS_BATCH_LANES];
+    acs_input in[ACS_BATCH_LANES];
+    uint64_t now[ACS_BATCH_LANES];
+    acs_cmd cmd[ACS_BATCH_LANES];
+    uint8_t mode[ACS_BATCH_LANES];
+    int lane[ACS_BATCH_LANES]; // lane of each running scenario
+    int running = 0;
+    for (int i = 0; i < n; i++)
+        if (mc_begin(o, idx + i, &res[idx + i], &l[i]))
+            lane[running++] = i;
+    while (running > 0)
+    {
+        int m = 0;
+        for (int k = 0; k < running; k++)
+        {
+            mc_lane *p = &l[lane[k]];
+            if (!mc_sense(p, &in[m]))
+            {
+                mc_end(p);
+                continue;
+            }
+            lane[m] = lane[k];
+            ctx[m] = &p->ctx;
+            now[m] = p->t;
+            mode[m] = p->ctx.mode;
+            m++;
+        }
+        acs_step_batch(ctx, in, now, cmd, m);
+        running = 0;
+        for (int k = 0; k < m; k++)
+        {
+            mc_lane *p = &l[lane[k]];
+            if (!mc_record(p, mode[k], &cmd[k]))
+            {
+                mc_end(p);
+                continue;
+            }
+            mc_actuate(p, &cmd[k]);
+            lane[running++] = lane[k];
+        }
+    }
+}
+
+/**
+ * @brief Worker thread, runs scenarios until none are left.
+ *
+ */
+static void *mc_worker(void *arg)
+{
+    mc_campaign *c = (mc_campaign *)arg;
+    int idx, step = c->o->batch ? ACS_BATCH_LANES : 1;
+    while ((idx = __atomic_fetch_add(&c->next, step, __ATOMIC_RELAXED)) < c->o->runs)
+    {
+        if (c->o->batch)
+            mc_run_batch(c->o, idx, idx + step > c->o->runs ? c->o->runs - idx : step, c->res);
+        else
+            mc_run(c->o, idx, &c->res[idx]);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Draws a random context with all buffer indices at the same position,
+ * for the equivalence check of the batched kernels.
+ *
+ */
+static void mc_verify_ctx(uint64_t *s, acs_ctx *ctx)
+{
+    acs_ctx_init(ctx);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            ctx->MOI[i][j] = acs_default_MOI[i][j] * (i == j ? 1 + sc_uniform(s, -0.2, 0.2) : 0);
+    acs_ctx_set_target(ctx, 0, 0, 1);
+    int k = sc_rand(s) % SH_BUFFER_SIZE;
+    int k0 = k == 0 ? SH_BUFFER_SIZE - 1 : k - 1;
+    ctx->mag_index = ctx->bdot_index = ctx->omega_index = ctx->sol_index = k;
+    ctx->B_full = 1;
+    int edge = sc_rand(s) % 16; // exercise degenerate inputs every now and then
+    ctx->x_B[k] = edge == 0 ? 0 : sc_gauss(s, 300);
+    ctx->y_B[k] = edge == 0 ? 0 : sc_gauss(s, 300);
+    ctx->z_B[k] = edge == 0 ? 0 : sc_gauss(s, 300);
+    ctx->x_W[k] = edge == 1 ? ctx->x_W_target : sc_uniform(s, -2, 2);
+    ctx->y_W[k] = edge == 1 ? ctx->y_W_target : sc_uniform(s, -2, 2);
+    ctx->z_W[k] = edge == 1 ? ctx->z_W_target : sc_uniform(s, -2, 2);
+    if (edge == 2)
+        ctx->x_S[k] = ctx->y_S[k] = ctx->z_S[k] = 0;
+    else
+    {
+        ctx->x_S[k] = sc_gauss(s, 1);
+        ctx->y_S[k] = sc_gauss(s, 1);
+        ctx->z_S[k] = sc_gauss(s, 1);
+        float n = sqrtf(ctx->x_S[k] * ctx->x_S[k] + ctx->y_S[k] * ctx->y_S[k] + ctx->z_S[k] * ctx->z_S[k]);
+        ctx->x_S[k] /= n;
+        ctx->y_S[k] /= n;
+        ctx->z_S[k] /= n;
+    }
+    ctx->x_Bt[k] = sc_gauss(s, 50);
+    ctx->y_Bt[k] = sc_gauss(s, 50);
+    ctx->z_Bt[k] = sc_gauss(s, 50);
+    ctx->x_Bt[k0] = edge == 3 ? 0 : sc_gauss(s, 50);
+    ctx->y_Bt[k0] = edge == 3 ? 0 : sc_gauss(s, 50);
+    ctx->z_Bt[k0] = edge == 3 ? 0 : sc_gauss(s, 50);
+    ctx->t_Bt[k0] = sc_rand(s) % (1ULL << 40);
+    ctx->t_Bt[k] = ctx->t_Bt[k0] + (edge == 4 ? 0 : DETUMBLE_TIME_STEP / 2 + sc_rand(s) % (2 * DETUMBLE_TIME_STEP)); // jittered sample spacing
+}
+
+/**
+ * @brief Checks the batched kernels against the scalar path on n random contexts,
+ * and compares the throughput of the two.
+ *
+ * @return int Number of lanes that differ from the scalar path
+ */
+static int mc_verify(int n, uint64_t seed)
+{
+    n = (n + ACS_BATCH_LANES - 1) / ACS_BATCH_LANES * ACS_BATCH_LANES;
+    acs_ctx *ctx = (acs_ctx *)malloc(n * sizeof(acs_ctx));
+    acs_batch *b = (acs_batch *)aligned_alloc(_Alignof(acs_batch), n / ACS_BATCH_LANES * sizeof(acs_batch)); // vector members need the alignment of the SIMD registers
+    if (ctx == NULL || b == NULL)
+    {
+        perror("Montecarlo: Allocation failed");
+        return -1;
+    }
+    uint64_t s = seed;
+    for (int i = 0; i < n; i++)
+        mc_verify_ctx(&s, &ctx[i]);
+    for (int i = 0; i < n; i++)
+        acs_batch_load(&b[i / ACS_BATCH_LANES], i % ACS_BATCH_LANES, &ctx[i]);
+
+    int bad_omega = 0, bad_detumble = 0, bad_sunpoint = 0;
+    for (int g = 0; g < n / ACS_BATCH_LANES; g++)
+    {
+        acs_batch bo = b[g];
+        acs_batch_cmd dcmd, scmd;
+        acs_batch_omega(&bo);
+        acs_batch_detumble(&b[g], &dcmd);
+        acs_batch_sunpoint(&b[g], &scmd);
+        for (int i = 0; i < ACS_BATCH_LANES; i++)
+        {
+            acs_ctx *c = &ctx[g * ACS_BATCH_LANES + i];
+            acs_cmd d, sp;
+            memset(&d, 0, sizeof(acs_cmd));
+            memset(&sp, 0, sizeof(acs_cmd));
+            detumbleCommand(c, &d);
+            sunpointCommand(c, &sp);
+            if (d.x_fire != dcmd.x_fire[i] || d.y_fire != dcmd.y_fire[i] || d.z_fire != dcmd.z_fire[i] ||
+                d.x_firingCmd != dcmd.x_firingCmd[i] || d.y_firingCmd != dcmd.y_firingCmd[i] || d.z_firingCmd != dcmd.z_firingCmd[i])
+            {
+                if (bad_detumble++ == 0)
+                    fprintf(stderr, "Verify: detumble differs: scalar %d %d %d %d %d %d, batch %d %d %d %d %d %d\n", d.x_fire, d.y_fire, d.z_fire, d.x_firingCmd, d.y_firingCmd, d.z_firingCmd,
+                            dcmd.x_fire[i], dcmd.y_fire[i], dcmd.z_fire[i], dcmd.x_firingCmd[i], dcmd.y_firingCmd[i], dcmd.z_firingCmd[i]);
+            }
+            if (sp.z_fire != scmd.z_fire[i] || sp.time_on != scmd.time_on[i])
+            {
+                if (bad_sunpoint++ == 0)
+                    fprintf(stderr, "Verify: sunpoint differs: scalar %d %d, batch %d %d\n", sp.z_fire, sp.time_on, scmd.z_fire[i], scmd.time_on[i]);
+            }
+#ifndef ACS_EKF // the Kalman filter has no batched kernel, the batched path runs it through acs_update()
+            // an identity filter leaves the unfiltered omega in the buffer
+#ifdef BESSEL_IIR
+            bessel_iir_init(&c->filter, 0, 0);
+#else
+            memset(c->bessel_coeff, 0, sizeof(c->bessel_coeff));
+            c->bessel_coeff[0] = 1;
+            bessel_fir_init(&c->filter, c->bessel_coeff);
+#endif
+            getOmega(c);
+            int k = c->omega_index;
+            float w[3] = {bo.x_W[i], bo.y_W[i], bo.z_W[i]};
+            if (memcmp(&w[0], &c->x_W[k], sizeof(float)) || memcmp(&w[1], &c->y_W[k], sizeof(float)) || memcmp(&w[2], &c->z_W[k], sizeof(float)))
+            {
+                if (bad_omega++ == 0)
+                    fprintf(stderr, "Verify: omega differs: scalar %a %a %a, batch %a %a %a\n", c->x_W[k], c->y_W[k], c->z_W[k], w[0], w[1], w[2]);
+            }
+#endif // ACS_EKF
+        }
+    }
+    printf("Verify: %d contexts, %d lanes: omega %d, detumble %d, sunpoint %d lanes differ from the scalar path\n", n, ACS_BATCH_LANES, bad_omega, bad_detumble, bad_sunpoint);
+
+    // throughput of the command calculation, the contexts are restored to a valid omega index first
+    for (int i = 0; i < n; i++)
+        ctx[i].omega_index = ctx[i].sol_index;
+    int rounds = 1 + 20000000 / n;
+    volatile int sink = 0;
+    uint64_t t0 = get_usec();
+    for (int r = 0; r < rounds; r++)
+        for (int i = 0; i < n; i++)
+        {
+            acs_cmd d, sp;
+            detumbleCommand(&ctx[i], &d);
+            sunpointCommand(&ctx[i], &sp);
+            sink += d.x_firingCmd + sp.time_on;
+        }
+    uint64_t t1 = get_usec();
+    for (int r = 0; r < rounds; r++)
+        for (int g = 0; g < n / ACS_BATCH_LANES; g++)
+        {
+            acs_batch_cmd dcmd, scmd;
+            acs_batch_detumble(&b[g], &dcmd);
+            acs_batch_sunpoint(&b[g], &scmd);
+            sink += dcmd.x_firingCmd[0] + scmd.time_on[0];
+        }
+    uint64_t t2 = get_usec();
+    double scalar = (t1 - t0) * 1e3 / ((double)rounds * n), batch = (t2 - t1) * 1e3 / ((double)rounds * n);
+    printf("Verify: detumble + sunpoint command: scalar %.1f ns, batch %.1f ns per context (%.2fx)\n", scalar, batch, scalar / batch);
+    (void)sink;
+    free(ctx);
+    free(b);
+    return bad_omega + bad_detumble + bad_sunpoint;
+}
+
+static int dcompare(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+#ifndef ACS_EKF
+/**
+ * @brief Cycle at which the gyroscope drops out in mc_verify_dropout(), after the
+ * buffers filled up with gyroscope readings.
+ *
+ */
+#define MC_DROPOUT_CYCLE 110
+/**
+ * @brief Largest median change of the angular speed across a gyroscope dropout, relative
+ * to the last gyroscope reading, accepted by mc_verify_dropout(). A filter history left
+ * stale by the gyroscope cycles pulls the estimate towards zero, a change close to 1.
+ *
+ */
+#define MC_DROPOUT_TOL 0.7
+
+/**
+ * @brief Checks the angular speed estimate across a gyroscope dropout: up to n scenarios
+ * run with the gyroscope until MC_DROPOUT_CYCLE, where one reading is lost and the angular
+ * speed is estimated from the magnetic field through the filter history of the gyroscope
+ * cycles before.
+ *
+ * @return int 1 if the median change from the last gyroscope reading exceeds MC_DROPOUT_TOL, 0 otherwise
+ */
+static int mc_verify_dropout(int n, uint64_t seed)
+{
+    mc_opts o = {.seed = seed, .max_time = 3600, .W_max = 0.5, .moi_pert = 0.05, .B_noise_max = 5, .CSS_noise_max = 50, .G_noise = 0.001, .G_bias_max = 0, .cutoff_min = 3, .cutoff_max = 8};
+    mc_lane *l = (mc_lane *)malloc(sizeof(mc_lane));
+    double *err = (double *)malloc(n * sizeof(double));
+    if (l == NULL || err == NULL)
+    {
+        perror("Montecarlo: Allocation failed");
+        free(l);
+        free(err);
+        return 1;
+    }
+    int runs = 0;
+    for (int idx = 0; idx < n; idx++)
+    {
+        mc_result r;
+        if (!mc_begin(&o, idx, &r, l))
+            continue;
+        acs_input in;
+        memset(&in, 0, sizeof(acs_input));
+        for (int k = 0; k <= MC_DROPOUT_CYCLE && mc_sense(l, &in); k++)
+        {
+            if (k == MC_DROPOUT_CYCLE)
+            {
+                in.gyro = 0; // lost reading
+                acs_step(&l->ctx, &in, l->t);
+                int i = l->ctx.omega_index;
+                int prev = (i + SH_BUFFER_SIZE - 1) % SH_BUFFER_SIZE; // last gyroscope reading
+                double dw[3] = {l->ctx.x_W[i] - l->ctx.x_W[prev], l->ctx.y_W[i] - l->ctx.y_W[prev], l->ctx.z_W[i] - l->ctx.z_W[prev]};
+                double w = sqrt(l->ctx.x_W[prev] * l->ctx.x_W[prev] + l->ctx.y_W[prev] * l->ctx.y_W[prev] + l->ctx.z_W[prev] * l->ctx.z_W[prev]);
+                err[runs++] = sqrt(dw[0] * dw[0] + dw[1] * dw[1] + dw[2] * dw[2]) / w;
+                break;
+            }
+            acs_cmd cmd = acs_step(&l->ctx, &in, l->t);
+            mc_actuate(l, &cmd);
+        }
+    }
+    qsort(err, runs, sizeof(double), dcompare);
+    double err_med = runs > 0 ? err[runs / 2] : 0;
+    printf("Verify: %d gyroscope dropouts at cycle %d: omega changes by %.3f (median) relative to the last reading, limit %.2f\n", runs, MC_DROPOUT_CYCLE, err_med, MC_DROPOUT_TOL);
+    free(err);
+    free(l);
+    return err_med > MC_DROPOUT_TOL;
+}
+#endif // ACS_EKF
+
+/**
+ * @brief Prints count, mean and percentiles of the non-negative values in arr.
+ * Sorts arr in place.
+ *
+ */
+static void mc_print_stat(const char *name, double arr[], int n, int total)
+{
+    int m = 0;
+    double sum = 0;
+    for (int i = 0; i < n; i++)
+        if (arr[i] >= 0)
+        {
+            arr[m++] = arr[i];
+            sum += arr[i];
+        }
+    if (m == 0)
+    {
+        printf("%-24s %5d/%-5d %10s\n", name, 0, total, "-");
+        return;
+    }
+    qsort(arr, m, sizeof(double), dcompare);
+    printf("%-24s %5d/%-5d %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n", name, m, total, sum / m, arr[0], arr[m / 2], arr[(int)(0.9 * (m - 1))], arr[(int)(0.99 * (m - 1))], arr[m - 1]);
+}
+
+static const char *mode_names[MC_NUM_MODES] = {"DETUMBLE", "SUNPOINT", "NIGHT", "READY", "XBAND_READY"};
+
+int main(int argc, char *argv[])
+{
+    mc_opts o = {
+        .runs = 1000,
+        .threads = sysconf(_SC_NPROCESSORS_ONLN),
+        .max_time = 16 * 3600,
+        .seed = 1,
+        .W_max = 0.5,
+        .moi_pert = 0.05,
+        .B_noise_max = 5,
+        .CSS_noise_max = 50,
+        .G_noise = -1,
+        .G_bias_max = 0.02,
+        .cutoff_min = 3,
+        .cutoff_max = 8,
+        .csv = NULL,
+        .batch = 0,
+    };
+    int c, verify = 0;
+    while ((c = getopt(argc, argv, "n:j:t:s:w:m:b:c:g:G:f:F:o:BVh")) != -1)
+    {
+        switch (c)
+        {
+        case 'n':
+            o.runs = atoi(optarg);
+            break;
+        case 'j':
+            o.threads = atoi(optarg);
+            break;
+        case 't':
+            o.max_time = atof(optarg);
+            break;
+        case 's':
+            o.seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'w':
+            o.W_max = atof(optarg);
+            break;
+        case 'm':
+            o.moi_pert = atof(optarg);
+            break;
+        case 'b':
+            o.B_noise_max = atof(optarg);
+            break;
+        case 'c':
+            o.CSS_noise_max = atof(optarg);
+            break;
+        case 'g':
+            o.G_noise = atof(optarg);
+            break;
+        case 'G':
+            o.G_bias_max = atof(optarg);
+            break;
+        case 'f':
+            o.cutoff_min = atof(optarg);
+            break;
+        case 'F':
+            o.cutoff_max = atof(optarg);
+            break;
+        case 'o':
+            o.csv = optarg;
+            break;
+        case 'B':
+            o.batch = 1;
+            break;
+        case 'V':
+            verify = 1;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [options]\n"
+                            "\t-n: Number of scenarios (%d)\n"
+                            "\t-j: Number of threads (number of cores)\n"
+                            "\t-t: Maximum simulated time per scenario, in s (%.0f)\n"
+                            "\t-s: Campaign seed (%llu)\n"
+                            "\t-w: Maximum initial angular speed per axis, in rad/s (%.2f)\n"
+                            "\t-m: Maximum relative perturbation of the MOI table (%.2f)\n"
+                            "\t-b: Maximum magnetometer noise, in mG (%.1f)\n"
+                            "\t-c: Maximum coarse sun sensor noise, in lux (%.1f)\n"
+                            "\t-g: Gyroscope noise, in rad/s, negative for no gyroscope (%.3f)\n"
+                            "\t-G: Maximum gyroscope bias per axis, in rad/s (%.3f)\n"
+                            "\t-f, -F: Range of the Bessel cutoff (%.1f - %.1f)\n"
+                            "\t-o: Write per scenario results as CSV\n"
+                            "\t-B: Run %d scenarios in lockstep per thread with the batched control law\n"
+                            "\t-V: Check the batched control law against the scalar path on -n random contexts, the angular speed across gyroscope dropouts, and exit\n",
+                    argv[0], o.runs, o.max_time, (unsigned long long)o.seed, o.W_max, o.moi_pert, o.B_noise_max, o.CSS_noise_max, o.G_noise, o.G_bias_max, o.cutoff_min, o.cutoff_max, ACS_BATCH_LANES);
+            return c == 'h' ? 0 : -1;
+        }
+    }
+    if (o.runs < 1 || o.max_time <= 0 || o.cutoff_min <= 0 || o.cutoff_max < o.cutoff_min)
+    {
+        fprintf(stderr, "Montecarlo: Invalid options\n");
+        return -1;
+    }
+    if (verify)
+    {
+        int bad = mc_verify(o.runs, o.seed);
+#ifndef ACS_EKF // the Kalman filter carries the angular speed across a dropout itself
+        bad += mc_verify_dropout(o.runs < 200 ? o.runs : 200, o.seed);
+#endif
+        return bad == 0 ? 0 : 1;
+    }
+    if (o.threads < 1)
+        o.threads = 1;
+    if (o.threads > o.runs)
+        o.threads = o.runs;
+
+    mc_campaign camp = {.o = &o, .next = 0};
+    camp.res = (mc_result *)calloc(o.runs, sizeof(mc_result));
+    pthread_t *thr = (pthread_t *)calloc(o.threads, sizeof(pthread_t));
+    double *arr = (double *)calloc(o.runs, sizeof(double));
+    if (camp.res == NULL || thr == NULL || arr == NULL)
+    {
+        perror("Montecarlo: Allocation failed");
+        return -1;
+    }
+    printf("Montecarlo: %d scenarios of at most %.0f s on %d threads%s, seed %llu\n", o.runs, o.max_time, o.threads, o.batch ? " (batched)" : "", (unsigned long long)o.seed);
+    fflush(stdout);
+    uint64_t wall = get_usec();
+    int nthr = 0;
+    for (; nthr < o.threads; nthr++)
+        if (pthread_create(&thr[nthr], NULL, mc_worker, &camp) != 0)
+        {
+            perror("Montecarlo: Could not create worker");
+            break;
+        }
+    if (nthr == 0)
+        mc_worker(&camp);
+    for (int i = 0; i < nthr; i++)
+        pthread_join(thr[i], NULL);
+    wall = get_usec() - wall;
+
+    double simulated = 0;
+    int transition[MC_NUM_MODES][MC_NUM_MODES] = {0};
+    for (int i = 0; i < o.runs; i++)
+    {
+        simulated += camp.res[i].t_end;
+        for (int j = 0; j < MC_NUM_MODES; j++)
+            for (int k = 0; k < MC_NUM_MODES; k++)
+                transition[j][k] += camp.res[i].transition[j][k];
+    }
+    printf("Simulated %.1f h in %.1f s (%.0fx real time)\n\n", simulated / 3600, wall * 1e-6, simulated / (wall * 1e-6));
+    printf("%-24s %11s %10s %10s %10s %10s %10s %10s\n", "", "reached", "mean", "min", "p50", "p90", "p99", "max");
+    for (int i = 0; i < o.runs; i++)
+        arr[i] = camp.res[i].t_detumble;
+    mc_print_stat("time to detumble (s)", arr, o.runs, o.runs);
+    for (int i = 0; i < o.runs; i++)
+        arr[i] = camp.res[i].t_ready;
+    mc_print_stat("time to ACS_READY (s)", arr, o.runs, o.runs);
+    for (int i = 0; i < o.runs; i++)
+        arr[i] = camp.res[i].on_time;
+    mc_print_stat("torquer on time (s)", arr, o.runs, o.runs);
+    for (int i = 0; i < o.runs; i++)
+        arr[i] = camp.res[i].energy;
+    mc_print_stat("coil energy (J)", arr, o.runs, o.runs);
+    for (int i = 0; i < o.runs; i++)
+        arr[i] = camp.res[i].transitions;
+    mc_print_stat("mode transitions", arr, o.runs, o.runs);
+    for (int i = 0; i < o.runs; i++)
+        arr[i] = camp.res[i].flushes;
+    mc_print_stat("buffer flushes", arr, o.runs, o.runs);
+
+    printf("\nMode transitions (from \\ to):\n%-12s", "");
+    for (int k = 0; k < MC_NUM_MODES; k++)
+        printf(" %11s", mode_names[k]);
+    printf("\n");
+    for (int j = 0; j < MC_NUM_MODES; j++)
+    {
+        printf("%-12s", mode_names[j]);
+        for (int k = 0; k < MC_NUM_MODES; k++)
+            printf(" %11d", transition[j][k]);
+        printf("\n");
+    }
+
+    if (o.csv != NULL)
+    {
+        FILE *fp = fopen(o.csv, "w");
+        if (fp == NULL)
+            perror("Montecarlo: Could not open CSV");
+        else
+        {
+            fprintf(fp, "run,wx0,wy0,wz0,Ixx,Iyy,Izz,B_noise,CSS_noise,cutoff,t_detumble,t_ready,t_end,on_time,energy,transitions,flushes\n");
+            for (int i = 0; i < o.runs; i++)
+            {
+                mc_result *r = &camp.res[i];
+                fprintf(fp, "%d,%f,%f,%f,%f,%f,%f,%f,%f,%f,%.1f,%.1f,%.1f,%.3f,%.3f,%d,%d\n", i, r->p.W0[0], r->p.W0[1], r->p.W0[2], r->p.MOI[0][0], r->p.MOI[1][1], r->p.MOI[2][2], r->p.B_noise, r->p.CSS_noise, r->cutoff, r->t_detumble, r->t_ready, r->t_end, r->on_time, r->energy, r->transitions, r->flushes);
+            }
+            fclose(fp);
+        }
+    }
+    free(camp.res);
+    free(thr);
+    free(arr);
+    return 0;
+}
@@ -0,0 +1,252 @@
+/**
+ * @file spacecraft.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Rigid body, orbit, magnetic field and sensor model of the satellite.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include "spacecraft.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * @brief Rotates a vector from body to inertial frame, v = q b q*.
+ *
+ */
+static inline void rotate(const double q[4], const double b[3], double v[3])
+{
+    double w = q[0], x = q[1], y = q[2], z = q[3];
+    v[0] = (1 - 2 * (y * y + z * z)) * b[0] + 2 * (x * y - w * z) * b[1] + 2 * (x * z + w * y) * b[2];
+    v[1] = 2 * (x * y + w * z) * b[0] + (1 - 2 * (x * x + z * z)) * b[1] + 2 * (y * z - w * x) * b[2];
+    v[2] = 2 * (x * z - w * y) * b[0] + 2 * (y * z + w * x) * b[1] + (1 - 2 * (x * x + y * y)) * b[2];
+}
+
+/**
+ * @brief Rotates a vector from inertial to body frame, b = q* v q.
+ *
+ */
+static inline void rotate_inv(const double q[4], const double v[3], double b[3])
+{
+    double qc[4] = {q[0], -q[1], -q[2], -q[3]};
+    rotate(qc, v, b);
+}
+
+/**
+ * @brief Position of the satellite on the circular orbit, in m.
+ *
+ */
+static inline void orbit_position(const sc_params *p, double t, double r[3])
+{
+    double a = SC_EARTH_RADIUS + p->altitude;
+    double u = p->phase + sqrt(SC_EARTH_MU / (a * a * a)) * t;
+    r[0] = a * cos(u);
+    r[1] = a * sin(u) * cos(p->inclination);
+    r[2] = a * sin(u) * sin(p->inclination);
+}
+
+/**
+ * @brief Magnetic field of the (aligned) dipole model in inertial frame, in milliGauss.
+ *
+ */
+static inline void field_inertial(const sc_params *p, double t, double B[3])
+{
+    double r[3];
+    orbit_position(p, t, r);
+    double rn = sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+    double k = SC_DIPOLE_B0 * pow(SC_EARTH_RADIUS / rn, 3);
+    double rz = r[2] / rn;                 // m = -z, so m.r = -rz
+    B[0] = k * (-3 * rz * r[0] / rn);      // 3 (m.r) r - m
+    B[1] = k * (-3 * rz * r[1] / rn);
+    B[2] = k * (-3 * rz * r[2] / rn + 1);
+}
+
+/**
+ * @brief Time derivative of the attitude and angular speed under the given inertial field and dipole.
+ *
+ */
+static inline void derivative(const spacecraft *sc, const double q[4], const double W[3], const double Bi[3], const double m[3], double dq[4], double dW[3])
+{
+    double B[3], L[3], tau[3];
+    rotate_inv(q, Bi, B);
+    for (int i = 0; i < 3; i++)
+        B[i] *= 1e-7; // milliGauss to Tesla
+    tau[0] = m[1] * B[2] - m[2] * B[1]; // tau = m x B
+    tau[1] = m[2] * B[0] - m[0] * B[2];
+    tau[2] = m[0] * B[1] - m[1] * B[0];
+    for (int i = 0; i < 3; i++)
+        L[i] = sc->p.MOI[i][0] * W[0] + sc->p.MOI[i][1] * W[1] + sc->p.MOI[i][2] * W[2];
+    tau[0] -= W[1] * L[2] - W[2] * L[1]; // tau - w x Iw
+    tau[1] -= W[2] * L[0] - W[0] * L[2];
+    tau[2] -= W[0] * L[1] - W[1] * L[0];
+    for (int i = 0; i < 3; i++)
+        dW[i] = sc->IMOI[i][0] * tau[0] + sc->IMOI[i][1] * tau[1] + sc->IMOI[i][2] * tau[2];
+    dq[0] = 0.5 * (-q[1] * W[0] - q[2] * W[1] - q[3] * W[2]); // q' = q (0, w) / 2
+    dq[1] = 0.5 * (q[0] * W[0] + q[2] * W[2] - q[3] * W[1]);
+    dq[2] = 0.5 * (q[0] * W[1] + q[3] * W[0] - q[1] * W[2]);
+    dq[3] = 0.5 * (q[0] * W[2] + q[1] * W[1] - q[2] * W[0]);
+}
+
+/**
+ * @brief Integrates the state by one RK4 step. The inertial field is evaluated
+ * at the start, middle and end of the step.
+ *
+ */
+static inline void rk4(spacecraft *sc, double h)
+{
+    double m[3], B0[3], Bh[3], B1[3];
+    double t = sc->t * 1e-6;
+    for (int i = 0; i < 3; i++)
+        m[i] = sc->torquer[i] * DIPOLE_MOMENT;
+    field_inertial(&sc->p, t, B0);
+    field_inertial(&sc->p, t + 0.5 * h, Bh);
+    field_inertial(&sc->p, t + h, B1);
+
+    double q[4], W[3], kq[4][4], kW[4][3];
+    derivative(sc, sc->q, sc->W, B0, m, kq[0], kW[0]);
+    for (int i = 0; i < 4; i++)
+        q[i] = sc->q[i] + 0.5 * h * kq[0][i];
+    for (int i = 0; i < 3; i++)
+        W[i] = sc->W[i] + 0.5 * h * kW[0][i];
+    derivative(sc, q, W, Bh, m, kq[1], kW[1]);
+    for (int i = 0; i < 4; i++)
+        q[i] = sc->q[i] + 0.5 * h * kq[1][i];
+    for (int i = 0; i < 3; i++)
+        W[i] = sc->W[i] + 0.5 * h * kW[1][i];
+    derivative(sc, q, W, Bh, m, kq[2], kW[2]);
+    for (int i = 0; i < 4; i++)
+        q[i] = sc->q[i] + h * kq[2][i];
+    for (int i = 0; i < 3; i++)
+        W[i] = sc->W[i] + h * kW[2][i];
+    derivative(sc, q, W, B1, m, kq[3], kW[3]);
+    for (int i = 0; i < 4; i++)
+        sc->q[i] += h / 6 * (kq[0][i] + 2 * kq[1][i] + 2 * kq[2][i] + kq[3][i]);
+    for (int i = 0; i < 3; i++)
+        sc->W[i] += h / 6 * (kW[0][i] + 2 * kW[1][i] + 2 * kW[2][i] + kW[3][i]);
+    double n = sqrt(sc->q[0] * sc->q[0] + sc->q[1] * sc->q[1] + sc->q[2] * sc->q[2] + sc->q[3] * sc->q[3]);
+    for (int i = 0; i < 4; i++)
+        sc->q[i] /= n;
+}
+
+uint64_t sc_rand(uint64_t *s)
+{
+    uint64_t z = (*s += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+double sc_uniform(uint64_t *s, double min, double max)
+{
+    return min + (max - min) * ((sc_rand(s) >> 11) * (1.0 / 9007199254740992.0)); // 53 bit mantissa
+}
+
+double sc_gauss(uint64_t *s, double sigma)
+{
+    double u1 = sc_uniform(s, 0, 1), u2 = sc_uniform(s, 0, 1);
+    if (u1 < 1e-300)
+        u1 = 1e-300;
+    return sigma * sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+int sc_init(spacecraft *sc, const sc_params *p)
+{
+    memset(sc, 0, sizeof(spacecraft));
+    memcpy(&sc->p, p, sizeof(sc_params));
+    const double(*I)[3] = p->MOI;
+    // inverse by cofactors
+    double c00 = I[1][1] * I[2][2] - I[1][2] * I[2][1];
+    double c01 = I[1][2] * I[2][0] - I[1][0] * I[2][2];
+    double c02 = I[1][0] * I[2][1] - I[1][1] * I[2][0];
+    double det = I[0][0] * c00 + I[0][1] * c01 + I[0][2] * c02;
+    if (fabs(det) < 1e-12)
+        return -1;
+    sc->IMOI[0][0] = c00 / det;
+    sc->IMOI[1][0] = c01 / det;
+    sc->IMOI[2][0] = c02 / det;
+    sc->IMOI[0][1] = (I[0][2] * I[2][1] - I[0][1] * I[2][2]) / det;
+    sc->IMOI[1][1] = (I[0][0] * I[2][2] - I[0][2] * I[2][0]) / det;
+    sc->IMOI[2][1] = (I[0][1] * I[2][0] - I[0][0] * I[2][1]) / det;
+    sc->IMOI[0][2] = (I[0][1] * I[1][2] - I[0][2] * I[1][1]) / det;
+    sc->IMOI[1][2] = (I[0][2] * I[1][0] - I[0][0] * I[1][2]) / det;
+    sc->IMOI[2][2] = (I[0][0] * I[1][1] - I[0][1] * I[1][0]) / det;
+    double n = sqrt(p->q0[0] * p->q0[0] + p->q0[1] * p->q0[1] + p->q0[2] * p->q0[2] + p->q0[3] * p->q0[3]);
+    for (int i = 0; i < 4; i++)
+        sc->q[i] = p->q0[i] / n;
+    memcpy(sc->W, p->W0, sizeof(sc->W));
+    sc->rng = p->seed;
+    return 1;
+}
+
+void sc_advance(spacecraft *sc, uint64_t t)
+{
+    while (sc->t < t)
+    {
+        uint64_t dt = t - sc->t;
+        if (dt > SC_INTEGRATION_STEP)
+            dt = SC_INTEGRATION_STEP;
+        rk4(sc, dt * 1e-6);
+        for (int i = 0; i < 3; i++)
+            if (sc->torquer[i])
+                sc->torquer_on[i] += dt;
+        sc->t += dt;
+    }
+}
+
+void sc_set_torquer(spacecraft *sc, int x, int y, int z)
+{
+    sc->torquer[0] = x;
+    sc->torquer[1] = y;
+    sc->torquer[2] = z;
+}
+
+int sc_eclipse(const spacecraft *sc)
+{
+    double r[3];
+    orbit_position(&sc->p, sc->t * 1e-6, r);
+    const double *s = sc->p.sun;
+    double rs = r[0] * s[0] + r[1] * s[1] + r[2] * s[2];
+    if (rs > 0) // sun side of the Earth
+        return 0;
+    double r2 = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+    return (r2 - rs * rs) < SC_EARTH_RADIUS * SC_EARTH_RADIUS;
+}
+
+void sc_sense(spacecraft *sc, acs_input *in)
+{
+    double Bi[3], B[3], S[3];
+    field_inertial(&sc->p, sc->t * 1e-6, Bi);
+    rotate_inv(sc->q, Bi, B);
+    in->status = 1;
+    in->fault = 0;
+    in->x_B = B[0] + sc_gauss(&sc->rng, sc->p.B_noise);
+    in->y_B = B[1] + sc_gauss(&sc->rng, sc->p.B_noise);
+    in->z_B = B[2] + sc_gauss(&sc->rng, sc->p.B_noise);
+    in->t_B = sc->t;
+
+    int dark = sc_eclipse(sc);
+    rotate_inv(sc->q, sc->p.sun, S);
+    // sensor normals: +x, -x, +y, -y, +z, and four sensors on -z
+    const double dir[9] = {S[0], -S[0], S[1], -S[1], S[2], -S[2], -S[2], -S[2], -S[2]};
+    for (int i = 0; i < 9; i++)
+    {
+        double lux = (dark || dir[i] < 0) ? 0 : SC_SUN_LUX * dir[i];
+        lux += sc_gauss(&sc->rng, sc->p.CSS_noise);
+        in->CSS[i] = lux < 0 ? 0 : lux;
+    }
+    in->FSS[0] = 90; // sun outside the field of view
+    in->FSS[1] = 90;
+    in->gyro = sc->p.G_noise >= 0;
+    if (in->gyro)
+    {
+        in->x_G = sc->W[0] + sc->p.G_bias[0] + sc_gauss(&sc->rng, sc->p.G_noise);
+        in->y_G = sc->W[1] + sc->p.G_bias[1] + sc_gauss(&sc->rng, sc->p.G_noise);
+        in->z_G = sc->W[2] + sc->p.G_bias[2] + sc_gauss(&sc->rng, sc->p.G_noise);
+    }
+    else
+    {
+        in->x_G = in->y_G = in->z_G = 0;
+    }
+}
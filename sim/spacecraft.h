@@ -0,0 +1,153 @@
+/**
+ * @file spacecraft.h
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Rigid body, orbit, magnetic field and sensor model of the satellite,
+ * used to close the loop around the ACS control law in simulation.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#ifndef SIM_SPACECRAFT_H
+#define SIM_SPACECRAFT_H
+#include <acs_core.h>
+#include <stdint.h>
+
+/**
+ * @brief Radius of the Earth, in m
+ *
+ */
+#define SC_EARTH_RADIUS 6371.2e3
+/**
+ * @brief Gravitational parameter of the Earth, in m^3 s^-2
+ *
+ */
+#define SC_EARTH_MU 3.986004418e14
+/**
+ * @brief Equatorial field strength of the dipole model at the surface, in milliGauss
+ *
+ */
+#define SC_DIPOLE_B0 312.0 // 31.2 uT
+/**
+ * @brief Coarse sun sensor reading when the sensor faces the sun, in lux
+ *
+ */
+#define SC_SUN_LUX 5000.0
+/**
+ * @brief Maximum integration step of the rigid body dynamics, in usec
+ *
+ */
+#define SC_INTEGRATION_STEP 10000 // 10 ms
+
+/**
+ * @brief Orbit, initial condition and sensor noise of one simulated scenario.
+ *
+ */
+typedef struct
+{
+    double MOI[3][3];   ///< True moment of inertia of the satellite (SI)
+    double W0[3];       ///< Initial angular speed in body frame (rad/s)
+    double q0[4];       ///< Initial attitude quaternion (w, x, y, z), body to inertial
+    double altitude;    ///< Altitude of the circular orbit, in m
+    double inclination; ///< Inclination of the orbit, in rad
+    double phase;       ///< Initial argument of latitude, in rad
+    double sun[3];      ///< Sun direction in inertial frame (unit vector)
+    double B_noise;     ///< Standard deviation of the magnetometer noise, in milliGauss
+    double CSS_noise;   ///< Standard deviation of the coarse sun sensor noise, in lux
+    double G_noise;     ///< Standard deviation of the gyroscope noise, in rad/s, negative for no gyroscope
+    double G_bias[3];   ///< Bias of the gyroscope, in rad/s
+    uint64_t seed;      ///< Seed of the sensor noise generator
+} sc_params;
+
+/**
+ * @brief State of one simulated satellite.
+ *
+ */
+typedef struct
+{
+    sc_params p;               ///< Parameters of the scenario
+    double IMOI[3][3];         ///< Inverse of the true moment of inertia
+    double q[4];               ///< Attitude quaternion (w, x, y, z), body to inertial
+    double W[3];               ///< Angular speed in body frame (rad/s)
+    uint64_t t;                ///< Time of the state, in usec since the start of the scenario
+    int torquer[3];            ///< Current state of the torquers (-1, 0, +1 per axis)
+    uint64_t torquer_on[3];    ///< Accumulated on time of the torquers per axis, in usec
+    uint64_t rng;              ///< State of the sensor noise generator
+} spacecraft;
+
+/**
+ * @brief Returns the next number of a splitmix64 sequence.
+ *
+ * @param s State of the generator
+ * @return uint64_t Pseudorandom number
+ */
+uint64_t sc_rand(uint64_t *s);
+
+/**
+ * @brief Returns a uniformly distributed random number.
+ *
+ * @param s State of the generator
+ * @param min Lower limit
+ * @param max Upper limit
+ * @return double Random number in [min, max)
+ */
+double sc_uniform(uint64_t *s, double min, double max);
+
+/**
+ * @brief Returns a normally distributed random number (Box-Muller).
+ *
+ * @param s State of the generator
+ * @param sigma Standard deviation
+ * @return double Random number with zero mean
+ */
+double sc_gauss(uint64_t *s, double sigma);
+
+/**
+ * @brief Initializes the satellite state from the scenario parameters.
+ *
+ * @param sc Pointer to the satellite
+ * @param p Scenario parameters
+ * @return int 1 on success, -1 if the moment of inertia is singular
+ */
+int sc_init(spacecraft *sc, const sc_params *p);
+
+/**
+ * @brief Integrates the rigid body dynamics under the current torquer state
+ * up to the given time. Does nothing if the time is in the past.
+ *
+ * @param sc Pointer to the satellite
+ * @param t Time to integrate to, in usec since the start of the scenario
+ */
+void sc_advance(spacecraft *sc, uint64_t t);
+
+/**
+ * @brief Changes the state of the torquers. The caller has to advance the
+ * dynamics to the time of the change with sc_advance() first.
+ *
+ * @param sc Pointer to the satellite
+ * @param x Direction of the X torquer (-1, 0, +1)
+ * @param y Direction of the Y torquer (-1, 0, +1)
+ * @param z Direction of the Z torquer (-1, 0, +1)
+ */
+void sc_set_torquer(spacecraft *sc, int x, int y, int z);
+
+/**
+ * @brief Checks if the satellite is in the shadow of the Earth (cylindrical shadow).
+ *
+ * @param sc Pointer to the satellite
+ * @return int 1 in eclipse, 0 in sunlight
+ */
+int sc_eclipse(const spacecraft *sc);
+
+/**
+ * @brief Generates noisy sensor readings from the current state, in the units
+ * the acquisition stage of the flight software produces. The fine sun sensor
+ * is reported as not seeing the sun. The gyroscope is read only if its noise is
+ * not negative, so scenarios without it draw the same noise sequence.
+ *
+ * @param sc Pointer to the satellite
+ * @param in Readings for the control law
+ */
+void sc_sense(spacecraft *sc, acs_input *in);
+#endif // SIM_SPACECRAFT_H
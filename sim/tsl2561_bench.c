@@ -0,0 +1,160 @@
+/**
+ * @file tsl2561_bench.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Checks the batched lux conversion of the coarse sun sensors bit for bit against
+ * tsl2561_calc_lux(), and benchmarks the two on the nine sensors of one acquisition.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include <tsl2561.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * @brief Returns the next number of a xorshift64 sequence.
+ *
+ */
+static inline uint64_t bench_rand(uint64_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+/**
+ * @brief Monotonic time in nanoseconds.
+ *
+ */
+static inline uint64_t bench_nsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Timing register values of the conversion.
+ *
+ */
+static const uint8_t bench_timing[] = {
+    TSL2561_INTEGRATIONTIME_13MS | TSL2561_GAIN_1X,
+    TSL2561_INTEGRATIONTIME_13MS | TSL2561_GAIN_16X,
+    TSL2561_INTEGRATIONTIME_101MS | TSL2561_GAIN_1X,
+    TSL2561_INTEGRATIONTIME_101MS | TSL2561_GAIN_16X,
+    TSL2561_INTEGRATIONTIME_402MS | TSL2561_GAIN_1X,
+    TSL2561_INTEGRATIONTIME_402MS | TSL2561_GAIN_16X,
+};
+#define BENCH_TIMINGS (sizeof(bench_timing) / sizeof(bench_timing[0]))
+
+/**
+ * @brief Converts the measurements with both paths.
+ *
+ * @return long Number of measurements that differ
+ */
+static long bench_check(const tsl2561_lux_table *tab, uint32_t measure[], uint8_t timing[], uint32_t lux[], int n)
+{
+    long diff = 0;
+    tsl2561_calc_lux_batch(tab, measure, timing, lux, n);
+    for (int i = 0; i < n; i++)
+    {
+        uint32_t ref = tsl2561_calc_lux(measure[i], timing[i]);
+        if (ref != lux[i] && diff++ == 0)
+            fprintf(stderr, "TSL2561 bench: broadband %u, ir %u, timing 0x%02x: %u lux, batched %u lux\n", measure[i] >> 16, measure[i] & 0xffff, timing[i], ref, lux[i]);
+    }
+    return diff;
+}
+
+int main(int argc, char *argv[])
+{
+    long samples = argc > 1 ? atol(argv[1]) : 10000000;
+    if (samples < 1)
+    {
+        fprintf(stderr, "Usage: %s [number of random samples >= 1]\n", argv[0]);
+        return -1;
+    }
+    tsl2561_lux_table tab[9];
+    for (int k = 0; k < 9; k++)
+        tsl2561_lux_table_init(&tab[k], 1);
+    uint32_t measure[9], lux[9];
+    uint8_t timing[9];
+    long diff = 0, checked = 0;
+    int n = 0;
+    // all channel pairs up to past the clipping threshold at 13.7 ms, both gains
+    for (int g = 0; g < 2; g++)
+    {
+        for (uint32_t ch0 = 0; ch0 <= TSL2561_CLIPPING_13MS + 1; ch0++)
+        {
+            for (uint32_t ch1 = 0; ch1 <= TSL2561_CLIPPING_13MS + 1; ch1++)
+            {
+                measure[n] = ch0 << 16 | ch1;
+                timing[n] = bench_timing[g];
+                if (++n == 9)
+                {
+                    diff += bench_check(tab, measure, timing, lux, n);
+                    checked += n;
+                    n = 0;
+                }
+            }
+        }
+    }
+    // random channel pairs at all timings, ir mostly below broadband as in sunlight
+    uint64_t s = 0x9e3779b97f4a7c15ULL;
+    for (long i = 0; i < samples; i++)
+    {
+        uint64_t r = bench_rand(&s);
+        uint32_t ch0 = r & 0xffff, ch1 = (r >> 16) & 0xffff;
+        if (r & (1ULL << 32))
+            ch1 = ch0 ? ch1 % (ch0 + 1) : 0;
+        measure[n] = ch0 << 16 | ch1;
+        timing[n] = bench_timing[(r >> 40) % BENCH_TIMINGS];
+        if (++n == 9)
+        {
+            diff += bench_check(tab, measure, timing, lux, n);
+            checked += n;
+            n = 0;
+        }
+    }
+    printf("%ld conversions checked, %ld differ\n", checked, diff);
+
+    // time per acquisition of nine sensors, in sunlight at 13.7 ms
+    enum
+    {
+        BENCH_SETS = 4096
+    };
+    static uint32_t m[BENCH_SETS][9], out[BENCH_SETS][9];
+    static uint8_t t[BENCH_SETS][9];
+    for (int i = 0; i < BENCH_SETS; i++)
+    {
+        for (int k = 0; k < 9; k++)
+        {
+            uint64_t r = bench_rand(&s);
+            uint32_t ch0 = r % (TSL2561_CLIPPING_13MS + 1);
+            m[i][k] = ch0 << 16 | (uint32_t)((r >> 32) % (ch0 + 1));
+            t[i][k] = bench_timing[(r >> 48) & 1];
+        }
+    }
+    int rounds = 200;
+    volatile uint64_t sink = 0; // keeps the conversions
+    uint64_t t0 = bench_nsec();
+    for (int r = 0; r < rounds; r++)
+        for (int i = 0; i < BENCH_SETS; i++)
+            for (int k = 0; k < 9; k++)
+                sink += out[i][k] = tsl2561_calc_lux(m[i][k], t[i][k]);
+    uint64_t t1 = bench_nsec();
+    for (int r = 0; r < rounds; r++)
+        for (int i = 0; i < BENCH_SETS; i++)
+            tsl2561_calc_lux_batch(tab, m[i], t[i], out[i], 9);
+    uint64_t t2 = bench_nsec();
+    for (int i = 0; i < BENCH_SETS; i++)
+        sink += out[i][0];
+    printf("%-26s %12s\n", "conversion", "ns per set");
+    printf("%-26s %12.1f\n", "tsl2561_calc_lux() x 9", (double)(t1 - t0) / rounds / BENCH_SETS);
+    printf("%-26s %12.1f\n", "tsl2561_calc_lux_batch()", (double)(t2 - t1) / rounds / BENCH_SETS);
+    return diff == 0 ? 0 : 1;
+}
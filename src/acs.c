@@ -12,6 +12,14 @@
 #include <acs.h>              // prototypes for thread-local functions and variables only
 #include <main.h>             // loop control
 #include <bessel.h>           // bessel filter prototypes
+#include <acs_clock.h>        // clock backend for the ACS loop
+#include <acs_sched.h>        // absolute deadline scheduler for the ACS loop
+#include <acs_torquer.h>      // event timeline of the magnetorquers
+#include <acs_acq.h>          // sun sensor acquisition triple buffer
+#include <acs_hist.h>         // latency histograms of the ACS cycle
+#include <acs_overrun.h>      // degraded cycle policy
+#include <acs_record.h>       // input recording for replay
+#include <sh_time.h>          // UTC stamps of the data log
 #include <sitl_comm_extern.h> // Variables shared with serial communication thread
 #include <datavis_extern.h>   // variables shared with DataVis thread
 #include <ads1115.h>
@@ -19,9 +27,12 @@
 #include <ncv7708.h>
 #include <tsl2561.h>
 #include <tca9458a.h>
+#include <gpio_event.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <errno.h>
 
 /**
  * @brief This is color indicator for printf statements in ACS, for use in debug only."
@@ -56,179 +67,151 @@ pthread_cond_t data_available;
 pthread_mutex_t data_check;
 
 /**
- * @brief This variable is unset by the ACS thread at first execution.
+ * @brief Condition variable to wake up the torquer thread when a timeline is submitted.
  * 
  */
-volatile int first_run = 1;
-
-// SITL
+pthread_cond_t torquer_ready = PTHREAD_COND_INITIALIZER;
 /**
- * @brief Declares vector to store magnetic field reading from serial.
+ * @brief Condition variable to wake up the ACS thread when the torquer thread is idle.
  * 
  */
-DECLARE_VECTOR(g_readB, unsigned short); // storage to put helmhotz values
+pthread_cond_t torquer_idle = PTHREAD_COND_INITIALIZER;
 /**
- * @brief Fine sun sensor angles read over serial.
+ * @brief Mutex for locking on torquer_ready and torquer_idle.
  * 
  */
-unsigned short g_readFS[2]; // storage to put FS X and Y angles
+pthread_mutex_t torquer_lock = PTHREAD_MUTEX_INITIALIZER;
 /**
- * @brief Coarse sun sensor lux values read over serial.
+ * @brief Timeline submitted to the torquer thread.
  * 
  */
-unsigned short g_readCS[9]; // storage to put CS led brightnesses
+acs_timeline g_torquer_timeline;
 /**
- * @brief Magnetorquer command, format: 0b00ZZYYXX, 00 indicates not fired, 01 indicates fire in positive dir, 10 indicates fire in negative dir.
+ * @brief Set when g_torquer_timeline holds a timeline not yet picked up by the torquer thread.
  * 
  */
-unsigned char g_Fire; // magnetorquer command
-
-// HITL
+int g_torquer_pending = 0;
 /**
- * @brief Magnetometer device struct.
+ * @brief Set while the torquer thread executes a timeline.
  * 
  */
-lsm9ds1 *mag; // magnetometer
-/**
- * @brief H-Bridge device struct.
- * 
- */
-ncv7708 *hbridge; // h-bridge
-/**
- * @brief I2C Mux device struct.
- * 
- */
-tca9458a *mux; // I2C mux
-/**
- * @brief Array of coarse sun sensor device struct.
- * 
- */
-tsl2561 **css; // coarse sun sensors
-/**
- * @brief I2C ADC struct for fine sun sensor.
- * 
- */
-ads1115 *adc; // analog to digital converters
-              // SITL
+int g_torquer_busy = 0;
 /**
- * @brief Creates buffer for \f$\vec{\omega}\f$.
+ * @brief Switching error of the events executed by the torquer thread.
  * 
  */
-DECLARE_BUFFER(g_W, float); // omega global circular buffer
-/**
- * @brief Creates buffer for \f$\vec{B}\f$.
- * 
- */
-DECLARE_BUFFER(g_B, double); // magnetic field global circular buffer
-/**
- * @brief Creates buffer for \f$\vec{\dot{B}}\f$.
- * 
- */
-DECLARE_BUFFER(g_Bt, double); // Bdot global circular buffer1
+acs_lateness g_torquer_error;
+
 /**
- * @brief Creates vector for target angular momentum.
+ * @brief Sun sensor samples from the acquisition thread to the ACS thread.
  * 
  */
-DECLARE_VECTOR(g_L_target, float); // angular momentum target vector
+acs_tbuf g_acs_sun;
 /**
- * @brief Creates vector for target angular speed.
+ * @brief Number of cycles without a recent sun sample.
  * 
  */
-DECLARE_VECTOR(g_W_target, float); // angular velocity target vector
+unsigned long long g_acs_sun_stale = 0;
+
 /**
- * @brief Creates buffer for sun vector.
+ * @brief Latency histograms of the phases of the ACS cycle, in nanoseconds. Written by
+ * the ACS thread, except ACS_HIST_SWITCH which is written by the torquer thread.
  * 
  */
-DECLARE_BUFFER(g_S, float); // sun vector
+acs_hist g_acs_hist[ACS_HIST_COUNT];
+
 /**
- * @brief Storage for current coarse sun sensor lux measurements.
+ * @brief Degraded cycle policy of the ACS thread.
  * 
  */
-float g_CSS[9]; // current CSS lux values, in HITL this will be populated by TSL2561 code
+acs_overrun g_acs_overrun;
+
 /**
- * @brief Storage for current fine sun sensor angle measurements.
+ * @brief This variable is unset by the ACS thread at first execution.
  * 
  */
-float g_FSS[2]; // current FSS angles, in rad; in HITL this will be populated by NANOSSOC A60 driver
+volatile int first_run = 1;
+
+// SITL
 /**
- * @brief Current index of the \f$\vec{B}\f$ circular buffer.
+ * @brief Declares vector to store magnetic field reading from serial.
  * 
  */
-int mag_index = -1;
+DECLARE_VECTOR(g_readB, unsigned short); // storage to put helmhotz values
 /**
- * @brief Current index of the \f$\vec{\omega}\f$ circular buffer.
+ * @brief Fine sun sensor angles read over serial.
  * 
  */
-int omega_index = -1;
+unsigned short g_readFS[2]; // storage to put FS X and Y angles
 /**
- * @brief Current index of the \f$\vec{\dot{B}}\f$ circular buffer.
+ * @brief Coarse sun sensor lux values read over serial.
  * 
  */
-int bdot_index = -1;
+unsigned short g_readCS[9]; // storage to put CS led brightnesses
 /**
- * @brief Current index of the sun vector circular buffer.
+ * @brief Magnetorquer command, format: 0b00ZZYYXX, 00 indicates not fired, 01 indicates fire in positive dir, 10 indicates fire in negative dir.
  * 
  */
-int sol_index = -1; // circular buffer indices, -1 indicates uninitiated buffer
+unsigned char g_Fire; // magnetorquer command
+
+// HITL
 /**
- * @brief Indicates if the \f$\vec{B}\f$ circular buffer is full.
+ * @brief Magnetometer device struct.
  * 
  */
-int B_full = 0;
+lsm9ds1 *mag; // magnetometer
 /**
- * @brief Indicates if the \f$\vec{\dot{B}}\f$ circular buffer is full.
+ * @brief H-Bridge device struct.
  * 
  */
-int Bdot_full = 0;
+ncv7708 *hbridge; // h-bridge
 /**
- * @brief Indicates if the \f$\vec{\omega}\f$ circular buffer is full.
+ * @brief I2C Mux device struct.
  * 
  */
-int W_full = 0;
+tca9458a *mux; // I2C mux
 /**
- * @brief Indicates if the sun vector circular buffer is full.
+ * @brief Array of coarse sun sensor device struct.
  * 
  */
-int S_full = 0; // required to deal with the circular buffer problem
+tsl2561 **css; // coarse sun sensors
 /**
- * @brief This variable is set by checkTransition() if the satellite does not detect the sun.
+ * @brief I2C ADC struct for fine sun sensor.
  * 
  */
-uint8_t g_night = 0; // night mode?
+ads1115 *adc; // analog to digital converters
 /**
- * @brief This variable contains the current state of the flight system.
+ * @brief GPIO line of the coarse sun sensor interrupts.
  * 
  */
-uint8_t g_acs_mode = 0; // Detumble by default
+gpio_event *css_int; // coarse sun sensor interrupts
+              // SITL
 /**
- * @brief This variable is unset when the system is detumbled for the first time after a power cycle.
+ * @brief Context of the control law executed by the ACS thread.
  * 
  */
-uint8_t g_first_detumble = 1; // first time detumble by default even at night
+acs_ctx g_acs;
 /**
- * @brief Counts the number of cycles on the ACS thread.
+ * @brief Mode of g_acs, published by the ACS thread after every transition for the
+ * other threads, which must not read g_acs while the ACS thread writes it.
  * 
  */
-unsigned long long acs_ct = 0; // counts the number of ACS steps
+uint8_t g_acs_mode;
 /**
- * @brief Moment of inertia of the satellite (SI).
+ * @brief Start of the current cycle in ACS thread, used to keep track of time taken by ACS loop.
  * 
  */
-float MOI[3][3] = {{0.06467720404, 0, 0},
-                   {0, 0.06474406267, 0},
-                   {0, 0, 0.07921836177}};
+unsigned long long g_t_acs;
 /**
- * @brief Inverse of the moment of inertia of the satellite (SI).
+ * @brief Clock used to time the ACS loop.
  * 
  */
-float IMOI[3][3] = {{15.461398105297564, 0, 0},
-                    {0, 15.461398105297564, 0},
-                    {0, 0, 12.623336025344317}};
+acs_clock g_acs_clock;
 /**
- * @brief Current timestamp after readSensors() in ACS thread, used to keep track of time taken by ACS loop.
+ * @brief Scheduler of the ACS loop, keeps the deadlines and lateness of every cycle.
  * 
  */
-unsigned long long g_t_acs;
+acs_sched g_acs_sched;
 
 #ifdef ACS_DATALOG
 /**
@@ -237,43 +220,14 @@ unsigned long long g_t_acs;
  */
 FILE *acs_datalog;
 #endif
-/*******************************/
-
-/**
- * @brief This function executes the detumble algorithm.
- * 
- * The detumble algorithm calculates the direction and time
- * for which the magnetorquers fire. The direction is determined
- * by first calculating the vector \f$\hat{B}\times\hat{L_0 - L}\f$,
- * which is a unit vector, and then checking which of the components have
- * a magnitude greater than 0.01. A component with magnitude greater than
- * 0.01 indicates that torquer can be fired, in the direction indicated by
- * the sign of the component. Further, the torque that is generated by
- * the firing decision is estimated for the current value of the magnetic
- * field by calculating \f$\vec{\tau}=\vec{\mu}\times\vec{B}\f$, where
- * \f$\vec{mu}\f$ is calculated by multiplying the firing direction vector
- * with the dipole moment of the magnetorquers (0.21 A\f$\cdot\f$m\f$^2\f$).
- * Then for each direction, the firing time is estimated by
- * \f$ t_i = \frac{\Delta L_i}{\tau_i}\f$. The torquer in any direction is fired
- * only if the firing time is greater than 5 ms, and any torquer is fired for
- * at most the allowed firing time. At the end of the action, all torquers
- * are turned off for the next magnetic field measurement.
- * 
- * 
- */
-static inline void detumbleAction();
-
+#ifdef ACS_RECORD
 /**
- * @brief This function executes the sunpointing algorithm.
+ * @brief ACS input recording file pointer, can be replayed using acs_replay.out.
  * 
- * The sunpointing algoritm calculates the duty cycle of the 
- * Z-magnetorquer firing. The duty cycle is determined by calculating
- * the vector \f$(\hat{S}(\hat{S}\cdot\hat{B}))\times((\hat{L}(\hat{L}\cdot\hat{B}))\f$.
- * The Z component of this vector upon normalization specifies the duty
- * cycle. However, due to lowering of efficiency as the spacecraft aligns 
- * with the sun, the gain is increased.
  */
-static inline void sunpointAction();
+FILE *acs_recordlog;
+#endif
+/*******************************/
 
 #ifndef SITL
 int hbridge_enable(int x, int y, int z)
@@ -374,310 +328,436 @@ int HBRIDGE_DISABLE(int i)
 }
 #endif // SITL
 
-void getOmega(void)
+#ifndef SITL
+/**
+ * @brief Re-initializes the magnetometer after ACS_FAULT_REINIT failed reads in a row.
+ * 
+ */
+static void reinitMag(void)
 {
-    if (mag_index < 2 && B_full == 0) // not enough measurements
-        return;
-    // once we have measurements, we declare that we proceed
-    if (omega_index == SH_BUFFER_SIZE - 1) // hit max, buffer full
-        W_full = 1;
-    omega_index = (1 + omega_index) % SH_BUFFER_SIZE;                             // calculate new index in the circular buffer
-    int8_t m0, m1;                                                                // temporary addresses
-    m1 = bdot_index;                                                              // current address
-    m0 = (bdot_index - 1) < 0 ? SH_BUFFER_SIZE - bdot_index - 1 : bdot_index - 1; // previous address, wrapped around the circular buffer
-    float freq;
-    freq = 1e6 / DETUMBLE_TIME_STEP;                     // time units!
-    CROSS_PRODUCT(g_W[omega_index], g_Bt[m1], g_Bt[m0]); // apply cross product
-    float norm2 = NORM2(g_Bt[m0]);
-    VECTOR_MIXED(g_W[omega_index], g_W[omega_index], freq / norm2, *); // omega = (B_t dot x B_t-dt dot)*freq/Norm2(B_t dot)
-    // Apply correction // There is fast runaway with this on
-    // DECLARE_VECTOR(omega_corr0, float);                            // declare temporary space for correction vector
-    // MATVECMUL(omega_corr0, MOI, g_W[m1]);                          // MOI X w[t-1]
-    // DECLARE_VECTOR(omega_corr1, float);                            // declare temporary space for correction vector
-    // CROSS_PRODUCT(omega_corr1, g_W[m1], omega_corr0);              // store into temp 1
-    // MATVECMUL(omega_corr1, IMOI, omega_corr0);                     // store back into temp 0
-    // VECTOR_MIXED(omega_corr1, omega_corr1, -freq, *);              // omega_corr = freq*(MOI-1)*(-w[t-1] X MOI*w[t-1])
-    // VECTOR_OP(g_W[omega_index], g_W[omega_index], omega_corr1, +); // add the correction term to omega
-    APPLY_FBESSEL(g_W, omega_index); // Bessel filter of order 3
-    return;
+    i2c_bus_close(mag->bus);
+    if (lsm9ds1_init(mag, 0x6b, 0x1e) < 0)
+        perror("Magnetometer re-init failed");
 }
 
-void getSVec(void)
+#ifdef CSS_READY
+static uint64_t css_ready[9] = {0}; // time the first integration at the current timing of each coarse sun sensor completes
+static tsl2561_lux_table css_lux[9];  // lux conversion of each coarse sun sensor, with its calibration gain
+
+/**
+ * @brief Re-initializes a coarse sun sensor after ACS_FAULT_REINIT failed reads in a row.
+ * The mux channel of the sensor has to be active.
+ * 
+ * @param i Mux channel of the sensor
+ * @param j Index of the sensor on the channel
+ */
+static void reinitCSS(int i, int j)
 {
-    if (sol_index == SH_BUFFER_SIZE - 1) // hit max, buffer full
-        S_full = 1;
-    sol_index = (sol_index + 1) % SH_BUFFER_SIZE;
-#ifdef SITL
-    // SITL expects radians input
-    float fsx = 180 / M_PI * g_FSS[0];
-    float fsy = 180 / M_PI * g_FSS[1];
-#else
-    // hardware reads degrees
-    float fsx = g_FSS[0];
-    float fsy = g_FSS[1];
-#endif // SITL
-#ifndef M_PI
+    i2c_bus_close(css[i * 3 + j]->bus);
+    if (tsl2561_init(css[i * 3 + j], TSL2561_ADDR_LOW + 0x10 * j) < 0)
+        fprintf(stderr, "CSS re-init failed at channel %d addr 0x%02x\n", i, TSL2561_ADDR_LOW + 0x10 * j);
+    css_ready[i * 3 + j] = acs_clock_now(&g_acs_clock) + tsl2561_integ_wait(css[i * 3 + j]->timing);
+}
+
 /**
- * @brief Approximate definition of Pi in case M_PI is not included from math.h
- */ 
-#define M_PI 3.1415
-#endif
-    // check if FSS results are acceptable
-    // if they are, use that to calculate the sun vector
-    // printf("[FSS] %.3f %.3f\n", fsx * 180. / M_PI, fsy * 180. / M_PI);
-    if (fabsf(fsx) <= 60 && fabsf(fsy) <= 60) // angle inside FOV (FOV -> 60°, half angle 30°)
+ * @brief Takes a reading of a coarse sun sensor and adapts the timing for the next
+ * reading. A reading taken before the first integration at the current timing completed
+ * is dropped, the sensor keeps its last reading. The mux channel of the sensor has to be
+ * active.
+ * 
+ * @param k Index of the sensor
+ * @param measure Reading, see tsl2561_measure()
+ * @param timing Set to the timing the reading was taken at
+ * @return 1 if the reading is taken, 0 if it is dropped
+ */
+static int harvestCSS(int k, uint32_t measure, uint8_t *timing)
+{
+    uint64_t now = acs_clock_now(&g_acs_clock);
+    if (now < css_ready[k]) // data registers still hold a reading at the previous timing
+        return 0;
+    *timing = css[k]->timing;
+    uint8_t next = tsl2561_autogain(css[k]->timing, measure);
+    if (next != css[k]->timing && tsl2561_set_timing(css[k], next) > 0 && tsl2561_start(css[k]) > 0)
+        css_ready[k] = now + tsl2561_integ_wait(next);
+    return 1;
+}
+
+/**
+ * @brief Reads the nine coarse sun sensors concurrently. While every sensor integrates for at
+ * most ACS_CSS_RESTART_MAX, the integration of all sensors is restarted in one transaction
+ * with the three mux channels enabled together (sensors with the same address on different
+ * channels take the same write) and the thread sleeps once for the longest integration;
+ * otherwise the sensors run free and the latest completed integration is read. The sensors
+ * are harvested with one transaction per mux channel: the channel select and the burst
+ * reads of its three sensors. A channel whose transaction fails is read again one sensor
+ * at a time, to find the failing sensor. The gain and integration time of each sensor are
+ * adapted to its reading (see tsl2561_autogain()), and the readings of all sensors are
+ * converted to lux in one pass (see tsl2561_calc_lux_batch()).
+ * 
+ * @param in Input to fill in the CSS readings of, a failing sensor keeps its last reading
+ */
+static void readCSS(acs_input *in)
+{
+    static int css_errors[9] = {0}; // failed reads in a row
+    struct i2c_msg msgs[1 + 3 * TSL2561_MEASURE_MSGS];
+    uint8_t buf[3][4];
+    uint32_t measure[9] = {0}, lux[9];
+    uint8_t timing[9] = {0};
+    int taken[9] = {0};
+    uint32_t wait = 0;
+    for (int k = 0; k < 9; k++)
     {
-#ifdef ACS_PRINT
-        printf("[" GRN "FSS" RST "]");
-#endif                                            // ACS_PRINT
-        x_g_S[sol_index] = tan(fsx * M_PI / 180); // Consult https://www.cubesatshop.com/wp-content/uploads/2016/06/nanoSSOC-A60-Technical-Specifications.pdf, section 4
-        y_g_S[sol_index] = tan(fsy * M_PI / 180);
-        z_g_S[sol_index] = 1;
-        NORMALIZE(g_S[sol_index], g_S[sol_index]);
-        return;
+        uint32_t w = tsl2561_integ_wait(css[k]->timing);
+        wait = w > wait ? w : wait;
     }
+    tca9458a_acquire(mux); // channel selection held until the harvest is done
+    if (wait <= ACS_CSS_RESTART_MAX)
+    {
+        tca9458a_prepare(mux, TCA9458A_CHANNEL(0) | TCA9458A_CHANNEL(1) | TCA9458A_CHANNEL(2), &msgs[0]);
+        for (int j = 0; j < 3; j++)
+            tsl2561_start_prepare(TSL2561_ADDR_LOW + 0x10 * j, &msgs[1 + j * TSL2561_START_MSGS]);
+        if (i2c_bus_transfer(mux->bus, msgs, 1 + 3 * TSL2561_START_MSGS) < 0) // the fallback below finds the failing sensor
+            perror("CSS start");
+        uint64_t now = acs_clock_now(&g_acs_clock);
+        for (int k = 0; k < 9; k++)
+            css_ready[k] = now + tsl2561_integ_wait(css[k]->timing);
+        acs_clock_sleep(&g_acs_clock, wait);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        tca9458a_prepare(mux, TCA9458A_CHANNEL(i), &msgs[0]);
+        for (int j = 0; j < 3; j++)
+            tsl2561_measure_prepare(css[i * 3 + j], &msgs[1 + j * TSL2561_MEASURE_MSGS], buf[j]);
+        if (i2c_bus_transfer(mux->bus, msgs, 1 + 3 * TSL2561_MEASURE_MSGS) > 0)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                css_errors[i * 3 + j] = 0;
+                measure[i * 3 + j] = tsl2561_measure_decode(buf[j]);
+                taken[i * 3 + j] = harvestCSS(i * 3 + j, measure[i * 3 + j], &timing[i * 3 + j]);
+            }
+            continue;
+        }
+        tca9458a_set(mux, i); // fallback, one sensor at a time
+        for (int j = 0; j < 3; j++)
+        {
+            errno = 0;                                            // unset errno
+            tsl2561_measure(css[i * 3 + j], &measure[i * 3 + j]); // make measurement
+            if (errno)                                            // soft fault, hold the last reading of this sensor
+            {
+                perror("CSS measure");
+                in->fault |= ACS_FAULT_CSS;
+                if (++css_errors[i * 3 + j] % ACS_FAULT_REINIT == 0)
+                    reinitCSS(i, j);
+                continue;
+            }
+            css_errors[i * 3 + j] = 0;
+            taken[i * 3 + j] = harvestCSS(i * 3 + j, measure[i * 3 + j], &timing[i * 3 + j]);
+        }
+    }
+    tca9458a_release(mux);
+    tsl2561_calc_lux_batch(css_lux, measure, timing, lux, 9);
+    for (int k = 0; k < 9; k++)
+    {
+        if (!taken[k])
+            continue;
+        in->CSS[k] = lux[k];
+        in->CSS_timing[k] = timing[k];
+    }
+}
 
-    // get average -Z luminosity from 4 sensors
-    float znavg = 0;
-    for (int i = 5; i < 9; i++)
-        znavg += g_CSS[i];
-    znavg *= 0.250f;
-
-    x_g_S[sol_index] = g_CSS[0] - g_CSS[1]; // +x - -x
-    y_g_S[sol_index] = g_CSS[2] - g_CSS[3]; // +x - -x
-    z_g_S[sol_index] = g_CSS[4] - znavg;    // +z - avg(-z)
+#ifdef CSS_INT
+static int css_armed = 0; // the CSS interrupts are armed and the sensors are not read
 
-    float css_mag = NORM(g_S[sol_index]); // norm of the CSS lux values
+/**
+ * @brief Configures the threshold interrupts of the nine coarse sun sensors at
+ * ACS_CSS_WAKE_LUX, in one transaction with the three mux channels enabled together. The
+ * sensors are set to TSL2561_TIMING_DEFAULT, at which the wake level is well within range.
+ * 
+ * @param control TSL2561_INTR_OFF, or TSL2561_INTR_LEVEL | persistence
+ * @return 1 on success, -1 on failure
+ */
+static int setCSSInterrupt(uint8_t control)
+{
+    struct i2c_msg msgs[1 + 3 * TSL2561_INTERRUPT_MSGS];
+    uint8_t buf[3][TSL2561_INTERRUPT_BUF];
+    uint16_t high = tsl2561_lux_threshold(ACS_CSS_WAKE_LUX, TSL2561_TIMING_DEFAULT);
+    tca9458a_acquire(mux);
+    tca9458a_prepare(mux, TCA9458A_CHANNEL(0) | TCA9458A_CHANNEL(1) | TCA9458A_CHANNEL(2), &msgs[0]);
+    for (int j = 0; j < 3; j++)
+        tsl2561_interrupt_prepare(TSL2561_ADDR_LOW + 0x10 * j, TSL2561_TIMING_DEFAULT, 0, high, control, &msgs[1 + j * TSL2561_INTERRUPT_MSGS], buf[j]);
+    int status = i2c_bus_transfer(mux->bus, msgs, 1 + 3 * TSL2561_INTERRUPT_MSGS);
+    tca9458a_release(mux);
+    if (status < 0)
+    {
+        perror("CSS interrupt");
+        return -1;
+    }
+    for (int k = 0; k < 9; k++)
+        css[k]->timing = TSL2561_TIMING_DEFAULT;
+    return 1;
+}
 
-    if (css_mag < CSS_MIN_LUX_THRESHOLD) // night time logic
+/**
+ * @brief Night watch of the coarse sun sensors. While the ACS is in night mode and all
+ * readings are below ACS_CSS_WAKE_LUX, the threshold interrupts of the sensors are armed
+ * and the acquisition thread sleeps on the interrupt line until the deadline instead of
+ * reading the sensors. An interrupt (the terminator crossing) wakes it immediately, and
+ * the sensors are read again.
+ * 
+ * @param in Last readings
+ * @param t Start of the acquisition, set to the wake time on an interrupt
+ * @param deadline Start of the next acquisition
+ * @return 1 if the sensors stayed dark and were not read, 0 if they have to be read
+ */
+static int watchCSS(const acs_input *in, uint64_t *t, uint64_t deadline)
+{
+    if (css_int == NULL)
+        return 0;
+    if (__atomic_load_n(&g_acs_mode, __ATOMIC_RELAXED) != STATE_ACS_NIGHT)
     {
-        g_night = 1;
-        VECTOR_CLEAR(g_S[sol_index]); // return 0 solar vector
-#ifdef ACS_PRINT
-        printf("[" RED "FSS" RST "]");
-#endif // ACS_PRINT
+        if (css_armed)
+            setCSSInterrupt(TSL2561_INTR_OFF);
+        css_armed = 0;
+        return 0;
     }
-    else
+    if (!css_armed)
     {
-        g_night = 0;
-        NORMALIZE(g_S[sol_index], g_S[sol_index]); // return normalized sun vector
-#ifdef ACS_PRINT
-        printf("[" YLW "FSS" RST "]");
-#endif // ACS_PRINT
+        for (int k = 0; k < 9; k++)
+            if (in->CSS[k] >= ACS_CSS_WAKE_LUX) // lit, keep reading
+                return 0;
+        gpio_event_wait(css_int, 0); // drop the edges of earlier interrupts
+        if (setCSSInterrupt(TSL2561_INTR_LEVEL | ACS_CSS_WAKE_PERSIST) < 0)
+            return 0;
+        css_armed = 1;
     }
-    // printf("[sunvec %d] %0.3f %0.3f | %0.3f %0.3f %0.3f\n", sol_index, fsx, fsy, x_g_S[sol_index], y_g_S[sol_index], z_g_S[sol_index]);
-    return;
+    uint64_t now = acs_clock_now(&g_acs_clock);
+    if (gpio_event_wait(css_int, deadline > now ? (deadline - now + 999) / 1000 : 0) == 0)
+        return 1;
+    // interrupt, or the line failed: read the sensors until the night is confirmed again
+    setCSSInterrupt(TSL2561_INTR_OFF);
+    css_armed = 0;
+    *t = acs_clock_now(&g_acs_clock);
+    return 0;
 }
+#endif // CSS_INT
+#endif // CSS_READY
+#endif // SITL
 
-int readSensors(void)
+int readMag(acs_input *in)
 {
-    // read magfield, CSS, FSS
-    // printf("In readSensors()...\n");
-    int status = 1;
-    if (mag_index == SH_BUFFER_SIZE - 1) // hit max, buffer full
-        B_full = 1;
-    mag_index = (mag_index + 1) % SH_BUFFER_SIZE;
-    VECTOR_CLEAR(g_B[mag_index]); // clear the current B
+    in->status = 1;
+    in->fault = 0;
 #ifdef SITL
+    DECLARE_VECTOR(B, double);
     pthread_mutex_lock(&serial_read);
-    VECTOR_OP(g_B[mag_index], g_B[mag_index], g_readB, +); // load B - equivalent reading from sensor
-    for (int i = 0; i < 9; i++)                            // load CSS
-        g_CSS[i] = (g_readCS[i] * 5000.0) / 0x0fff;
-    g_FSS[0] = ((g_readFS[0] * M_PI) / 65535.0) - (M_PI / 2); // load FSS angle 0
-    g_FSS[1] = ((g_readFS[1] * M_PI) / 65535.0) - (M_PI / 2); // load FSS angle 1
-    // printf("[read]%04x %04x %04x %04x %04x %04x %04x %04x %04x %04x %04x\n", g_readFS[0], g_readFS[1], g_readCS[0], g_readCS[1], g_readCS[2], g_readCS[3], g_readCS[4], g_readCS[5], g_readCS[6], g_readCS[7], g_readCS[8]);
+    VECTOR_OP(B, B, g_readB, +); // load B - equivalent reading from sensor
+    in->t_B = acs_clock_now(&g_acs_clock);
     pthread_mutex_unlock(&serial_read);
 #define B_RANGE 32767
-    VECTOR_MIXED(g_B[mag_index], g_B[mag_index], B_RANGE, -);
-    VECTOR_MIXED(g_B[mag_index], g_B[mag_index], 4e-4 * 1e7 / B_RANGE, *); // in milliGauss to have precision
-#else                                                                      // HITL
+    VECTOR_MIXED(B, B, B_RANGE, -);
+    VECTOR_MIXED(B, B, 4e-4 * 1e7 / B_RANGE, *); // in milliGauss to have precision
+    in->x_B = x_B;
+    in->y_B = y_B;
+    in->z_B = z_B;
+    in->gyro = 0; // the serial frame carries no gyroscope
+    in->x_G = in->y_G = in->z_G = 0;
+#else // HITL
+    in->gyro = 0;
+    in->x_G = in->y_G = in->z_G = 0; // no reading until the FIFO is read
+    short gyro_measure[LSM9DS1_FIFO_SIZE][3];
+    int gyro_samples = mag->gyro ? lsm9ds1_read_gyro_fifo(mag, gyro_measure, LSM9DS1_FIFO_SIZE) : 0;
+    if (mag->gyro && gyro_samples <= 0) // soft fault, omega from the magnetic field this cycle
+        in->fault |= ACS_FAULT_GYRO;
+    else if (mag->gyro)
+    {
+        long gyro_sum[3] = {0, 0, 0}; // decimate the samples queued since the last cycle to one reading
+        for (int k = 0; k < gyro_samples; k++)
+            for (int i = 0; i < 3; i++)
+                gyro_sum[i] += gyro_measure[k][i];
+        double scale = LSM9DS1_GYRO_SCALE_245 * M_PI / 180 / gyro_samples; // scaled to rad/s
+        in->gyro = 1;
+        in->x_G = (gyro_sum[0] - (long)ACS_GYRO_OFFSET_X * gyro_samples) * scale;
+        in->y_G = (gyro_sum[1] - (long)ACS_GYRO_OFFSET_Y * gyro_samples) * scale;
+        in->z_G = (gyro_sum[2] - (long)ACS_GYRO_OFFSET_Z * gyro_samples) * scale;
+    }
+    static int mag_errors = 0; // failed reads in a row
     short mag_measure[3];
-    status = lsm9ds1_read_mag(mag, mag_measure);
-    if (status < 0) // failure
-        return status;
-    x_g_B[mag_index] = mag_measure[0] / 6.842; // scaled to milliGauss
-    y_g_B[mag_index] = mag_measure[1] / 6.842;
-    z_g_B[mag_index] = mag_measure[2] / 6.842;
-    APPLY_DBESSEL(g_B, mag_index); // bessel filter
-#ifdef CSS_READY
-    for (int i = 0; i < 3; i++)
+    uint64_t t_read = acs_clock_now(&g_acs_clock);
+    int mag_status = lsm9ds1_read_mag(mag, mag_measure);
+    in->t_B = t_read + (acs_clock_now(&g_acs_clock) - t_read) / 2; // middle of the read, after the gyroscope FIFO and any wait for the bus
+    if (mag_status < 0) // soft fault, the control law skips this sample
     {
-        tca9458a_set(mux, i); // activate channel
-        for (int j = 0; j < 3; j++)
-        {
-            uint32_t measure;
-            errno = 0;                                 // unset errno
-            tsl2561_measure(css[i * 3 + j], &measure); // make measurement
-            if (errno)
-            {
-                perror("CSS measure");
-                return -1;
-            }
-            g_CSS[i * 3 + j] = tsl2561_get_lux(measure);
-        }
+        in->fault |= ACS_FAULT_MAG;
+        if (++mag_errors % ACS_FAULT_REINIT == 0)
+            reinitMag();
+        return in->status;
     }
+    mag_errors = 0;
+    in->x_B = mag_measure[0] / 6.842; // scaled to milliGauss
+    in->y_B = mag_measure[1] / 6.842;
+    in->z_B = mag_measure[2] / 6.842;
+#endif // SITL
+    return in->status;
+}
+
+int readSun(acs_input *in, int read_css)
+{
+    in->status = 1;
+    in->fault = 0;
+#ifdef SITL
+    pthread_mutex_lock(&serial_read);
+    for (int i = 0; i < 9 && read_css; i++) // load CSS
+    {
+        in->CSS[i] = (g_readCS[i] * 5000.0) / 0x0fff;
+        in->CSS_timing[i] = 0;
+    }
+    in->FSS[0] = ((g_readFS[0] * M_PI) / 65535.0) - (M_PI / 2); // load FSS angle 0
+    in->FSS[1] = ((g_readFS[1] * M_PI) / 65535.0) - (M_PI / 2); // load FSS angle 1
+    pthread_mutex_unlock(&serial_read);
+#else // HITL
+#ifdef CSS_READY
+    if (read_css)
+        readCSS(in);
 #else
     for (int i = 0; i < 9; i++)
-        g_CSS[i] = 0;
+    {
+        in->CSS[i] = 0;
+        in->CSS_timing[i] = 0;
+    }
 #endif // CSS_READY
 #ifdef FSS_READY
     // TODO: Read FSS
 #else
-    g_FSS[0] = -90;
-    g_FSS[1] = -90;
+    in->FSS[0] = -90;
+    in->FSS[1] = -90;
 #endif // FSS_READY
 #endif // SITL
-
-    // printf("readSensors: Bx: %f By: %f Bz: %f\n", x_g_B[mag_index], y_g_B[mag_index], z_g_B[mag_index]);
-    // put values into g_Bx, g_By and g_Bz at [mag_index] and takes 18 ms to do so (implemented using sleep)
-    if (mag_index < 1 && B_full == 0)
-        return status;
-    // if we have > 1 values, calculate Bdot
-    if (bdot_index == SH_BUFFER_SIZE - 1) // hit max, buffer full
-        B_full = 1;
-    bdot_index = (bdot_index + 1) % SH_BUFFER_SIZE;
-    int8_t m0, m1;
-    m1 = mag_index;
-    m0 = (mag_index - 1) < 0 ? SH_BUFFER_SIZE - mag_index - 1 : mag_index - 1;
-    double freq = 1e6 / (DETUMBLE_TIME_STEP * 1.0);
-    VECTOR_OP(g_Bt[bdot_index], g_B[m1], g_B[m0], -);
-    VECTOR_MIXED(g_Bt[bdot_index], g_Bt[bdot_index], freq, *);
-    APPLY_DBESSEL(g_Bt, bdot_index); // bessel filter
-    // APPLY_FBESSEL(g_Bt, bdot_index); // bessel filter
-    // printf("readSensors: m0: %d m1: %d Btx: %f Bty: %f Btz: %f\n", m0, m1, x_g_Bt[bdot_index], y_g_Bt[bdot_index], z_g_Bt[bdot_index]);
-    getOmega();
-    getSVec();
-    // check if any of the values are NaN. If so, return -1
-    // the NaN may stem from Bdot = 0, which may stem from the fact that during sunpointing
-    // B may align itself with Z/ω
-    if (isnan(x_g_B[mag_index]))
-        return -1;
-    if (isnan(y_g_B[mag_index]))
-        return -1;
-    if (isnan(z_g_B[mag_index]))
-        return -1;
-
-    if (isnan(x_g_W[omega_index]))
-        return -1;
-    if (isnan(y_g_W[omega_index]))
-        return -1;
-    if (isnan(z_g_W[omega_index]))
-        return -1;
-
-    if (isnan(x_g_S[sol_index]))
-        return -1;
-    if (isnan(y_g_S[sol_index]))
-        return -1;
-    if (isnan(z_g_S[sol_index]))
-        return -1;
-    return status;
+    return in->status;
 }
 
-void checkTransition(void)
+/**
+ * @brief Copies the freshest sun sample of the acquisition thread into the input. Without
+ * a sample younger than ACS_ACQ_MAX_AGE, the sun sensors read as dark (night).
+ * 
+ * @param in Input to fill in the sun sensor readings of
+ */
+static inline void mergeSun(acs_input *in)
 {
-    if (!W_full) // not enough data to take a decision
-        return;
-    if (!S_full) // not enough data to take a decision
-        return;
-    DECLARE_VECTOR(avgOmega, float);                // declare buffer to contain average value of omega
-    FAVERAGE_BUFFER(avgOmega, g_W, SH_BUFFER_SIZE); // calculate time average of omega over buffer
-    DECLARE_VECTOR(avgSun, float);                  // declare buffer to contain avg sun vector
-    VECTOR_MIXED(avgSun, g_S[sol_index], 0, +);     // current sun angle
-
-    DECLARE_VECTOR(body, float);                     // Body frame vector oriented along Z axis
-    z_body = 1;                                      // Body frame vector is Z
-    float W_target_diff = z_g_W_target - z_avgOmega; // difference of omega_z
-    NORMALIZE(avgOmega, avgOmega);                   // Normalize avg omega to get omega hat
-    float w_ang = (DOT_PRODUCT(avgOmega, body));
-    w_ang = w_ang >= 1 ? 1 : w_ang;
-    float z_w_ang = 180. * acos(w_ang) / M_PI;                     // average omega angle in degrees
-    float z_S_ang = 180. * acos(DOT_PRODUCT(avgSun, body)) / M_PI; // Sun angle in degrees
-    // printf("[state %d] dW = %.3f, Ang = %.3f, DP = %.3f, |SUN| = %.3f\n", g_acs_mode, fabs(W_target_diff), fabs(z_w_ang), DOT_PRODUCT(avgOmega, body), NORM(avgSun));
-    uint8_t next_mode = g_acs_mode;
-    if (g_acs_mode == STATE_ACS_DETUMBLE)
+    const acs_sun_sample *smp = acs_tbuf_read(&g_acs_sun, NULL);
+    if (smp->seq == 0 || acs_clock_now(&g_acs_clock) - smp->t > ACS_ACQ_MAX_AGE)
     {
-        // printf("[CASE %d] %d\n", g_acs_mode , MIN_DETUMBLE_ANGLE - z_w_ang);
-        // If detumble criterion is met, go to Sunpointing mode
-        if (fabsf(z_w_ang) < MIN_DETUMBLE_ANGLE && fabsf(W_target_diff) < OMEGA_TARGET_LEEWAY)
-        {
-            //  printf("[DETUMBLE]\n");
-            //  fflush(stdout);
-            next_mode = STATE_ACS_NIGHT;
-            g_first_detumble = 0; // when system detumbles for the first time, unsets this variable
-        }
-        if (!g_first_detumble) // if this var is unset, the system does not do anything at night
+        for (int i = 0; i < 9; i++)
         {
-            if (NORM(avgSun) < 0.8f)
-            {
-                // printf("Here!");
-                next_mode = STATE_ACS_NIGHT;
-            }
+            in->CSS[i] = 0;
+            in->CSS_timing[i] = 0;
         }
+        in->FSS[0] = -90;
+        in->FSS[1] = -90;
+        g_acs_sun_stale++;
+        return;
     }
+    if (smp->status < 0) // same as a failed read in the ACS thread
+        in->status = -1;
+    in->fault |= smp->fault;
+    memcpy(in->CSS, smp->CSS, sizeof(in->CSS));
+    memcpy(in->CSS_timing, smp->CSS_timing, sizeof(in->CSS_timing));
+    memcpy(in->FSS, smp->FSS, sizeof(in->FSS));
+}
 
-    else if (g_acs_mode == STATE_ACS_SUNPOINT)
+void *acs_acq_thread(void *id)
+{
+    acs_sched sched; // one sun sample per control period, phase independent of the ACS thread
+    acs_sched_init(&sched, &g_acs_clock);
+    i2c_bus_priority(I2C_PRIO_SENSOR); // yields the bus to the magnetometer reads of the ACS thread
+    uint64_t seq = 0;
+    acs_input in;
+    memset(&in, 0, sizeof(acs_input));
+    while (!done)
     {
-        // If detumble criterion is not held, fall back to detumbling
-        if (fabsf(z_w_ang) > MIN_DETUMBLE_ANGLE || fabsf(W_target_diff) > OMEGA_TARGET_LEEWAY * 3) // extra leeway for exact value of w_z
-        {
-            next_mode = STATE_ACS_DETUMBLE;
-        }
-        // if it is night, fall back to night mode. Should take SH_BUFFER_SIZE * DETUMBLE_TIME_STEP seconds for the actual state change to occur
-        if (NORM(avgSun) < 0.8f)
-        {
-            next_mode = STATE_ACS_NIGHT;
-        }
-        // if the satellite is detumbled, it is not night and the sun angle is less than 4 deg, declare ACS is ready
-        if (fabsf(z_S_ang) < MIN_SOL_ANGLE)
-        {
-            next_mode = STATE_ACS_READY;
-        }
+        uint64_t t = acs_sched_wait(&sched);
+        int read_css = acs_overrun_read_css(&g_acs_overrun); // keeps the last CSS readings while the ACS is overrunning
+#if !defined(SITL) && defined(CSS_READY) && defined(CSS_INT)
+        if (read_css && watchCSS(&in, &t, t + sched.period)) // dark night, slept on the interrupt line
+            read_css = 0;
+#endif
+        int status = readSun(&in, read_css);
+        acs_sun_sample *smp = acs_tbuf_back(&g_acs_sun);
+        smp->t = t;
+        smp->seq = ++seq;
+        smp->status = status;
+        smp->fault = in.fault;
+        memcpy(smp->CSS, in.CSS, sizeof(smp->CSS));
+        memcpy(smp->CSS_timing, in.CSS_timing, sizeof(smp->CSS_timing));
+        memcpy(smp->FSS, in.FSS, sizeof(smp->FSS));
+        acs_tbuf_publish(&g_acs_sun);
     }
+    pthread_exit(NULL);
+}
 
-    else if (g_acs_mode == STATE_ACS_NIGHT)
-    {
-        // printf("[NIGHT] %.3f\n", NORM(avgSun));
-        if (NORM(avgSun) > 0.8f)
-        {
-            // printf("[NIGHT] %.3f\n", NORM(avgSun));
-            if (fabsf(z_w_ang) > MIN_DETUMBLE_ANGLE || fabsf(W_target_diff) > OMEGA_TARGET_LEEWAY)
-            {
-                next_mode = STATE_ACS_DETUMBLE;
-            }
-            if (fabsf(z_S_ang) < MIN_SOL_ANGLE)
-            {
-                next_mode = STATE_ACS_READY;
-            }
-            else
-                next_mode = STATE_ACS_SUNPOINT;
-        }
-    }
+/**
+ * @brief Hands a timeline to the torquer thread.
+ * 
+ * @param tl Timeline to execute
+ */
+static inline void torquer_submit(const acs_timeline *tl)
+{
+    pthread_mutex_lock(&torquer_lock);
+    g_torquer_timeline = *tl;
+    g_torquer_pending = 1;
+    pthread_cond_signal(&torquer_ready);
+    pthread_mutex_unlock(&torquer_lock);
+}
+
+/**
+ * @brief Waits until the torquer thread has executed the submitted timeline.
+ * 
+ */
+static inline void torquer_wait(void)
+{
+    pthread_mutex_lock(&torquer_lock);
+    while ((g_torquer_pending || g_torquer_busy) && !done)
+        pthread_cond_wait(&torquer_idle, &torquer_lock);
+    pthread_mutex_unlock(&torquer_lock);
+}
 
-    else if (g_acs_mode == STATE_ACS_READY)
+void *acs_torquer_thread(void *id)
+{
+    acs_timeline tl;
+    while (!done)
     {
-        if (NORM(avgSun) < 0.8f) // transition to night
-            next_mode = STATE_ACS_NIGHT;
-        else
+        pthread_mutex_lock(&torquer_lock);
+        while (!g_torquer_pending && !done)
+            pthread_cond_wait(&torquer_ready, &torquer_lock);
+        if (done)
         {
-            if (fabsf(z_w_ang) > MIN_DETUMBLE_ANGLE || fabsf(W_target_diff) > OMEGA_TARGET_LEEWAY) // Detumble required
-            {
-                next_mode = STATE_ACS_DETUMBLE;
-            }
-            if (fabsf(z_S_ang) > MIN_SOL_ANGLE) // sunpointing required
-            {
-                next_mode = STATE_ACS_SUNPOINT;
-            }
-            else // everything good
-            {
-                next_mode = STATE_ACS_READY;
-            }
+            pthread_mutex_unlock(&torquer_lock);
+            break;
         }
+        tl = g_torquer_timeline;
+        g_torquer_pending = 0;
+        g_torquer_busy = 1;
+        pthread_mutex_unlock(&torquer_lock);
+
+        acs_timeline_run(&g_acs_clock, &tl, &g_torquer_error, &g_acs_hist[ACS_HIST_SWITCH]);
+
+        pthread_mutex_lock(&torquer_lock);
+        g_torquer_busy = 0;
+        pthread_cond_broadcast(&torquer_idle);
+        pthread_mutex_unlock(&torquer_lock);
     }
-    g_acs_mode = next_mode; // update the global state
+    hbridge_enable(0, 0, 0); // torquers off on exit
+    pthread_mutex_lock(&torquer_lock);
+    pthread_cond_broadcast(&torquer_idle); // release the ACS thread
+    pthread_mutex_unlock(&torquer_lock);
+    pthread_exit(NULL);
 }
 
 void *acs_thread(void *id)
 {
+    acs_input in;
+    memset(&in, 0, sizeof(acs_input));
+    i2c_bus_priority(I2C_PRIO_ACS); // magnetometer and gyroscope reads go first on the bus
     while (!done)
     {
         // first run indication
@@ -690,257 +770,99 @@ void *acs_thread(void *id)
             pthread_cond_wait(&data_available, &data_check);
 #endif // SITL
         }
-        unsigned long long s = get_usec();
-        /* TODO: Soft- and hard- errors: All errors do not require a buffer reset, e.g. a CSS read error */
-        if (readSensors() < 0) // error in readSensors
-        {
-            // Flush all buffers
-            FLUSH_BUFFER(g_B);
-            mag_index = -1;
-            B_full = 0;
-
-            FLUSH_BUFFER(g_Bt);
-            bdot_index = -1;
-
-            FLUSH_BUFFER(g_W);
-            omega_index = -1;
-            W_full = 0;
-
-            FLUSH_BUFFER(g_S);
-            sol_index = -1;
-            S_full = 0;
-            /*
-             * Fall back into night mode which is the safe mode
-             * NOTE: Since the buffers are empty at this point, 
-             * checkTransition() will not be called. Hence, 
-             * after flushing the buffer the system will spend
-             * 64 cycles reading the sensors.
-             * 
-             * TODO: Add more checks and do a system reboot if
-             * such a state persists.
-             */
-            g_acs_mode = STATE_ACS_NIGHT;
-        }
-        //time_t now ; time(&now);
-        if (omega_index >= 0)
+        unsigned long long s = acs_sched_wait(&g_acs_sched); // start of the cycle on an absolute deadline
+        torquer_wait();                                      // torquers are off before the field is measured
+        uint64_t h0 = acs_hist_now();
+        readMag(&in);                                        // acquire magnetic field
+        mergeSun(&in);                                       // latest sun sensor readings from the acquisition thread
+        // execute the control law, acs_step() split up for the latency of each part
+        acs_cmd cmd;
+        uint64_t h1 = acs_hist_now();
+        acs_estimate(&g_acs, &in, in.t_B, &cmd);
+        uint64_t h2 = acs_hist_now();
+        checkTransition(&g_acs);
+        __atomic_store_n(&g_acs_mode, g_acs.mode, __ATOMIC_RELAXED); // for the night watch of the acquisition thread
+        uint64_t h3 = acs_hist_now();
+        acs_command(&g_acs, &cmd);
+        uint64_t h4 = acs_hist_now();
+        acs_hist_add(&g_acs_hist[ACS_HIST_SENSE], h1 - h0);
+        acs_hist_add(&g_acs_hist[ACS_HIST_ESTIMATE], h2 - h1);
+        acs_hist_add(&g_acs_hist[ACS_HIST_TRANSITION], h3 - h2);
+        acs_hist_add(&g_acs_hist[ACS_HIST_COMMAND], h4 - h3);
+        if (g_t_acs > 0)
+            acs_hist_add(&g_acs_hist[ACS_HIST_PERIOD], (s - g_t_acs) * 1000);
+#ifdef ACS_PRINT
+        if (g_acs.sun_source == ACS_SUN_FSS)
+            printf("[" GRN "FSS" RST "]");
+        else if (g_acs.sun_source == ACS_SUN_NIGHT)
+            printf("[" RED "FSS" RST "]");
+        else if (g_acs.sun_source == ACS_SUN_CSS)
+            printf("[" YLW "FSS" RST "]");
+#endif // ACS_PRINT
+        if (g_acs.omega_index >= 0)
         {
 #ifdef ACS_PRINT
 #ifdef SITL
-            printf("[%.3f ms][%.3f ms][%llu][%d] | Wx = %.3e Wy = %.3e Wz = %.3e\n", comm_time / 1000.0, (s - g_t_acs) / 1000.0, acs_ct++, g_acs_mode, x_g_W[omega_index], y_g_W[omega_index], z_g_W[omega_index]);
+            printf("[%.3f ms][%.3f ms][%+lld us][%llu][%d] | Wx = %.3e Wy = %.3e Wz = %.3e\n", comm_time / 1000.0, (s - g_t_acs) / 1000.0, (long long)g_acs_sched.lateness[ACS_PHASE_MEASURE].last, g_acs.step, g_acs.mode, g_acs.x_W[g_acs.omega_index], g_acs.y_W[g_acs.omega_index], g_acs.z_W[g_acs.omega_index]);
 #else
-            printf("[%.3f ms][%llu][%d] | Wx = %.3e Wy = %.3e Wz = %.3e\n", (s - g_t_acs) / 1000.0, acs_ct++, g_acs_mode, x_g_W[omega_index], y_g_W[omega_index], z_g_W[omega_index]);
+            printf("[%.3f ms][%+lld us][%llu][%d] | Wx = %.3e Wy = %.3e Wz = %.3e\n", (s - g_t_acs) / 1000.0, (long long)g_acs_sched.lateness[ACS_PHASE_MEASURE].last, g_acs.step, g_acs.mode, g_acs.x_W[g_acs.omega_index], g_acs.y_W[g_acs.omega_index], g_acs.z_W[g_acs.omega_index]);
 #endif // SITL
 #endif // ACS_PRINT
 #ifdef DATAVIS
+            int mag_index = g_acs.mag_index, bdot_index = g_acs.bdot_index, omega_index = g_acs.omega_index, sol_index = g_acs.sol_index;
             // Update datavis variables [DO NOT TOUCH]
-            g_datavis_st.data.step = acs_ct;
-            g_datavis_st.data.mode = g_acs_mode;
-            g_datavis_st.data.x_B = x_g_B[mag_index];
-            g_datavis_st.data.y_B = y_g_B[mag_index];
-            g_datavis_st.data.z_B = z_g_B[mag_index];
-            g_datavis_st.data.x_Bt = x_g_Bt[bdot_index];
-            g_datavis_st.data.y_Bt = y_g_Bt[bdot_index];
-            g_datavis_st.data.z_Bt = z_g_Bt[bdot_index];
-            g_datavis_st.data.x_W = x_g_W[omega_index];
-            g_datavis_st.data.y_W = y_g_W[omega_index];
-            g_datavis_st.data.z_W = z_g_W[omega_index];
-            g_datavis_st.data.x_S = x_g_S[sol_index];
-            g_datavis_st.data.y_S = y_g_S[sol_index];
-            g_datavis_st.data.z_S = z_g_S[sol_index];
+            g_datavis_st.data.step = g_acs.step;
+            g_datavis_st.data.mode = g_acs.mode;
+            g_datavis_st.data.x_B = g_acs.x_B[mag_index];
+            g_datavis_st.data.y_B = g_acs.y_B[mag_index];
+            g_datavis_st.data.z_B = g_acs.z_B[mag_index];
+            g_datavis_st.data.x_Bt = g_acs.x_Bt[bdot_index];
+            g_datavis_st.data.y_Bt = g_acs.y_Bt[bdot_index];
+            g_datavis_st.data.z_Bt = g_acs.z_Bt[bdot_index];
+            g_datavis_st.data.x_W = g_acs.x_W[omega_index];
+            g_datavis_st.data.y_W = g_acs.y_W[omega_index];
+            g_datavis_st.data.z_W = g_acs.z_W[omega_index];
+            g_datavis_st.data.x_S = g_acs.x_S[sol_index];
+            g_datavis_st.data.y_S = g_acs.y_S[sol_index];
+            g_datavis_st.data.z_S = g_acs.z_S[sol_index];
+            for (int i = 0; i < ACS_HIST_COUNT; i++) // latencies in usec
+            {
+                g_datavis_st.data.lat_p50[i] = acs_hist_percentile(&g_acs_hist[i], 50) * 1e-3;
+                g_datavis_st.data.lat_p99[i] = acs_hist_percentile(&g_acs_hist[i], 99) * 1e-3;
+                g_datavis_st.data.lat_max[i] = acs_hist_max(&g_acs_hist[i]) * 1e-3;
+            }
             // wake up datavis thread [DO NOT TOUCH]
             pthread_cond_broadcast(&datavis_drdy);
 #endif
         }
 #ifdef ACS_DATALOG
-        fprintf(acs_datalog, "%llu %d %e %e %e %e %e %e %e %e %e\n", acs_ct, g_acs_mode, x_g_B[mag_index], y_g_B[mag_index], z_g_B[mag_index], x_g_W[omega_index], y_g_W[omega_index], z_g_W[omega_index], x_g_S[sol_index], y_g_S[sol_index], z_g_S[sol_index]);
+        if (g_acs.omega_index >= 0)
+        {
+            int mag_index = g_acs.mag_index, omega_index = g_acs.omega_index, sol_index = g_acs.sol_index;
+            fprintf(acs_datalog, "%llu %llu %d %e %e %e %e %e %e %e %e %e\n", (unsigned long long)sh_time_utc(s), g_acs.step, g_acs.mode, g_acs.x_B[mag_index], g_acs.y_B[mag_index], g_acs.z_B[mag_index], g_acs.x_W[omega_index], g_acs.y_W[omega_index], g_acs.z_W[omega_index], g_acs.x_S[sol_index], g_acs.y_S[sol_index], g_acs.z_S[sol_index]);
+        }
 #endif
-        //    printf("%s ACS step: %llu | Wx = %f Wy = %f Wz = %f\n", ctime(&now), acs_ct++ , x_g_W[omega_index], y_g_W[omega_index], z_g_W[omega_index]);
+#ifdef ACS_RECORD
+        acs_record_write(acs_recordlog, in.t_B, &in, &cmd);
+#endif // ACS_RECORD
         g_t_acs = s;
-        checkTransition(); // check if the system should transition from one state to another
-        unsigned long long e = get_usec();
-        /* TODO: In case a read takes longer, reduce ACS action time in order to conserve loop time */
-        int sleep_time = MEASURE_TIME - e + s;
-        sleep_time = sleep_time > 0 ? sleep_time : 0;
-        usleep(sleep_time); // sleep for total 20 ms with read
-        if (g_acs_mode == STATE_ACS_DETUMBLE)
-            detumbleAction();
-        else if (g_acs_mode == STATE_ACS_SUNPOINT)
-            sunpointAction();
-        else
-            usleep(DETUMBLE_TIME_STEP - MEASURE_TIME);
+        acs_sched_decided(&g_acs_sched); // measure and decide have to be done within MEASURE_TIME
+        // the torquer thread executes the window, which ends on time even if the measurement overran
+        uint64_t h5 = acs_hist_now();
+        acs_timeline tl;
+        uint64_t start = acs_sched_handoff(&g_acs_sched);
+        acs_timeline_build(&cmd, start, &tl);
+        acs_overrun_window(&g_acs_overrun, acs_clock_now(&g_acs_clock), &tl, start); // shrink or skip the window after an overrun
+        torquer_submit(&tl);
+#ifndef SITL
+        // keep housekeeping traffic off the bus while the next cycle measures
+        i2c_bus_quiet(mag->bus, g_acs_sched.t0 + g_acs_sched.period, g_acs_sched.t0 + g_acs_sched.period + g_acs_sched.offset[ACS_PHASE_ACTUATE]);
+#endif // SITL
+        acs_hist_add(&g_acs_hist[ACS_HIST_ACTUATE], acs_hist_now() - h5);
     }
     pthread_exit(NULL);
 }
 
-static inline void detumbleAction(void)
-{
-    if (omega_index < 0)
-    {
-        usleep(DETUMBLE_TIME_STEP - MEASURE_TIME);
-    }
-    else
-    {
-        DECLARE_VECTOR(currL, double);           // vector for current angular momentum
-        MATVECMUL(currL, MOI, g_W[omega_index]); // calculate current angular momentum
-        VECTOR_OP(currL, g_L_target, currL, -);  // calculate angular momentum error
-        DECLARE_VECTOR(currLNorm, float);
-        NORMALIZE(currLNorm, currL); // normalize the angular momentum error vector
-        // printf("Norm L error: %lf %lf %lf\n", x_currLNorm, y_currLNorm, z_currLNorm);
-        DECLARE_VECTOR(currB, double);    // current normalized magnetic field TMP
-        NORMALIZE(currB, g_B[mag_index]); // normalize B
-        // printf("Norm B: %lf %lf %lf\n", x_currB, y_currB, z_currB);
-        DECLARE_VECTOR(firingDir, float);           // firing direction vector
-        CROSS_PRODUCT(firingDir, currB, currLNorm); // calculate firing direction
-        // printf("Firing Dir: %lf %lf %lf\n", x_firingDir, y_firingDir, z_firingDir);
-        // printf("Abs Firing Dir: %lf %lf %lf\n", x_firingDir*(x_firingDir < 0 ? -1 : 1), y_firingDir*(y_firingDir < 0 ? -1 : 1), z_firingDir*(z_firingDir < 0 ? -1 : 1));
-        int8_t x_fire = (x_firingDir < 0 ? -1 : 1);                        // if > 0.01, then fire in the direction of input
-        int8_t y_fire = (y_firingDir < 0 ? -1 : 1);                        // * (abs(y_firingDir) > 0.01 ? 1 : 0); // if > 0.01, then fire in the direction of input
-        int8_t z_fire = (z_firingDir < 0 ? -1 : 1);                        // * (abs(z_firingDir) > 0.01 ? 1 : 0); // if > 0.01, then fire in the direction of input
-        x_fire *= x_firingDir * (x_firingDir < 0 ? -1 : 1) > 0.01 ? 1 : 0; // if > 0.01, then fire in the direction of input
-        y_fire *= y_firingDir * (y_firingDir < 0 ? -1 : 1) > 0.01 ? 1 : 0; // if > 0.01, then fire in the direction of input
-        z_fire *= z_firingDir * (z_firingDir < 0 ? -1 : 1) > 0.01 ? 1 : 0; // if > 0.01, then fire in the direction of input
-        // printf("Fire: %d %d %d\n", x_fire, y_fire, z_fire);
-        DECLARE_VECTOR(currDipole, float);
-        VECTOR_MIXED(currDipole, fire, DIPOLE_MOMENT * 1e-7, *); // calculate dipole moment, account for B in milliGauss
-        // printf("Dipole: %f %f %f\n", x_currDipole, y_currDipole, z_currDipole );
-        DECLARE_VECTOR(currTorque, float);
-        CROSS_PRODUCT(currTorque, currDipole, g_B[mag_index]); // calculate current torque
-        // printf("Torque: %f %f %f\n", x_currTorque, y_currTorque, z_currTorque );
-        DECLARE_VECTOR(firingTime, float);           // initially gives firing time in seconds
-        VECTOR_OP(firingTime, currL, currTorque, /); // calculate firing time based on current torque
-        // printf("Firing time (s): %f %f %f\n", x_firingTime, y_firingTime, z_firingTime );
-        VECTOR_MIXED(firingTime, firingTime, 1000000, *); // convert firing time to usec
-        DECLARE_VECTOR(firingCmd, int);                   // integer firing time in usec
-        x_firingCmd = x_firingTime > MAX_DETUMBLE_FIRING_TIME ? MAX_DETUMBLE_FIRING_TIME : (x_firingTime < MIN_DETUMBLE_FIRING_TIME ? 0 : (int)x_firingTime);
-        y_firingCmd = y_firingTime > MAX_DETUMBLE_FIRING_TIME ? MAX_DETUMBLE_FIRING_TIME : (y_firingTime < MIN_DETUMBLE_FIRING_TIME ? 0 : (int)y_firingTime);
-        z_firingCmd = z_firingTime > MAX_DETUMBLE_FIRING_TIME ? MAX_DETUMBLE_FIRING_TIME : (z_firingTime < MIN_DETUMBLE_FIRING_TIME ? 0 : (int)z_firingTime);
-        // printf("Firing Time: %d %d %d\n", x_firingTime, y_firingTime, z_firingTime);
-        int firingOrder[3] = {0, 1, 2}, firingTime[3]; // 0 == x, 1 == y, 2 == z
-        firingTime[0] = x_firingCmd;
-        firingTime[1] = y_firingCmd;
-        firingTime[2] = z_firingCmd;
-        // printf("Firing Time: %d %d %d\n", firingTime[0], firingTime[1], firingTime[2]);
-        insertionSort(firingTime, firingOrder); // sort firing order based on firing time
-        int finalWait = MAX_DETUMBLE_FIRING_TIME - firingTime[2];
-        firingTime[2] -= firingTime[1];                // time after second one turns off
-        firingTime[1] -= firingTime[0];                // time after first one turns off
-        HBRIDGE_ENABLE(fire);                          // Turns on the torque coils in the required directions determined by the fire vector
-        usleep(firingTime[0] < 1 ? 1 : firingTime[0]); // sleep until first turnoff
-        HBRIDGE_DISABLE(firingOrder[0]);               // first turn off
-        usleep(firingTime[1] < 1 ? 1 : firingTime[1]); // sleep until second turnoff
-        HBRIDGE_DISABLE(firingOrder[1]);               // second turnoff
-        usleep(firingTime[2] < 1 ? 1 : firingTime[2]); // sleep until third turnoff
-        HBRIDGE_DISABLE(firingOrder[2]);               // third turnoff
-        usleep(finalWait < 1 ? 1 : finalWait);         // sleep for the remainder of the cycle
-        HBRIDGE_DISABLE(0);
-        HBRIDGE_DISABLE(1);
-        HBRIDGE_DISABLE(2);
-    }
-}
-
-static inline void sunpointAction(void)
-{
-    // printf("[Sunpoint Action]\n");
-    // fflush(stdout);
-    if (sol_index < 0)
-    {
-        // printf("[Sunpoint Action Invalid, sleep]\n");
-        usleep(DETUMBLE_TIME_STEP - MEASURE_TIME);
-    }
-    else
-    {
-        DECLARE_VECTOR(currB, float);
-        DECLARE_VECTOR(currBNorm, float);
-        DECLARE_VECTOR(currL, float);
-        //DECLARE_VECTOR(currLNorm, float) ;
-        DECLARE_VECTOR(currS, float);
-        DECLARE_VECTOR(currSNorm, float);
-        // printf("[Sunpoint Action] %d\n", __LINE__);
-        VECTOR_OP(currB, currB, g_B[mag_index], +); // get current magfield
-        NORMALIZE(currBNorm, currB);                // normalize current magfield
-        MATVECMUL(currL, MOI, g_W[omega_index]);    // calculate current angular momentum
-        VECTOR_OP(currS, currS, g_S[sol_index], +); // get current sunvector
-        NORMALIZE(currSNorm, currS);                // normalize sun vector
-        // printf("[Sunpoint Action] %d\n", __LINE__);
-        // calculate S_B_hat
-        DECLARE_VECTOR(SBHat, float);
-        float SdotB = DOT_PRODUCT(currSNorm, currBNorm);
-        VECTOR_MIXED(SBHat, currBNorm, SdotB, *);
-        VECTOR_OP(SBHat, currSNorm, SBHat, +);
-        NORMALIZE(SBHat, SBHat);
-        // printf("[Sunpoint Action] %d\n", __LINE__);
-        // calculate L_B_hat
-        DECLARE_VECTOR(LBHat, float);
-        float LdotB = DOT_PRODUCT(currL, currBNorm);
-        VECTOR_MIXED(LBHat, currBNorm, LdotB, *);
-        VECTOR_OP(LBHat, currL, LBHat, +);
-        NORMALIZE(LBHat, LBHat);
-        // printf("[Sunpoint Action] %d\n", __LINE__);
-        // cross product the two vectors
-        DECLARE_VECTOR(SxBxL, float);
-        CROSS_PRODUCT(SxBxL, SBHat, LBHat);
-        NORMALIZE(SxBxL, SxBxL);
-        // printf("[Sunpoint Action] %d\n", __LINE__);
-        float sun_ang = fabs(z_g_S[sol_index]);
-        uint8_t gain = round(sun_ang * 32);
-        gain = gain < 1 ? 1 : gain;                                                      // do not allow gain to be lower than one
-        int time_on = (int)(DOT_PRODUCT(SxBxL, currBNorm) * SUNPOINT_DUTY_CYCLE * gain); // essentially a duty cycle measure
-#ifdef SUNPOINT_DEBUG
-        printf("[SUNPOINT] %d", time_on);
-#endif // SUNPOINT_DEBUG
-        int dir = time_on > 0 ? 1 : -1;
-        time_on = time_on > 0 ? time_on : -time_on;
-        time_on = time_on > SUNPOINT_DUTY_CYCLE ? SUNPOINT_DUTY_CYCLE : time_on; // safety measure
-        if (time_on < 5000 && time_on > 2499)
-            time_on = 5000;
-        time_on = 10000 * round(time_on / 10000.0f); // added rounding to increase gain
-        time_on /= 5000;
-        time_on *= 5000; // granularity of 5 ms, essentially 5 bit precision
-#ifdef SUNPOINT_DEBUG
-        printf("[SUNPOINT] %d\n", time_on);
-#endif // SUNPOINT_DEBUG
-        int time_off = SUNPOINT_DUTY_CYCLE - time_on;
-        int FiringTime = COARSE_TIME_STEP - MEASURE_TIME; // time allowed to fire
-        DECLARE_VECTOR(fire, int);
-        z_fire = dir; // z direction is the only direction of fire
-        // printf("[Sunpoint Action] %d %d\n", __LINE__, FiringTime);
-        while (FiringTime > 0)
-        {
-            // printf("[Sunpoint Action] %d %d %d %d\n", __LINE__, FiringTime, time_on, time_off);
-            HBRIDGE_ENABLE(fire);
-            usleep(time_on);
-            if (time_off > 0)
-            {
-                HBRIDGE_DISABLE(2); // 3 == executes default, turns off ALL hbridges (safety)
-                usleep(time_off);
-            }
-            FiringTime -= SUNPOINT_DUTY_CYCLE;
-            // printf("[Sunpoint Action] %d %d\n", __LINE__, FiringTime);
-        }
-        // usleep(FiringTime + SUNPOINT_DUTY_CYCLE); // sleep for the remainder of the time
-        HBRIDGE_DISABLE(2); // 3 == executes default, turns off ALL hbridges (safety)
-    }
-}
-
-void insertionSort(int a1[], int a2[])
-{
-    for (int step = 1; step < 3; step++)
-    {
-        int key1 = a1[step];
-        int key2 = a2[step];
-        int j = step - 1;
-        while (key1 < a1[j] && j >= 0)
-        {
-            // For descending order, change key<array[j] to key>array[j].
-            a1[j + 1] = a1[j];
-            a2[j + 1] = a2[j];
-            --j;
-        }
-        a1[j + 1] = key1;
-        a2[j + 1] = key2;
-    }
-}
-
 int acs_init(void)
 {
     /* Set up data logging */
@@ -951,14 +873,24 @@ int acs_init(void)
 
     acs_datalog = fopen(fname, "w");
 #endif // ACS_DATALOG
+#ifdef ACS_RECORD
+    char rname[40] = {0}; // Holds file name where input record is saved
+    sprintf(rname, "acsrecord%d.txt", sys_boot_count);
+
+    acs_recordlog = fopen(rname, "w");
+#endif // ACS_RECORD
     /* End setup datalogging */
 
-    // init for bessel coefficients
-    calculateBessel(bessel_coeff, SH_BUFFER_SIZE, 3, BESSEL_FREQ_CUTOFF);
+    acs_clock_init(&g_acs_clock, ACS_CLOCK_WALL, 0);
+    acs_sched_init(&g_acs_sched, &g_acs_clock);
+    acs_tbuf_init(&g_acs_sun);
+    for (int i = 0; i < ACS_HIST_COUNT; i++)
+        acs_hist_init(&g_acs_hist[i]);
+    acs_overrun_init(&g_acs_overrun);
 
-    // initialize target omega
-    z_g_W_target = 1; // 1 rad s^-1
-    MATVECMUL(g_L_target, MOI, g_W_target); // calculate target angular momentum
+    // initialize the control law: Bessel coefficients, MOI and target omega
+    acs_ctx_init(&g_acs);
+    g_acs_mode = g_acs.mode; // before the threads start
 
 #ifndef SITL // Prepare devices for HITL
     hbridge = (ncv7708 *)malloc(sizeof(ncv7708));
@@ -1010,7 +942,23 @@ int acs_init(void)
         }
     }
     tca9458a_set(mux, 8); // disables mux
-#endif                    // CSS_READY
+    const float css_gains[9] = CSS_LUX_GAINS;
+    for (int k = 0; k < 9; k++)
+        tsl2561_lux_table_init(&css_lux[k], css_gains[k]);
+#ifdef CSS_INT
+    // Initialize the CSS interrupt line, without it the CSS are read at night too
+    css_int = (gpio_event *)malloc(sizeof(gpio_event));
+    if (css_int == NULL)
+        return ERROR_MALLOC;
+    snprintf(css_int->fname, 40, CSS_INT_CHIP);
+    if (gpio_event_init(css_int, CSS_INT_LINE, GPIO_EVENT_FALLING) < 0)
+    {
+        fprintf(stderr, "CSS interrupt line %s:%d not available, reading the CSS at night\n", CSS_INT_CHIP, CSS_INT_LINE);
+        free(css_int);
+        css_int = NULL;
+    }
+#endif // CSS_INT
+#endif // CSS_READY
     // Initialize magnetometer
     mag = (lsm9ds1 *)malloc(sizeof(lsm9ds1));
     snprintf(mag->fname, 40, I2C_BUS);
@@ -1055,8 +1003,39 @@ int acs_init(void)
 
 void acs_destroy(void)
 {
+    static const char *phase_names[ACS_PHASE_COUNT] = {"measure", "decide", "actuate"};
+    printf("ACS: %llu cycles, %llu skipped. Lateness (us):\n", (unsigned long long)g_acs_sched.cycles, (unsigned long long)g_acs_sched.skipped);
+    for (int i = 0; i < ACS_PHASE_COUNT && g_acs_sched.cycles > 0; i++)
+    {
+        const acs_lateness *l = &g_acs_sched.lateness[i];
+        printf("ACS: %8s: mean %+.1f, max %+lld, late in %llu cycles\n", phase_names[i], l->count ? (double)l->sum / l->count : 0, (long long)l->max, (unsigned long long)l->late);
+    }
+    printf("ACS: %llu cycles without a recent sun sample\n", g_acs_sun_stale);
+    printf("ACS: %llu cycles with soft sensor faults, %llu with hard sensor faults\n", g_acs.soft_faults, g_acs.hard_faults);
+    printf("ACS: %llu measurement overruns: %llu actuation windows shrunk, %llu skipped, %llu sun samples without CSS\n", (unsigned long long)g_acs_overrun.overruns, (unsigned long long)g_acs_overrun.shrunk, (unsigned long long)g_acs_overrun.skipped, (unsigned long long)g_acs_overrun.css_dropped);
+    static const char *hist_names[ACS_HIST_COUNT] = {"sense", "estimate", "transition", "command", "actuate", "switch", "period"};
+    printf("ACS: Latency (us):     count        p50        p90        p99      p99.9        max\n");
+    for (int i = 0; i < ACS_HIST_COUNT; i++)
+    {
+        const acs_hist *h = &g_acs_hist[i];
+        printf("ACS: %10s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n", hist_names[i], (unsigned long long)acs_hist_count(h), acs_hist_percentile(h, 50) * 1e-3, acs_hist_percentile(h, 90) * 1e-3, acs_hist_percentile(h, 99) * 1e-3, acs_hist_percentile(h, 99.9) * 1e-3, acs_hist_max(h) * 1e-3);
+    }
+    if (g_torquer_error.count > 0)
+        printf("ACS: Torquer switching error (us): mean %+.1f, max %+lld, %llu of %llu events late\n", (double)g_torquer_error.sum / g_torquer_error.count, (long long)g_torquer_error.max, (unsigned long long)g_torquer_error.late, (unsigned long long)g_torquer_error.count);
+#ifdef ACS_RECORD
+    fclose(acs_recordlog);
+#endif // ACS_RECORD
 #ifndef SITL // if SITL, no need to disable any devices
 #ifdef CSS_READY
+#ifdef CSS_INT
+    if (css_int != NULL)
+    {
+        if (css_armed)
+            setCSSInterrupt(TSL2561_INTR_OFF);
+        gpio_event_destroy(css_int);
+        free(css_int);
+    }
+#endif // CSS_INT
     // Destroy CSSs
     for (int i = 0; i < 3; i++)
     {
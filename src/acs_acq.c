@@ -0,0 +1,42 @@
+/**
+ * @file acs_acq.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Lock-free triple buffer between the sun sensor acquisition stage and the ACS thread.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include <acs_acq.h>
+#include <string.h>
+
+void acs_tbuf_init(acs_tbuf *tb)
+{
+    memset(tb, 0, sizeof(acs_tbuf));
+    tb->back = 0;
+    tb->middle = 1;
+    tb->front = 2;
+}
+
+acs_sun_sample *acs_tbuf_back(acs_tbuf *tb)
+{
+    return &tb->buf[tb->back];
+}
+
+void acs_tbuf_publish(acs_tbuf *tb)
+{
+    // release: the sample is complete before the consumer can take it
+    uint8_t old = __atomic_exchange_n(&tb->middle, tb->back | ACS_TBUF_FRESH, __ATOMIC_ACQ_REL);
+    tb->back = old & ~ACS_TBUF_FRESH;
+}
+
+const acs_sun_sample *acs_tbuf_read(acs_tbuf *tb, int *fresh)
+{
+    int is_fresh = (__atomic_load_n(&tb->middle, __ATOMIC_ACQUIRE) & ACS_TBUF_FRESH) != 0;
+    if (is_fresh) // swap the front buffer with the fresh middle buffer
+        tb->front = __atomic_exchange_n(&tb->middle, tb->front, __ATOMIC_ACQ_REL) & ~ACS_TBUF_FRESH;
+    if (fresh != NULL)
+        *fresh = is_fresh;
+    return &tb->buf[tb->front];
+}
@@ -0,0 +1,20 @@
+/**
+ * @file acs_actuate.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Executes the magnetorquer commands calculated by the ACS control law
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#include <acs.h>
+#include <acs_clock.h>
+#include <acs_torquer.h>
+
+void acs_actuate(acs_clock *clk, const acs_cmd *cmd, uint64_t start)
+{
+    acs_timeline tl;
+    acs_timeline_build(cmd, start, &tl);
+    acs_timeline_run(clk, &tl, NULL, NULL);
+}
@@ -0,0 +1,325 @@
+/**
+ * @file acs_batch.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Structure-of-arrays variant of the ACS control law math.
+ *
+ * Every operation mirrors the scalar code in acs_core.c step by step, including
+ * the float/double promotions and the evaluation order of the vector macros, so
+ * that each lane produces the same bits as the scalar path.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include <acs_batch.h>
+#include <math.h>
+#include <string.h>
+
+/**
+ * @brief One 64-bit integer per lane, the mask type of double comparisons.
+ *
+ */
+typedef int64_t acs_vl __attribute__((vector_size(ACS_BATCH_LANES * sizeof(int64_t))));
+
+#define VD(v) __builtin_convertvector(v, acs_vd)
+#define VF(v) __builtin_convertvector(v, acs_vf)
+#define VI(v) __builtin_convertvector(v, acs_vi)
+#define VL(v) __builtin_convertvector(v, acs_vl)
+#define VSPLAT(type, v) ((type){0} + (v))
+
+/**
+ * @brief Lane-wise mask ? a : b for floats. Mask lanes are -1 (true) or 0 (false).
+ *
+ */
+#define VFSELECT(mask, a, b) ((acs_vf)(((mask) & (acs_vi)(a)) | (~(mask) & (acs_vi)(b))))
+/**
+ * @brief Lane-wise mask ? a : b for doubles. Mask lanes are -1 (true) or 0 (false).
+ *
+ */
+#define VDSELECT(mask, a, b) ((acs_vd)((VL(mask) & (acs_vl)(a)) | (~VL(mask) & (acs_vl)(b))))
+/**
+ * @brief Lane-wise mask ? a : b for integers. Mask lanes are -1 (true) or 0 (false).
+ *
+ */
+#define VISELECT(mask, a, b) (((mask) & (a)) | (~(mask) & (b)))
+
+/**
+ * @brief Lane-wise q2isqrt(), in place.
+ *
+ */
+static inline void vq2isqrt(acs_vf *v)
+{
+    acs_vf x = *v;
+#ifndef MATH_SQRT
+    acs_vf xhalf = x * 0.5f;
+    acs_vi i = 0x5f375a86 - ((acs_vi)x >> 1);
+    x = (acs_vf)i;
+    x = x * (1.5f - xhalf * x * x);
+    x = x * (1.5f - xhalf * x * x);
+    x = x * (1.5f - xhalf * x * x);
+#else  // MATH_SQRT
+    for (int i = 0; i < ACS_BATCH_LANES; i++)
+        x[i] = 1.0 / sqrt(x[i]);
+#endif // MATH_SQRT
+    *v = x;
+}
+
+/**
+ * @brief Lane-wise round() for non-negative values, in place.
+ *
+ */
+static inline void vround(acs_vf *v)
+{
+    acs_vf r = VF(VI(*v));                  // truncate
+    *v = r - VF((acs_vi)(*v - r >= 0.5f)); // mask is -1 where the fraction rounds up
+}
+
+/**
+ * @brief Lane-wise NORMALIZE() for float vectors. Lanes with a zero inverse norm keep the destination.
+ *
+ */
+#define VNORMALIZE(dest, s1)                                     \
+    do                                                           \
+    {                                                            \
+        acs_vf sh__temp = NORM2(s1);                             \
+        vq2isqrt(&sh__temp);                                     \
+        acs_vi sh__nz = sh__temp != 0;                           \
+        x_##dest = VFSELECT(sh__nz, x_##s1 * sh__temp, x_##dest); \
+        y_##dest = VFSELECT(sh__nz, y_##s1 * sh__temp, y_##dest); \
+        z_##dest = VFSELECT(sh__nz, z_##s1 * sh__temp, z_##dest); \
+    } while (0)
+
+/**
+ * @brief Lane-wise DOT_PRODUCT() for float vectors.
+ *
+ */
+#define VDOT_PRODUCT(s1, s2) (x_##s1 * x_##s2 + y_##s1 * y_##s2 + z_##s1 * z_##s2)
+
+void acs_batch_load(acs_batch *b, int lane, const acs_ctx *ctx)
+{
+    if (ctx->mag_index >= 0)
+    {
+        b->x_B[lane] = ctx->x_B[ctx->mag_index];
+        b->y_B[lane] = ctx->y_B[ctx->mag_index];
+        b->z_B[lane] = ctx->z_B[ctx->mag_index];
+    }
+    int m1 = ctx->bdot_index;
+    if (m1 >= 0)
+    {
+        int m0 = (m1 - 1) < 0 ? SH_BUFFER_SIZE - m1 - 1 : m1 - 1; // same as getOmega()
+        b->x_Bt1[lane] = ctx->x_Bt[m1];
+        b->y_Bt1[lane] = ctx->y_Bt[m1];
+        b->z_Bt1[lane] = ctx->z_Bt[m1];
+        b->x_Bt0[lane] = ctx->x_Bt[m0];
+        b->y_Bt0[lane] = ctx->y_Bt[m0];
+        b->z_Bt0[lane] = ctx->z_Bt[m0];
+        b->Bt_rate[lane] = acs_rate(ctx->t_Bt[m0], ctx->t_Bt[m1]);
+    }
+    if (ctx->omega_index >= 0)
+    {
+        b->x_W[lane] = ctx->x_W[ctx->omega_index];
+        b->y_W[lane] = ctx->y_W[ctx->omega_index];
+        b->z_W[lane] = ctx->z_W[ctx->omega_index];
+    }
+    if (ctx->sol_index >= 0)
+    {
+        b->x_S[lane] = ctx->x_S[ctx->sol_index];
+        b->y_S[lane] = ctx->y_S[ctx->sol_index];
+        b->z_S[lane] = ctx->z_S[ctx->sol_index];
+    }
+    b->x_L_target[lane] = ctx->x_L_target;
+    b->y_L_target[lane] = ctx->y_L_target;
+    b->z_L_target[lane] = ctx->z_L_target;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            b->MOI[i][j][lane] = ctx->MOI[i][j];
+}
+
+void acs_batch_omega(acs_batch *b)
+{
+    ALIAS_VECTOR(Bt0, b, acs_vd);
+    ALIAS_VECTOR(Bt1, b, acs_vd);
+    acs_vf freq = b->Bt_rate;
+    acs_vf norm2 = VF(NORM2(Bt0));
+    acs_vf x_W = VF(y_Bt1 * z_Bt0 - z_Bt1 * y_Bt0) * freq / norm2; // CROSS_PRODUCT, then VECTOR_MIXED(W, W, freq / norm2, *)
+    acs_vf y_W = VF(z_Bt1 * x_Bt0 - x_Bt1 * z_Bt0) * freq / norm2;
+    acs_vf z_W = VF(x_Bt1 * y_Bt0 - y_Bt1 * x_Bt0) * freq / norm2;
+    acs_vi finite = (x_W - x_W == 0) & (y_W - y_W == 0) & (z_W - z_W == 0); // inf - inf and NaN - NaN are NaN
+    b->x_W = VFSELECT(finite, x_W, b->x_W); // hold the last omega like getOmega()
+    b->y_W = VFSELECT(finite, y_W, b->y_W);
+    b->z_W = VFSELECT(finite, z_W, b->z_W);
+}
+
+void acs_batch_detumble(const acs_batch *b, acs_batch_cmd *cmd)
+{
+    const acs_vf zero = {0};
+    const acs_vd dzero = {0};
+    ALIAS_VECTOR(B, b, acs_vd);
+    ALIAS_VECTOR(W, b, acs_vf);
+    ALIAS_VECTOR(L_target, b, acs_vf);
+    DECLARE_VECTOR2(Lf, acs_vf);
+    MATVECMUL(Lf, b->MOI, W); // float product, stored into a double in the scalar path
+    DECLARE_VECTOR2(currL, acs_vd);
+    x_currL = VD(x_L_target) - VD(x_Lf); // angular momentum error
+    y_currL = VD(y_L_target) - VD(y_Lf);
+    z_currL = VD(z_L_target) - VD(z_Lf);
+
+    acs_vf temp = VF(NORM2(currL)); // NORMALIZE(currLNorm, currL)
+    vq2isqrt(&temp);
+    acs_vi nz = temp != 0;
+    DECLARE_VECTOR2(currLNorm, acs_vf);
+    x_currLNorm = VFSELECT(nz, VF(x_currL * VD(temp)), zero);
+    y_currLNorm = VFSELECT(nz, VF(y_currL * VD(temp)), zero);
+    z_currLNorm = VFSELECT(nz, VF(z_currL * VD(temp)), zero);
+
+    temp = VF(NORM2(B)); // NORMALIZE(currB, B)
+    vq2isqrt(&temp);
+    nz = temp != 0;
+    DECLARE_VECTOR2(currB, acs_vd);
+    x_currB = VDSELECT(nz, x_B * VD(temp), dzero);
+    y_currB = VDSELECT(nz, y_B * VD(temp), dzero);
+    z_currB = VDSELECT(nz, z_B * VD(temp), dzero);
+
+    DECLARE_VECTOR2(firingDir, acs_vf); // CROSS_PRODUCT(firingDir, currB, currLNorm)
+    x_firingDir = VF(y_currB * VD(z_currLNorm) - z_currB * VD(y_currLNorm));
+    y_firingDir = VF(z_currB * VD(x_currLNorm) - x_currB * VD(z_currLNorm));
+    z_firingDir = VF(x_currB * VD(y_currLNorm) - y_currB * VD(x_currLNorm));
+
+    DECLARE_VECTOR2(fire, acs_vi);
+    x_fire = 1 + 2 * (x_firingDir < 0); // comparison yields -1 where true
+    y_fire = 1 + 2 * (y_firingDir < 0);
+    z_fire = 1 + 2 * (z_firingDir < 0);
+    x_fire &= VI(VD(x_firingDir * VF(x_fire)) > 0.01); // fire only if the component is > 0.01
+    y_fire &= VI(VD(y_firingDir * VF(y_fire)) > 0.01);
+    z_fire &= VI(VD(z_firingDir * VF(z_fire)) > 0.01);
+
+    DECLARE_VECTOR2(currDipole, acs_vf);
+    x_currDipole = VF(VD(x_fire) * DIPOLE_MOMENT * 1e-7);
+    y_currDipole = VF(VD(y_fire) * DIPOLE_MOMENT * 1e-7);
+    z_currDipole = VF(VD(z_fire) * DIPOLE_MOMENT * 1e-7);
+    DECLARE_VECTOR2(currTorque, acs_vf); // CROSS_PRODUCT(currTorque, currDipole, B)
+    x_currTorque = VF(VD(y_currDipole) * z_B - VD(z_currDipole) * y_B);
+    y_currTorque = VF(VD(z_currDipole) * x_B - VD(x_currDipole) * z_B);
+    z_currTorque = VF(VD(x_currDipole) * y_B - VD(y_currDipole) * x_B);
+    DECLARE_VECTOR2(firingTime, acs_vf);
+    x_firingTime = VF(x_currL / VD(x_currTorque)) * 1000000;
+    y_firingTime = VF(y_currL / VD(y_currTorque)) * 1000000;
+    z_firingTime = VF(z_currL / VD(z_currTorque)) * 1000000;
+
+    const acs_vi vzero = {0}, vmax = VSPLAT(acs_vi, MAX_DETUMBLE_FIRING_TIME);
+    cmd->x_fire = x_fire;
+    cmd->y_fire = y_fire;
+    cmd->z_fire = z_fire;
+    cmd->x_firingCmd = VISELECT(x_firingTime > (float)MAX_DETUMBLE_FIRING_TIME, vmax, VISELECT(x_firingTime < (float)MIN_DETUMBLE_FIRING_TIME, vzero, VI(x_firingTime)));
+    cmd->y_firingCmd = VISELECT(y_firingTime > (float)MAX_DETUMBLE_FIRING_TIME, vmax, VISELECT(y_firingTime < (float)MIN_DETUMBLE_FIRING_TIME, vzero, VI(y_firingTime)));
+    cmd->z_firingCmd = VISELECT(z_firingTime > (float)MAX_DETUMBLE_FIRING_TIME, vmax, VISELECT(z_firingTime < (float)MIN_DETUMBLE_FIRING_TIME, vzero, VI(z_firingTime)));
+}
+
+void acs_batch_sunpoint(const acs_batch *b, acs_batch_cmd *cmd)
+{
+    const acs_vf zero = {0};
+    ALIAS_VECTOR(B, b, acs_vd);
+    ALIAS_VECTOR(W, b, acs_vf);
+    ALIAS_VECTOR(S, b, acs_vf);
+    DECLARE_VECTOR2(currB, acs_vf);
+    x_currB = VF(x_B) + 0.0f; // the scalar path adds to a zeroed vector
+    y_currB = VF(y_B) + 0.0f;
+    z_currB = VF(z_B) + 0.0f;
+    DECLARE_VECTOR2(currBNorm, acs_vf);
+    x_currBNorm = y_currBNorm = z_currBNorm = zero;
+    VNORMALIZE(currBNorm, currB);
+    DECLARE_VECTOR2(currL, acs_vf);
+    MATVECMUL(currL, b->MOI, W);
+    DECLARE_VECTOR2(currS, acs_vf);
+    x_currS = x_S + 0.0f;
+    y_currS = y_S + 0.0f;
+    z_currS = z_S + 0.0f;
+    DECLARE_VECTOR2(currSNorm, acs_vf);
+    x_currSNorm = y_currSNorm = z_currSNorm = zero;
+    VNORMALIZE(currSNorm, currS);
+    // calculate S_B_hat
+    DECLARE_VECTOR2(SBHat, acs_vf);
+    acs_vf SdotB = VDOT_PRODUCT(currSNorm, currBNorm);
+    VECTOR_MIXED(SBHat, currBNorm, SdotB, *);
+    VECTOR_OP(SBHat, currSNorm, SBHat, +);
+    VNORMALIZE(SBHat, SBHat);
+    // calculate L_B_hat
+    DECLARE_VECTOR2(LBHat, acs_vf);
+    acs_vf LdotB = VDOT_PRODUCT(currL, currBNorm);
+    VECTOR_MIXED(LBHat, currBNorm, LdotB, *);
+    VECTOR_OP(LBHat, currL, LBHat, +);
+    VNORMALIZE(LBHat, LBHat);
+    // cross product the two vectors
+    DECLARE_VECTOR2(SxBxL, acs_vf);
+    CROSS_PRODUCT(SxBxL, SBHat, LBHat);
+    VNORMALIZE(SxBxL, SxBxL);
+    acs_vf sun_ang = (acs_vf)((acs_vi)z_S & 0x7fffffff); // fabs
+    acs_vf fgain = sun_ang * 32;
+    vround(&fgain);
+    acs_vi gain = VI(fgain);
+    gain = VISELECT(gain < 1, VSPLAT(acs_vi, 1), gain);
+    acs_vi time_on = VI(VDOT_PRODUCT(SxBxL, currBNorm) * SUNPOINT_DUTY_CYCLE * VF(gain));
+    acs_vi dir = -1 - 2 * (time_on > 0);
+    time_on = VISELECT(time_on > 0, time_on, -time_on);
+    time_on = VISELECT(time_on > SUNPOINT_DUTY_CYCLE, VSPLAT(acs_vi, SUNPOINT_DUTY_CYCLE), time_on);
+    time_on = VISELECT((time_on < 5000) & (time_on > 2499), VSPLAT(acs_vi, 5000), time_on);
+    acs_vf ftime = VF(time_on) / 10000.0f;
+    vround(&ftime);
+    time_on = 10000 * VI(ftime);
+    time_on /= 5000;
+    time_on *= 5000;
+    cmd->z_fire = dir;
+    cmd->time_on = time_on;
+}
+
+void acs_step_batch(acs_ctx *ctx[], const acs_input in[], const uint64_t now[], acs_cmd cmd[], int n)
+{
+    for (int base = 0; base < n; base += ACS_BATCH_LANES)
+    {
+        int lanes = n - base < ACS_BATCH_LANES ? n - base : ACS_BATCH_LANES;
+        int det = 0, sun = 0; // lanes that need a detumble or sunpointing command
+        acs_batch b;
+        acs_batch_cmd dcmd, scmd;
+        memset(&b, 0, sizeof(acs_batch));
+        for (int i = 0; i < lanes; i++)
+        {
+            acs_ctx *c = ctx[base + i];
+            acs_update(c, &in[base + i], now[base + i], &cmd[base + i]);
+            if (cmd[base + i].status == 0) // no new sample, stays idle
+                continue;
+            if (c->mode == STATE_ACS_DETUMBLE && c->omega_index >= 0)
+                det |= 1 << i;
+            else if (c->mode == STATE_ACS_SUNPOINT && c->sol_index >= 0)
+                sun |= 1 << i;
+            else
+                continue;
+            acs_batch_load(&b, i, c);
+        }
+        if (det)
+            acs_batch_detumble(&b, &dcmd);
+        if (sun)
+            acs_batch_sunpoint(&b, &scmd);
+        for (int i = 0; i < lanes; i++)
+        {
+            acs_cmd *c = &cmd[base + i];
+            if (det & (1 << i))
+            {
+                c->type = ACS_CMD_DETUMBLE;
+                c->x_fire = dcmd.x_fire[i];
+                c->y_fire = dcmd.y_fire[i];
+                c->z_fire = dcmd.z_fire[i];
+                c->x_firingCmd = dcmd.x_firingCmd[i];
+                c->y_firingCmd = dcmd.y_firingCmd[i];
+                c->z_firingCmd = dcmd.z_firingCmd[i];
+            }
+            else if (sun & (1 << i))
+            {
+                c->type = ACS_CMD_SUNPOINT;
+                c->z_fire = scmd.z_fire[i];
+                c->time_on = scmd.time_on[i];
+            }
+        }
+    }
+}
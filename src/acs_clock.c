@@ -0,0 +1,59 @@
+/**
+ * @file acs_clock.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Clock and sleep backends for the Attitude Control System loop.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include <acs_clock.h>
+#include <sh_time.h>
+#include <errno.h>
+#include <time.h>
+
+/**
+ * @brief Converts a time on CLOCK_MONOTONIC in usec to a timespec.
+ *
+ */
+static inline void usec_to_timespec(uint64_t usec, struct timespec *ts)
+{
+    ts->tv_sec = usec / 1000000;
+    ts->tv_nsec = (usec % 1000000) * 1000;
+}
+
+void acs_clock_init(acs_clock *clk, uint8_t type, uint64_t start)
+{
+    clk->type = type;
+    clk->t = start;
+}
+
+uint64_t acs_clock_now(acs_clock *clk)
+{
+    if (clk->type == ACS_CLOCK_VIRTUAL)
+        return clk->t;
+    return sh_time_usec();
+}
+
+void acs_clock_sleep(acs_clock *clk, uint64_t usec)
+{
+    if (clk->type == ACS_CLOCK_VIRTUAL)
+        clk->t += usec;
+    else
+        acs_clock_sleep_until(clk, acs_clock_now(clk) + usec);
+}
+
+void acs_clock_sleep_until(acs_clock *clk, uint64_t t)
+{
+    if (clk->type == ACS_CLOCK_VIRTUAL)
+    {
+        if (t > clk->t)
+            clk->t = t;
+        return;
+    }
+    struct timespec ts;
+    usec_to_timespec(t, &ts);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) // absolute deadline, immune to signals
+        ;
+}
@@ -0,0 +1,560 @@
+/**
+ * @file acs_core.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Re-entrant Attitude Control System control law
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#include <acs_core.h>
+#include <bessel.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef M_PI
+/**
+ * @brief Approximate definition of Pi in case M_PI is not included from math.h
+ */
+#define M_PI 3.1415
+#endif
+
+/* External definitions of the inline helpers in macros.h, for translation units that do not inline them */
+extern inline float q2isqrt(float x);
+extern inline uint64_t get_usec(void);
+extern inline float faverage(float arr[], int size);
+extern inline double daverage(double arr[], int size);
+
+const float acs_default_MOI[3][3] = {{0.06467720404, 0, 0},
+                                     {0, 0.06474406267, 0},
+                                     {0, 0, 0.07921836177}};
+
+const float acs_default_IMOI[3][3] = {{15.461398105297564, 0, 0},
+                                      {0, 15.461398105297564, 0},
+                                      {0, 0, 12.623336025344317}};
+
+void acs_ctx_init(acs_ctx *ctx)
+{
+    memset(ctx, 0, sizeof(acs_ctx));
+    ctx->mag_index = -1;
+    ctx->bdot_index = -1;
+    ctx->omega_index = -1;
+    ctx->sol_index = -1; // circular buffer indices, -1 indicates uninitiated buffer
+    ctx->mode = STATE_ACS_DETUMBLE; // Detumble by default
+    ctx->first_detumble = 1;        // first time detumble by default even at night
+    memcpy(ctx->MOI, acs_default_MOI, sizeof(ctx->MOI));
+    memcpy(ctx->IMOI, acs_default_IMOI, sizeof(ctx->IMOI));
+    // init for bessel coefficients
+    acs_ctx_set_cutoff(ctx, BESSEL_FREQ_CUTOFF);
+    // initialize target omega
+    acs_ctx_set_target(ctx, 0, 0, 1); // 1 rad s^-1
+}
+
+void acs_ctx_set_target(acs_ctx *ctx, float wx, float wy, float wz)
+{
+    ctx->x_W_target = wx;
+    ctx->y_W_target = wy;
+    ctx->z_W_target = wz;
+    ALIAS_VECTOR(W_target, ctx, float);
+    DECLARE_VECTOR(L_target, float);
+    MATVECMUL(L_target, ctx->MOI, W_target); // calculate target angular momentum
+    ctx->x_L_target = x_L_target;
+    ctx->y_L_target = y_L_target;
+    ctx->z_L_target = z_L_target;
+}
+
+void acs_ctx_set_cutoff(acs_ctx *ctx, float freq_cutoff)
+{
+#ifdef BESSEL_IIR
+    if (bessel_iir_init(&ctx->filter, BESSEL_ORDER, freq_cutoff) < 0)
+        fprintf(stderr, "%s: Invalid Bessel filter order %d or cutoff %f, filter disabled\n", __func__, BESSEL_ORDER, freq_cutoff);
+#else
+    calculateBessel(ctx->bessel_coeff, SH_BUFFER_SIZE, BESSEL_ORDER, freq_cutoff);
+    bessel_fir_init(&ctx->filter, ctx->bessel_coeff);
+#endif // BESSEL_IIR
+}
+
+void acs_ctx_flush(acs_ctx *ctx)
+{
+    ALIAS_BUFFER(B, ctx, double);
+    ALIAS_BUFFER(Bt, ctx, double);
+    ALIAS_BUFFER(W, ctx, float);
+    ALIAS_BUFFER(S, ctx, float);
+
+    FLUSH_BUFFER(B);
+    ctx->mag_index = -1;
+    ctx->B_full = 0;
+
+    FLUSH_BUFFER(Bt);
+    ctx->bdot_index = -1;
+
+    FLUSH_BUFFER(W);
+    ctx->omega_index = -1;
+    ctx->W_full = 0;
+
+    FLUSH_BUFFER(S);
+    ctx->sol_index = -1;
+    ctx->S_full = 0;
+
+    ctx->mag_faults = 0;
+
+    memset(&ctx->B_hist, 0, sizeof(bessel_dstate)); // filter states follow the buffers
+    memset(&ctx->Bt_hist, 0, sizeof(bessel_dstate));
+    memset(&ctx->W_hist, 0, sizeof(bessel_fstate));
+#ifdef ACS_EKF
+    acs_ekf_init(&ctx->ekf);
+#endif
+    /*
+     * Fall back into night mode which is the safe mode
+     * NOTE: Since the buffers are empty at this point,
+     * checkTransition() will not be called. Hence,
+     * after flushing the buffer the system will spend
+     * 64 cycles reading the sensors.
+     * 
+     * TODO: Add more checks and do a system reboot if
+     * such a state persists.
+     */
+    ctx->mode = STATE_ACS_NIGHT;
+}
+
+void getOmega(acs_ctx *ctx)
+{
+    if (!ctx->gyro && ctx->mag_index < 2 && ctx->B_full == 0) // not enough measurements
+        return;
+    ALIAS_BUFFER(Bt, ctx, double);
+    ALIAS_BUFFER(W, ctx, float);
+    // once we have measurements, we declare that we proceed
+    if (ctx->omega_index == SH_BUFFER_SIZE - 1) // hit max, buffer full
+        ctx->W_full = 1;
+    int omega_index = ctx->omega_index = (1 + ctx->omega_index) % SH_BUFFER_SIZE; // calculate new index in the circular buffer
+#ifdef ACS_EKF
+    x_W[omega_index] = ctx->ekf.x[3]; // estimate of the Kalman filter, already filtered
+    y_W[omega_index] = ctx->ekf.x[4];
+    z_W[omega_index] = ctx->ekf.x[5];
+    return;
+#endif // ACS_EKF
+    if (ctx->gyro) // measured, already low pass filtered by the gyroscope
+    {
+        x_W[omega_index] = ctx->x_G;
+        y_W[omega_index] = ctx->y_G;
+        z_W[omega_index] = ctx->z_G;
+        APPLY_FFILTER(&ctx->filter, &ctx->W_hist, W, omega_index); // keeps the filter history current for a cycle without the gyroscope
+        x_W[omega_index] = ctx->x_G;                               // the measurement is used unfiltered
+        y_W[omega_index] = ctx->y_G;
+        z_W[omega_index] = ctx->z_G;
+        return;
+    }
+    int bdot_index = ctx->bdot_index;
+    int8_t m0, m1;                                                                // temporary addresses
+    m1 = bdot_index;                                                              // current address
+    m0 = (bdot_index - 1) < 0 ? SH_BUFFER_SIZE - bdot_index - 1 : bdot_index - 1; // previous address, wrapped around the circular buffer
+    float freq;
+    freq = acs_rate(ctx->t_Bt[m0], ctx->t_Bt[m1]); // time units!
+    CROSS_PRODUCT(W[omega_index], Bt[m1], Bt[m0]); // apply cross product
+    float norm2 = NORM2(Bt[m0]);
+    VECTOR_MIXED(W[omega_index], W[omega_index], freq / norm2, *); // omega = (B_t dot x B_t-dt dot)*freq/Norm2(B_t dot)
+    if (!isfinite(x_W[omega_index]) || !isfinite(y_W[omega_index]) || !isfinite(z_W[omega_index])) // Bdot = 0, e.g. B aligned with the spin axis
+    {
+        ctx->soft_faults++;
+        int prev = (omega_index + SH_BUFFER_SIZE - 1) % SH_BUFFER_SIZE;
+        if (omega_index == 0 && ctx->W_full == 0) // no previous sample
+        {
+            VECTOR_CLEAR(W[omega_index]);
+        }
+        else
+        {
+            VECTOR_MIXED(W[omega_index], W[prev], 0, +); // hold the last value
+        }
+    }
+    // Apply correction // There is fast runaway with this on
+    // DECLARE_VECTOR(omega_corr0, float);                        // declare temporary space for correction vector
+    // MATVECMUL(omega_corr0, ctx->MOI, W[m1]);                   // MOI X w[t-1]
+    // DECLARE_VECTOR(omega_corr1, float);                        // declare temporary space for correction vector
+    // CROSS_PRODUCT(omega_corr1, W[m1], omega_corr0);            // store into temp 1
+    // MATVECMUL(omega_corr1, ctx->IMOI, omega_corr0);            // store back into temp 0
+    // VECTOR_MIXED(omega_corr1, omega_corr1, -freq, *);          // omega_corr = freq*(MOI-1)*(-w[t-1] X MOI*w[t-1])
+    // VECTOR_OP(W[omega_index], W[omega_index], omega_corr1, +); // add the correction term to omega
+    APPLY_FFILTER(&ctx->filter, &ctx->W_hist, W, omega_index); // Bessel filter of order BESSEL_ORDER
+    return;
+}
+
+void getSVec(acs_ctx *ctx)
+{
+    ALIAS_BUFFER(S, ctx, float);
+    if (ctx->sol_index == SH_BUFFER_SIZE - 1) // hit max, buffer full
+        ctx->S_full = 1;
+    int sol_index = ctx->sol_index = (ctx->sol_index + 1) % SH_BUFFER_SIZE;
+#ifdef SITL
+    // SITL expects radians input
+    float fsx = 180 / M_PI * ctx->FSS[0];
+    float fsy = 180 / M_PI * ctx->FSS[1];
+#else
+    // hardware reads degrees
+    float fsx = ctx->FSS[0];
+    float fsy = ctx->FSS[1];
+#endif // SITL
+    // check if FSS results are acceptable
+    // if they are, use that to calculate the sun vector
+    if (fabsf(fsx) <= 60 && fabsf(fsy) <= 60) // angle inside FOV (FOV -> 60°, half angle 30°)
+    {
+        ctx->sun_source = ACS_SUN_FSS;
+        x_S[sol_index] = tan(fsx * M_PI / 180); // Consult https://www.cubesatshop.com/wp-content/uploads/2016/06/nanoSSOC-A60-Technical-Specifications.pdf, section 4
+        y_S[sol_index] = tan(fsy * M_PI / 180);
+        z_S[sol_index] = 1;
+        NORMALIZE(S[sol_index], S[sol_index]);
+        return;
+    }
+
+    // get average -Z luminosity from 4 sensors
+    float znavg = 0;
+    for (int i = 5; i < 9; i++)
+        znavg += ctx->CSS[i];
+    znavg *= 0.250f;
+
+    x_S[sol_index] = ctx->CSS[0] - ctx->CSS[1]; // +x - -x
+    y_S[sol_index] = ctx->CSS[2] - ctx->CSS[3]; // +x - -x
+    z_S[sol_index] = ctx->CSS[4] - znavg;       // +z - avg(-z)
+
+    float css_mag = NORM(S[sol_index]); // norm of the CSS lux values
+
+    if (css_mag < CSS_MIN_LUX_THRESHOLD) // night time logic
+    {
+        ctx->night = 1;
+        ctx->sun_source = ACS_SUN_NIGHT;
+        VECTOR_CLEAR(S[sol_index]); // return 0 solar vector
+    }
+    else
+    {
+        ctx->night = 0;
+        ctx->sun_source = ACS_SUN_CSS;
+        NORMALIZE(S[sol_index], S[sol_index]); // return normalized sun vector
+    }
+    return;
+}
+
+int processSensors(acs_ctx *ctx, const acs_input *in)
+{
+    int status = in->status;
+    if (status < 0) // acquisition failed
+        return status;
+    if (in->fault)
+        ctx->soft_faults++;
+    if (in->fault & ACS_FAULT_MAG) // invalidate this sample only
+    {
+        if (++ctx->mag_faults >= ACS_FAULT_MAG_LIMIT)
+            return -1;
+        return 0;
+    }
+    ctx->mag_faults = 0;
+    ALIAS_BUFFER(B, ctx, double);
+    ALIAS_BUFFER(Bt, ctx, double);
+    ALIAS_BUFFER(W, ctx, float);
+    ALIAS_BUFFER(S, ctx, float);
+    ctx->sun_source = ACS_SUN_NONE;
+    if (ctx->mag_index == SH_BUFFER_SIZE - 1) // hit max, buffer full
+        ctx->B_full = 1;
+    int mag_index = ctx->mag_index = (ctx->mag_index + 1) % SH_BUFFER_SIZE;
+    ctx->t_B[mag_index] = ctx->t_acs; // time of the measurement
+    VECTOR_CLEAR(B[mag_index]); // clear the current B
+    x_B[mag_index] += in->x_B;  // load B
+    y_B[mag_index] += in->y_B;
+    z_B[mag_index] += in->z_B;
+    ctx->gyro = in->gyro && isfinite(in->x_G) && isfinite(in->y_G) && isfinite(in->z_G);
+    if (in->gyro && !ctx->gyro) // estimate from the magnetic field this cycle
+        ctx->soft_faults++;
+    ctx->x_G = in->x_G;
+    ctx->y_G = in->y_G;
+    ctx->z_G = in->z_G;
+#ifdef ACS_EKF
+    const double B_in[3] = {in->x_B, in->y_B, in->z_B};
+    acs_ekf_predict(&ctx->ekf, ctx->t_acs, ctx->MOI, ctx->IMOI); // spans missing samples like the derivatives
+    acs_ekf_mag(&ctx->ekf, B_in, ctx->t_acs);                    // unfiltered field, a NaN field is left to the hard fault check
+    if (ctx->gyro)
+    {
+        const double G_in[3] = {in->x_G, in->y_G, in->z_G};
+        acs_ekf_gyro(&ctx->ekf, G_in, ACS_GYRO_NOISE);
+    }
+#endif // ACS_EKF
+#ifndef SITL
+    APPLY_DFILTER(&ctx->filter, &ctx->B_hist, B, mag_index); // bessel filter
+#endif                                                    // SITL
+    for (int i = 0; i < 9; i++)
+        ctx->CSS[i] = in->CSS[i];
+    ctx->FSS[0] = in->FSS[0];
+    ctx->FSS[1] = in->FSS[1];
+
+    if (mag_index >= 1 || ctx->B_full) // if we have > 1 values, calculate Bdot
+    {
+        if (ctx->bdot_index == SH_BUFFER_SIZE - 1) // hit max, buffer full
+            ctx->B_full = 1;
+        int bdot_index = ctx->bdot_index = (ctx->bdot_index + 1) % SH_BUFFER_SIZE;
+        int8_t m0, m1;
+        m1 = mag_index;
+        m0 = (mag_index - 1) < 0 ? SH_BUFFER_SIZE - mag_index - 1 : mag_index - 1;
+        double freq = acs_rate(ctx->t_B[m0], ctx->t_B[m1]);        // measured sample spacing, spans a missing sample
+        ctx->t_Bt[bdot_index] = ctx->t_B[m0] + (ctx->t_B[m1] - ctx->t_B[m0]) / 2; // difference is centered between the samples
+        VECTOR_OP(Bt[bdot_index], B[m1], B[m0], -);
+        VECTOR_MIXED(Bt[bdot_index], Bt[bdot_index], freq, *);
+        APPLY_DFILTER(&ctx->filter, &ctx->Bt_hist, Bt, bdot_index); // bessel filter
+    }
+    else if (!ctx->gyro) // nothing to estimate the angular speed from yet
+        return status;
+    getOmega(ctx);
+    getSVec(ctx);
+    // a NaN magnetic field is in the filter state, which only a flush clears: hard fault
+    if (isnan(x_B[mag_index]) || isnan(y_B[mag_index]) || isnan(z_B[mag_index]))
+        return -1;
+    // a NaN sun vector only affects this sample: hold the last one
+    int sol_index = ctx->sol_index;
+    if (isnan(x_S[sol_index]) || isnan(y_S[sol_index]) || isnan(z_S[sol_index]))
+    {
+        ctx->soft_faults++;
+        int prev = (sol_index + SH_BUFFER_SIZE - 1) % SH_BUFFER_SIZE;
+        if (sol_index == 0 && ctx->S_full == 0) // no previous sample
+        {
+            VECTOR_CLEAR(S[sol_index]);
+        }
+        else
+        {
+            VECTOR_MIXED(S[sol_index], S[prev], 0, +);
+        }
+    }
+    // a NaN angular speed is held by getOmega() before it reaches the filter
+    int omega_index = ctx->omega_index;
+    if (omega_index >= 0 && (isnan(x_W[omega_index]) || isnan(y_W[omega_index]) || isnan(z_W[omega_index])))
+        return -1;
+    return status;
+}
+
+void checkTransition(acs_ctx *ctx)
+{
+    if (!ctx->W_full) // not enough data to take a decision
+        return;
+    if (!ctx->S_full) // not enough data to take a decision
+        return;
+    ALIAS_BUFFER(W, ctx, float);
+    ALIAS_BUFFER(S, ctx, float);
+    float z_W_target = ctx->z_W_target;
+    DECLARE_VECTOR(avgOmega, float);             // declare buffer to contain average value of omega
+    FAVERAGE_BUFFER(avgOmega, W, SH_BUFFER_SIZE); // calculate time average of omega over buffer
+    DECLARE_VECTOR(avgSun, float);               // declare buffer to contain avg sun vector
+    VECTOR_MIXED(avgSun, S[ctx->sol_index], 0, +); // current sun angle
+
+    DECLARE_VECTOR(body, float);                   // Body frame vector oriented along Z axis
+    z_body = 1;                                    // Body frame vector is Z
+    float W_target_diff = z_W_target - z_avgOmega; // difference of omega_z
+    NORMALIZE(avgOmega, avgOmega);                 // Normalize avg omega to get omega hat
+    float w_ang = (DOT_PRODUCT(avgOmega, body));
+    w_ang = w_ang >= 1 ? 1 : w_ang;
+    float z_w_ang = 180. * acos(w_ang) / M_PI;                     // average omega angle in degrees
+    float z_S_ang = 180. * acos(DOT_PRODUCT(avgSun, body)) / M_PI; // Sun angle in degrees
+    uint8_t next_mode = ctx->mode;
+    if (ctx->mode == STATE_ACS_DETUMBLE)
+    {
+        // If detumble criterion is met, go to Sunpointing mode
+        if (fabsf(z_w_ang) < MIN_DETUMBLE_ANGLE && fabsf(W_target_diff) < OMEGA_TARGET_LEEWAY)
+        {
+            next_mode = STATE_ACS_NIGHT;
+            ctx->first_detumble = 0; // when system detumbles for the first time, unsets this variable
+        }
+        if (!ctx->first_detumble) // if this var is unset, the system does not do anything at night
+        {
+            if (NORM(avgSun) < 0.8f)
+            {
+                next_mode = STATE_ACS_NIGHT;
+            }
+        }
+    }
+
+    else if (ctx->mode == STATE_ACS_SUNPOINT)
+    {
+        // If detumble criterion is not held, fall back to detumbling
+        if (fabsf(z_w_ang) > MIN_DETUMBLE_ANGLE || fabsf(W_target_diff) > OMEGA_TARGET_LEEWAY * 3) // extra leeway for exact value of w_z
+        {
+            next_mode = STATE_ACS_DETUMBLE;
+        }
+        // if it is night, fall back to night mode. Should take SH_BUFFER_SIZE * DETUMBLE_TIME_STEP seconds for the actual state change to occur
+        if (NORM(avgSun) < 0.8f)
+        {
+            next_mode = STATE_ACS_NIGHT;
+        }
+        // if the satellite is detumbled, it is not night and the sun angle is less than 4 deg, declare ACS is ready
+        if (fabsf(z_S_ang) < MIN_SOL_ANGLE)
+        {
+            next_mode = STATE_ACS_READY;
+        }
+    }
+
+    else if (ctx->mode == STATE_ACS_NIGHT)
+    {
+        if (NORM(avgSun) > 0.8f)
+        {
+            if (fabsf(z_w_ang) > MIN_DETUMBLE_ANGLE || fabsf(W_target_diff) > OMEGA_TARGET_LEEWAY)
+            {
+                next_mode = STATE_ACS_DETUMBLE;
+            }
+            if (fabsf(z_S_ang) < MIN_SOL_ANGLE)
+            {
+                next_mode = STATE_ACS_READY;
+            }
+            else
+                next_mode = STATE_ACS_SUNPOINT;
+        }
+    }
+
+    else if (ctx->mode == STATE_ACS_READY)
+    {
+        if (NORM(avgSun) < 0.8f) // transition to night
+            next_mode = STATE_ACS_NIGHT;
+        else
+        {
+            if (fabsf(z_w_ang) > MIN_DETUMBLE_ANGLE || fabsf(W_target_diff) > OMEGA_TARGET_LEEWAY) // Detumble required
+            {
+                next_mode = STATE_ACS_DETUMBLE;
+            }
+            if (fabsf(z_S_ang) > MIN_SOL_ANGLE) // sunpointing required
+            {
+                next_mode = STATE_ACS_SUNPOINT;
+            }
+            else // everything good
+            {
+                next_mode = STATE_ACS_READY;
+            }
+        }
+    }
+    ctx->mode = next_mode; // update the state
+}
+
+void acs_estimate(acs_ctx *ctx, const acs_input *in, uint64_t now, acs_cmd *cmd)
+{
+    memset(cmd, 0, sizeof(acs_cmd));
+    cmd->type = ACS_CMD_IDLE;
+    ctx->step++;
+    ctx->t_acs = now;
+    cmd->status = processSensors(ctx, in);
+    if (cmd->status < 0) // hard fault in readings
+    {
+        ctx->hard_faults++;
+        acs_ctx_flush(ctx);
+    }
+}
+
+void acs_command(acs_ctx *ctx, acs_cmd *cmd)
+{
+    if (cmd->status == 0) // no new sample
+        return;
+    if (ctx->mode == STATE_ACS_DETUMBLE)
+        detumbleCommand(ctx, cmd);
+    else if (ctx->mode == STATE_ACS_SUNPOINT)
+        sunpointCommand(ctx, cmd);
+}
+
+void acs_update(acs_ctx *ctx, const acs_input *in, uint64_t now, acs_cmd *cmd)
+{
+    acs_estimate(ctx, in, now, cmd);
+    checkTransition(ctx); // check if the system should transition from one state to another
+}
+
+acs_cmd acs_step(acs_ctx *ctx, const acs_input *in, uint64_t now)
+{
+    acs_cmd cmd;
+    acs_update(ctx, in, now, &cmd);
+    acs_command(ctx, &cmd);
+    return cmd;
+}
+
+void detumbleCommand(acs_ctx *ctx, acs_cmd *cmd)
+{
+    if (ctx->omega_index < 0)
+        return;
+    ALIAS_BUFFER(B, ctx, double);
+    ALIAS_BUFFER(W, ctx, float);
+    ALIAS_VECTOR(L_target, ctx, float);
+    DECLARE_VECTOR(currL, double);                     // vector for current angular momentum
+    MATVECMUL(currL, ctx->MOI, W[ctx->omega_index]); // calculate current angular momentum
+    VECTOR_OP(currL, L_target, currL, -);              // calculate angular momentum error
+    DECLARE_VECTOR(currLNorm, float);
+    NORMALIZE(currLNorm, currL); // normalize the angular momentum error vector
+    DECLARE_VECTOR(currB, double);         // current normalized magnetic field TMP
+    NORMALIZE(currB, B[ctx->mag_index]); // normalize B
+    DECLARE_VECTOR(firingDir, float);           // firing direction vector
+    CROSS_PRODUCT(firingDir, currB, currLNorm); // calculate firing direction
+    int8_t x_fire = (x_firingDir < 0 ? -1 : 1);                        // if > 0.01, then fire in the direction of input
+    int8_t y_fire = (y_firingDir < 0 ? -1 : 1);                        // * (abs(y_firingDir) > 0.01 ? 1 : 0); // if > 0.01, then fire in the direction of input
+    int8_t z_fire = (z_firingDir < 0 ? -1 : 1);                        // * (abs(z_firingDir) > 0.01 ? 1 : 0); // if > 0.01, then fire in the direction of input
+    x_fire *= x_firingDir * (x_firingDir < 0 ? -1 : 1) > 0.01 ? 1 : 0; // if > 0.01, then fire in the direction of input
+    y_fire *= y_firingDir * (y_firingDir < 0 ? -1 : 1) > 0.01 ? 1 : 0; // if > 0.01, then fire in the direction of input
+    z_fire *= z_firingDir * (z_firingDir < 0 ? -1 : 1) > 0.01 ? 1 : 0; // if > 0.01, then fire in the direction of input
+    DECLARE_VECTOR(currDipole, float);
+    VECTOR_MIXED(currDipole, fire, DIPOLE_MOMENT * 1e-7, *); // calculate dipole moment, account for B in milliGauss
+    DECLARE_VECTOR(currTorque, float);
+    CROSS_PRODUCT(currTorque, currDipole, B[ctx->mag_index]); // calculate current torque
+    DECLARE_VECTOR(firingTime, float);           // initially gives firing time in seconds
+    VECTOR_OP(firingTime, currL, currTorque, /); // calculate firing time based on current torque
+    VECTOR_MIXED(firingTime, firingTime, 1000000, *); // convert firing time to usec
+    cmd->type = ACS_CMD_DETUMBLE;
+    cmd->x_fire = x_fire;
+    cmd->y_fire = y_fire;
+    cmd->z_fire = z_fire;
+    cmd->x_firingCmd = x_firingTime > MAX_DETUMBLE_FIRING_TIME ? MAX_DETUMBLE_FIRING_TIME : (x_firingTime < MIN_DETUMBLE_FIRING_TIME ? 0 : (int)x_firingTime);
+    cmd->y_firingCmd = y_firingTime > MAX_DETUMBLE_FIRING_TIME ? MAX_DETUMBLE_FIRING_TIME : (y_firingTime < MIN_DETUMBLE_FIRING_TIME ? 0 : (int)y_firingTime);
+    cmd->z_firingCmd = z_firingTime > MAX_DETUMBLE_FIRING_TIME ? MAX_DETUMBLE_FIRING_TIME : (z_firingTime < MIN_DETUMBLE_FIRING_TIME ? 0 : (int)z_firingTime);
+}
+
+void sunpointCommand(acs_ctx *ctx, acs_cmd *cmd)
+{
+    if (ctx->sol_index < 0)
+        return;
+    ALIAS_BUFFER(B, ctx, double);
+    ALIAS_BUFFER(W, ctx, float);
+    ALIAS_BUFFER(S, ctx, float);
+    DECLARE_VECTOR(currB, float);
+    DECLARE_VECTOR(currBNorm, float);
+    DECLARE_VECTOR(currL, float);
+    DECLARE_VECTOR(currS, float);
+    DECLARE_VECTOR(currSNorm, float);
+    VECTOR_OP(currB, currB, B[ctx->mag_index], +);   // get current magfield
+    NORMALIZE(currBNorm, currB);                       // normalize current magfield
+    MATVECMUL(currL, ctx->MOI, W[ctx->omega_index]); // calculate current angular momentum
+    VECTOR_OP(currS, currS, S[ctx->sol_index], +);   // get current sunvector
+    NORMALIZE(currSNorm, currS);                       // normalize sun vector
+    // calculate S_B_hat
+    DECLARE_VECTOR(SBHat, float);
+    float SdotB = DOT_PRODUCT(currSNorm, currBNorm);
+    VECTOR_MIXED(SBHat, currBNorm, SdotB, *);
+    VECTOR_OP(SBHat, currSNorm, SBHat, +);
+    NORMALIZE(SBHat, SBHat);
+    // calculate L_B_hat
+    DECLARE_VECTOR(LBHat, float);
+    float LdotB = DOT_PRODUCT(currL, currBNorm);
+    VECTOR_MIXED(LBHat, currBNorm, LdotB, *);
+    VECTOR_OP(LBHat, currL, LBHat, +);
+    NORMALIZE(LBHat, LBHat);
+    // cross product the two vectors
+    DECLARE_VECTOR(SxBxL, float);
+    CROSS_PRODUCT(SxBxL, SBHat, LBHat);
+    NORMALIZE(SxBxL, SxBxL);
+    float sun_ang = fabs(z_S[ctx->sol_index]);
+    uint8_t gain = round(sun_ang * 32);
+    gain = gain < 1 ? 1 : gain;                                                      // do not allow gain to be lower than one
+    int time_on = (int)(DOT_PRODUCT(SxBxL, currBNorm) * SUNPOINT_DUTY_CYCLE * gain); // essentially a duty cycle measure
+#ifdef SUNPOINT_DEBUG
+    printf("[SUNPOINT] %d", time_on);
+#endif // SUNPOINT_DEBUG
+    int dir = time_on > 0 ? 1 : -1;
+    time_on = time_on > 0 ? time_on : -time_on;
+    time_on = time_on > SUNPOINT_DUTY_CYCLE ? SUNPOINT_DUTY_CYCLE : time_on; // safety measure
+    if (time_on < 5000 && time_on > 2499)
+        time_on = 5000;
+    time_on = 10000 * round(time_on / 10000.0f); // added rounding to increase gain
+    time_on /= 5000;
+    time_on *= 5000; // granularity of 5 ms, essentially 5 bit precision
+#ifdef SUNPOINT_DEBUG
+    printf("[SUNPOINT] %d\n", time_on);
+#endif // SUNPOINT_DEBUG
+    cmd->type = ACS_CMD_SUNPOINT;
+    cmd->z_fire = dir; // z direction is the only direction of fire
+    cmd->time_on = time_on;
+}
@@ -0,0 +1,224 @@
+/**
+ * @file acs_ekf.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Extended Kalman filter of the angular speed for the Attitude Control System.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include <acs_ekf.h>
+#include <math.h>
+#include <string.h>
+
+#define N ACS_EKF_STATES
+
+/**
+ * @brief Sets m to the cross product matrix of v, i.e. m u = v x u.
+ *
+ */
+static inline void skew(double m[3][3], const double v[3])
+{
+    m[0][0] = 0;
+    m[0][1] = -v[2];
+    m[0][2] = v[1];
+    m[1][0] = v[2];
+    m[1][1] = 0;
+    m[1][2] = -v[0];
+    m[2][0] = -v[1];
+    m[2][1] = v[0];
+    m[2][2] = 0;
+}
+
+/**
+ * @brief Sets R to the rotation by the rotation vector th (Rodrigues' formula).
+ *
+ */
+static void rotation(double R[3][3], const double th[3])
+{
+    double a2 = th[0] * th[0] + th[1] * th[1] + th[2] * th[2];
+    double s, c; // sin(a) / a and (1 - cos(a)) / a^2
+    if (a2 < 1e-8)
+    {
+        s = 1 - a2 / 6;
+        c = 0.5 - a2 / 24;
+    }
+    else
+    {
+        double a = sqrt(a2);
+        s = sin(a) / a;
+        c = (1 - cos(a)) / a2;
+    }
+    double K[3][3];
+    skew(K, th);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+        {
+            double K2 = K[i][0] * K[0][j] + K[i][1] * K[1][j] + K[i][2] * K[2][j];
+            R[i][j] = (i == j) + s * K[i][j] + c * K2;
+        }
+}
+
+/**
+ * @brief Updates the state with a measurement z = H x of three states, with noise variance
+ * r on every axis. H selects the three states starting at off, plus the three states
+ * starting at add if add is positive (gyroscope: angular speed plus bias).
+ *
+ */
+static int update3(acs_ekf *f, int off, int add, const double z[3], double r)
+{
+    double HP[3][N]; // H P, rows of P that are measured
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < N; j++)
+            HP[i][j] = f->P[off + i][j] + (add > 0 ? f->P[add + i][j] : 0);
+    double S[3][3], Si[3][3];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            S[i][j] = HP[i][off + j] + (add > 0 ? HP[i][add + j] : 0) + (i == j ? r : 0);
+    Si[0][0] = S[1][1] * S[2][2] - S[1][2] * S[2][1];
+    Si[0][1] = S[0][2] * S[2][1] - S[0][1] * S[2][2];
+    Si[0][2] = S[0][1] * S[1][2] - S[0][2] * S[1][1];
+    double det = S[0][0] * Si[0][0] + S[1][0] * Si[0][1] + S[2][0] * Si[0][2];
+    if (!(det > 0)) // the innovation covariance is positive definite unless the state diverged
+        return -1;
+    Si[1][0] = S[1][2] * S[2][0] - S[1][0] * S[2][2];
+    Si[1][1] = S[0][0] * S[2][2] - S[0][2] * S[2][0];
+    Si[1][2] = S[0][2] * S[1][0] - S[0][0] * S[1][2];
+    Si[2][0] = S[1][0] * S[2][1] - S[1][1] * S[2][0];
+    Si[2][1] = S[0][1] * S[2][0] - S[0][0] * S[2][1];
+    Si[2][2] = S[0][0] * S[1][1] - S[0][1] * S[1][0];
+    double K[N][3]; // Kalman gain, P H^T S^-1
+    for (int i = 0; i < N; i++)
+        for (int j = 0; j < 3; j++)
+            K[i][j] = (HP[0][i] * Si[0][j] + HP[1][i] * Si[1][j] + HP[2][i] * Si[2][j]) / det;
+    double y[3]; // innovation
+    for (int i = 0; i < 3; i++)
+        y[i] = z[i] - f->x[off + i] - (add > 0 ? f->x[add + i] : 0);
+    for (int i = 0; i < N; i++)
+        f->x[i] += K[i][0] * y[0] + K[i][1] * y[1] + K[i][2] * y[2];
+    for (int i = 0; i < N; i++)
+        for (int j = 0; j < N; j++)
+            f->P[i][j] -= K[i][0] * HP[0][j] + K[i][1] * HP[1][j] + K[i][2] * HP[2][j];
+    for (int i = 0; i < N; i++) // keep the covariance symmetric against rounding
+        for (int j = 0; j < i; j++)
+            f->P[i][j] = f->P[j][i] = 0.5 * (f->P[i][j] + f->P[j][i]);
+    return 1;
+}
+
+void acs_ekf_init(acs_ekf *f)
+{
+    memset(f, 0, sizeof(acs_ekf));
+}
+
+void acs_ekf_predict(acs_ekf *f, uint64_t t, const float MOI[3][3], const float IMOI[3][3])
+{
+    if (!f->samples || t <= f->t)
+        return;
+    double dt = (t - f->t) * 1e-6;
+    f->t = t;
+    double *B = f->x, *W = f->x + 3;
+    // the field rotates by -W dt in the body frame
+    double th[3] = {-W[0] * dt, -W[1] * dt, -W[2] * dt};
+    double R[3][3];
+    rotation(R, th);
+    // torque free Euler equation, dW/dt = I^-1 (-W x I W)
+    double I[3][3], Ii[3][3], L[3], WxL[3];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+        {
+            I[i][j] = MOI[i][j];
+            Ii[i][j] = IMOI[i][j];
+        }
+    for (int i = 0; i < 3; i++)
+        L[i] = I[i][0] * W[0] + I[i][1] * W[1] + I[i][2] * W[2];
+    WxL[0] = W[1] * L[2] - W[2] * L[1];
+    WxL[1] = W[2] * L[0] - W[0] * L[2];
+    WxL[2] = W[0] * L[1] - W[1] * L[0];
+    // Jacobian of the transition, the bias is constant
+    double F[N][N] = {{0}};
+    for (int i = 6; i < N; i++)
+        F[i][i] = 1;
+    double Bx[3][3], Wx[3][3], Lx[3][3], D[3][3];
+    skew(Bx, B);
+    skew(Wx, W);
+    skew(Lx, L);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            D[i][j] = Lx[i][j] - (Wx[i][0] * I[0][j] + Wx[i][1] * I[1][j] + Wx[i][2] * I[2][j]); // d(-W x I W)/dW
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+        {
+            F[i][j] = R[i][j];
+            F[i][3 + j] = dt * Bx[i][j]; // d(-W x B)/dW = [B]x
+            F[3 + i][3 + j] = (i == j) + dt * (Ii[i][0] * D[0][j] + Ii[i][1] * D[1][j] + Ii[i][2] * D[2][j]);
+        }
+    // propagate the state
+    double Bn[3];
+    for (int i = 0; i < 3; i++)
+        Bn[i] = R[i][0] * B[0] + R[i][1] * B[1] + R[i][2] * B[2];
+    for (int i = 0; i < 3; i++)
+    {
+        B[i] = Bn[i];
+        W[i] -= dt * (Ii[i][0] * WxL[0] + Ii[i][1] * WxL[1] + Ii[i][2] * WxL[2]);
+    }
+    // propagate the covariance, P = F P F^T + Q
+    double FP[N][N];
+    for (int i = 0; i < N; i++)
+        for (int j = 0; j < N; j++)
+        {
+            double s = 0;
+            for (int k = 0; k < N; k++)
+                s += F[i][k] * f->P[k][j];
+            FP[i][j] = s;
+        }
+    for (int i = 0; i < N; i++)
+        for (int j = 0; j <= i; j++)
+        {
+            double s = 0;
+            for (int k = 0; k < N; k++)
+                s += FP[i][k] * F[j][k];
+            f->P[i][j] = f->P[j][i] = s;
+        }
+    for (int i = 0; i < 3; i++)
+    {
+        f->P[i][i] += ACS_EKF_FIELD_NOISE * ACS_EKF_FIELD_NOISE * dt;
+        f->P[3 + i][3 + i] += ACS_EKF_OMEGA_NOISE * ACS_EKF_OMEGA_NOISE * dt;
+        f->P[6 + i][6 + i] += ACS_EKF_BIAS_NOISE * ACS_EKF_BIAS_NOISE * dt;
+    }
+}
+
+int acs_ekf_mag(acs_ekf *f, const double B[3], uint64_t t)
+{
+    if (!isfinite(B[0]) || !isfinite(B[1]) || !isfinite(B[2]))
+        return -1;
+    if (!f->samples) // first reading
+    {
+        memset(f->P, 0, sizeof(f->P));
+        for (int i = 0; i < 3; i++)
+        {
+            f->x[i] = B[i];
+            f->x[3 + i] = 0;
+            f->x[6 + i] = 0;
+            f->P[i][i] = ACS_EKF_MAG_NOISE * ACS_EKF_MAG_NOISE;
+            f->P[3 + i][3 + i] = ACS_EKF_OMEGA_INIT * ACS_EKF_OMEGA_INIT;
+            f->P[6 + i][6 + i] = ACS_EKF_BIAS_INIT * ACS_EKF_BIAS_INIT;
+        }
+        f->t = t;
+        f->samples = 1;
+        return 1;
+    }
+    if (update3(f, 0, -1, B, ACS_EKF_MAG_NOISE * ACS_EKF_MAG_NOISE) < 0)
+        return -1;
+    f->samples++;
+    return 1;
+}
+
+int acs_ekf_gyro(acs_ekf *f, const double W[3], double sigma)
+{
+    if (!isfinite(W[0]) || !isfinite(W[1]) || !isfinite(W[2]))
+        return -1;
+    if (!f->samples)
+        return 0;
+    return update3(f, 3, 6, W, sigma * sigma);
+}
@@ -0,0 +1,102 @@
+/**
+ * @file acs_hist.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Lock-free latency histograms with logarithmic buckets for the phases of the ACS cycle.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include <acs_hist.h>
+#include <sh_time.h>
+#include <string.h>
+
+#define HIST_SUB (1 << ACS_HIST_SUB_BITS)
+
+/**
+ * @brief Returns the bucket of a value. Values below 2 * HIST_SUB have a bucket each,
+ * above that every power of two has HIST_SUB buckets.
+ *
+ */
+static inline int hist_index(uint64_t v)
+{
+    if (v < HIST_SUB)
+        return (int)v;
+    int msb = 63 - __builtin_clzll(v);
+    if (msb >= ACS_HIST_MAX_BITS)
+        return ACS_HIST_BUCKETS - 1;
+    int shift = msb - ACS_HIST_SUB_BITS;
+    return ((shift + 1) << ACS_HIST_SUB_BITS) + (int)(v >> shift) - HIST_SUB;
+}
+
+/**
+ * @brief Returns the largest value of a bucket.
+ *
+ */
+static inline uint64_t hist_upper(int i)
+{
+    if (i < HIST_SUB)
+        return (uint64_t)i;
+    int shift = (i >> ACS_HIST_SUB_BITS) - 1;
+    uint64_t mant = (uint64_t)((i & (HIST_SUB - 1)) + HIST_SUB);
+    return ((mant + 1) << shift) - 1;
+}
+
+void acs_hist_init(acs_hist *h)
+{
+    memset(h, 0, sizeof(acs_hist));
+}
+
+void acs_hist_add(acs_hist *h, uint64_t v)
+{
+    // single writer: plain increments, published with relaxed atomic stores so that readers never see torn values
+    uint32_t *b = &h->bucket[hist_index(v)];
+    __atomic_store_n(b, *b + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->count, h->count + 1, __ATOMIC_RELAXED);
+    if (v > h->max)
+        __atomic_store_n(&h->max, v, __ATOMIC_RELAXED);
+}
+
+uint64_t acs_hist_count(const acs_hist *h)
+{
+    return __atomic_load_n(&h->count, __ATOMIC_RELAXED);
+}
+
+uint64_t acs_hist_max(const acs_hist *h)
+{
+    return __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+}
+
+uint64_t acs_hist_percentile(const acs_hist *h, double p)
+{
+    uint32_t snap[ACS_HIST_BUCKETS]; // consistent total for the ranks even while the writer adds values
+    uint64_t total = 0;
+    for (int i = 0; i < ACS_HIST_BUCKETS; i++)
+    {
+        snap[i] = __atomic_load_n(&h->bucket[i], __ATOMIC_RELAXED);
+        total += snap[i];
+    }
+    uint64_t max = acs_hist_max(h);
+    if (total == 0)
+        return 0;
+    uint64_t rank = (uint64_t)(p / 100.0 * total + 0.5); // number of values at or below the percentile
+    if (rank < 1)
+        rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < ACS_HIST_BUCKETS; i++)
+    {
+        seen += snap[i];
+        if (seen >= rank)
+        {
+            uint64_t v = hist_upper(i);
+            return (v < max && i < ACS_HIST_BUCKETS - 1) ? v : max; // the last bucket is open ended
+        }
+    }
+    return max;
+}
+
+uint64_t acs_hist_now(void)
+{
+    return sh_time_nsec();
+}
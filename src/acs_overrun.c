@@ -0,0 +1,50 @@
+/**
+ * @file acs_overrun.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Degraded cycle policy of the Attitude Control System.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include <acs_overrun.h>
+#include <string.h>
+
+void acs_overrun_init(acs_overrun *o)
+{
+    memset(o, 0, sizeof(acs_overrun));
+}
+
+ACS_WINDOW acs_overrun_window(acs_overrun *o, uint64_t now, acs_timeline *tl, uint64_t start)
+{
+    int hold = __atomic_load_n(&o->hold, __ATOMIC_RELAXED);
+    if (now <= start) // in time
+    {
+        if (hold > 0)
+            __atomic_store_n(&o->hold, hold - 1, __ATOMIC_RELAXED);
+        return ACS_WINDOW_FULL;
+    }
+    o->overruns++;
+    __atomic_store_n(&o->hold, ACS_OVERRUN_HOLD, __ATOMIC_RELAXED);
+    uint64_t end = tl->n > 0 ? tl->ev[tl->n - 1].t : start; // the last event ends the window
+    if (end <= now || end - now < ACS_OVERRUN_MIN_WINDOW)
+    {
+        tl->n = 0;
+        o->skipped++;
+        return ACS_WINDOW_SKIPPED;
+    }
+    acs_timeline_clip(tl, now);
+    o->shrunk++;
+    return ACS_WINDOW_SHRUNK;
+}
+
+int acs_overrun_read_css(acs_overrun *o)
+{
+    if (__atomic_load_n(&o->hold, __ATOMIC_RELAXED) > 0)
+    {
+        o->css_dropped++;
+        return 0;
+    }
+    return 1;
+}
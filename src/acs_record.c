@@ -0,0 +1,59 @@
+/**
+ * @file acs_record.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Recording of ACS sensor inputs and commands for replay.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+#include <acs_record.h>
+#include <string.h>
+
+int acs_record_write(FILE *fp, uint64_t t, const acs_input *in, const acs_cmd *cmd)
+{
+    if (fp == NULL)
+        return -1;
+    int n = fprintf(fp, "%llu %d %a %a %a", (unsigned long long)t, in->status, in->x_B, in->y_B, in->z_B);
+    for (int i = 0; i < 9; i++)
+        n += fprintf(fp, " %a", in->CSS[i]);
+    n += fprintf(fp, " %a %a", in->FSS[0], in->FSS[1]);
+    n += fprintf(fp, " %d %d %d %d %d %d %d %d %d %d", cmd->status, cmd->type, cmd->x_fire, cmd->y_fire, cmd->z_fire, cmd->x_firingCmd, cmd->y_firingCmd, cmd->z_firingCmd, cmd->time_on, in->fault);
+    n += fprintf(fp, " %d %a %a %a\n", in->gyro, in->x_G, in->y_G, in->z_G);
+    return n;
+}
+
+int acs_record_read(FILE *fp, uint64_t *t, acs_input *in, acs_cmd *cmd)
+{
+    unsigned long long tl;
+    int type, fire[3];
+    memset(in, 0, sizeof(acs_input));
+    memset(cmd, 0, sizeof(acs_cmd));
+    int n = fscanf(fp, "%llu %d %la %la %la", &tl, &(in->status), &(in->x_B), &(in->y_B), &(in->z_B));
+    if (n == EOF)
+        return 0;
+    if (n != 5)
+        return -1;
+    for (int i = 0; i < 9; i++)
+        n += fscanf(fp, "%a", &(in->CSS[i]));
+    n += fscanf(fp, "%a %a", &(in->FSS[0]), &(in->FSS[1]));
+    n += fscanf(fp, "%d %d %d %d %d %d %d %d %d", &(cmd->status), &type, &fire[0], &fire[1], &fire[2], &(cmd->x_firingCmd), &(cmd->y_firingCmd), &(cmd->z_firingCmd), &(cmd->time_on));
+    if (n != 25)
+        return -1;
+    char rest[128]; // soft faults and gyroscope of the input, missing in older records
+    if (fgets(rest, sizeof(rest), fp) != NULL)
+    {
+        int m = sscanf(rest, "%d %d %la %la %la", &(in->fault), &(in->gyro), &(in->x_G), &(in->y_G), &(in->z_G));
+        if (m < 1)
+            in->fault = 0;
+        if (m < 5)
+            in->gyro = 0;
+    }
+    *t = in->t_B = tl; // recorded with the time of the magnetometer reading
+    cmd->type = type;
+    cmd->x_fire = fire[0];
+    cmd->y_fire = fire[1];
+    cmd->z_fire = fire[2];
+    return 1;
+}
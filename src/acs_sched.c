@@ -0,0 +1,83 @@
+/**
+ * @file acs_sched.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Periodic scheduler with absolute deadlines for the Attitude Control System loop.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include <acs_sched.h>
+#include <acs_core.h>
+#include <string.h>
+
+/**
+ * @brief Records the lateness of a phase at the given time.
+ *
+ */
+static inline void sched_mark(acs_sched *s, int phase, uint64_t now)
+{
+    acs_lateness_add(&s->lateness[phase], (int64_t)(now - (s->t0 + s->offset[phase])), ACS_SCHED_TOLERANCE);
+}
+
+void acs_lateness_add(acs_lateness *l, int64_t late, int64_t tolerance)
+{
+    l->last = late;
+    l->sum += late;
+    if (l->count++ == 0 || late > l->max)
+        l->max = late;
+    if (late > tolerance)
+        l->late++;
+}
+
+void acs_sched_init(acs_sched *s, acs_clock *clk)
+{
+    memset(s, 0, sizeof(acs_sched));
+    s->clk = clk;
+    s->period = DETUMBLE_TIME_STEP;
+    s->offset[ACS_PHASE_MEASURE] = 0;
+    s->offset[ACS_PHASE_DECIDE] = MEASURE_TIME;
+    s->offset[ACS_PHASE_ACTUATE] = MEASURE_TIME;
+}
+
+uint64_t acs_sched_wait(acs_sched *s)
+{
+    uint64_t now = acs_clock_now(s->clk);
+    if (s->cycles == 0)
+        s->t0 = now;
+    else
+    {
+        s->t0 += s->period;
+        if (now >= s->t0 + s->period) // more than a period behind, resume at the current cycle
+        {
+            uint64_t missed = (now - s->t0) / s->period;
+            s->t0 += missed * s->period;
+            s->skipped += missed;
+        }
+    }
+    s->cycles++;
+    acs_clock_sleep_until(s->clk, s->t0);
+    now = acs_clock_now(s->clk);
+    sched_mark(s, ACS_PHASE_MEASURE, now);
+    return now;
+}
+
+void acs_sched_decided(acs_sched *s)
+{
+    sched_mark(s, ACS_PHASE_DECIDE, acs_clock_now(s->clk));
+}
+
+uint64_t acs_sched_actuate(acs_sched *s)
+{
+    uint64_t t = s->t0 + s->offset[ACS_PHASE_ACTUATE];
+    acs_clock_sleep_until(s->clk, t);
+    sched_mark(s, ACS_PHASE_ACTUATE, acs_clock_now(s->clk));
+    return t;
+}
+
+uint64_t acs_sched_handoff(acs_sched *s)
+{
+    sched_mark(s, ACS_PHASE_ACTUATE, acs_clock_now(s->clk));
+    return s->t0 + s->offset[ACS_PHASE_ACTUATE];
+}
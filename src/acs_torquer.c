@@ -0,0 +1,119 @@
+/**
+ * @file acs_torquer.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Event timeline of the magnetorquers.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include <acs.h>
+#include <acs_torquer.h>
+
+/**
+ * @brief Adds an event to the timeline, keeping the events sorted by time. Events
+ * with the same time stay in the order they were added.
+ *
+ */
+static inline void timeline_add(acs_timeline *tl, uint64_t t, int axis, int dir)
+{
+    if (tl->n >= ACS_TIMELINE_MAX)
+        return;
+    int i = tl->n++;
+    while (i > 0 && tl->ev[i - 1].t > t)
+    {
+        tl->ev[i] = tl->ev[i - 1];
+        i--;
+    }
+    tl->ev[i].t = t;
+    tl->ev[i].axis = axis;
+    tl->ev[i].dir = dir;
+}
+
+/**
+ * @brief Adds events for all three torquers at the given time.
+ *
+ */
+static inline void timeline_add3(acs_timeline *tl, uint64_t t, int x, int y, int z)
+{
+    timeline_add(tl, t, 0, x);
+    timeline_add(tl, t, 1, y);
+    timeline_add(tl, t, 2, z);
+}
+
+void acs_timeline_build(const acs_cmd *cmd, uint64_t start, acs_timeline *tl)
+{
+    tl->n = 0;
+    if (cmd->type == ACS_CMD_DETUMBLE)
+    {
+        const int firingTime[3] = {cmd->x_firingCmd, cmd->y_firingCmd, cmd->z_firingCmd};
+        timeline_add3(tl, start, cmd->x_fire, cmd->y_fire, cmd->z_fire);
+        for (int i = 0; i < 3; i++)
+            timeline_add(tl, start + (firingTime[i] < 1 ? 1 : firingTime[i]), i, 0);
+        timeline_add3(tl, start + MAX_DETUMBLE_FIRING_TIME, 0, 0, 0); // all off for the next measurement
+    }
+    else if (cmd->type == ACS_CMD_SUNPOINT)
+    {
+        uint64_t end = start + COARSE_TIME_STEP - MEASURE_TIME; // time allowed to fire
+        for (uint64_t t = start; t < end; t += SUNPOINT_DUTY_CYCLE)
+        {
+            timeline_add3(tl, t, cmd->x_fire, cmd->y_fire, cmd->z_fire);
+            if (cmd->time_on < SUNPOINT_DUTY_CYCLE)
+                timeline_add3(tl, t + cmd->time_on, 0, 0, 0);
+        }
+        timeline_add3(tl, end, 0, 0, 0);
+    }
+    else
+        timeline_add3(tl, start + DETUMBLE_TIME_STEP - MEASURE_TIME, 0, 0, 0);
+}
+
+void acs_timeline_clip(acs_timeline *tl, uint64_t t)
+{
+    int state[3] = {0, 0, 0};
+    int i = 0;
+    for (; i < tl->n && tl->ev[i].t <= t; i++) // net state of the events due by t
+        state[tl->ev[i].axis] = tl->ev[i].dir;
+    if (i == 0)
+        return;
+    acs_timeline rest = *tl;
+    tl->n = 0;
+    timeline_add3(tl, t, state[0], state[1], state[2]);
+    for (; i < rest.n; i++)
+        timeline_add(tl, rest.ev[i].t, rest.ev[i].axis, rest.ev[i].dir);
+}
+
+/**
+ * @brief Waits for the time of an event. The wall clock sleeps until ACS_TORQUER_SPIN
+ * before the event and busy waits for the rest.
+ *
+ */
+static inline void timeline_wait(acs_clock *clk, uint64_t t)
+{
+    if (clk->type != ACS_CLOCK_WALL || t < ACS_TORQUER_SPIN)
+    {
+        acs_clock_sleep_until(clk, t);
+        return;
+    }
+    acs_clock_sleep_until(clk, t - ACS_TORQUER_SPIN);
+    while (acs_clock_now(clk) < t)
+        ;
+}
+
+void acs_timeline_run(acs_clock *clk, const acs_timeline *tl, acs_lateness *err, acs_hist *hist)
+{
+    int state[3] = {0, 0, 0};
+    for (int i = 0; i < tl->n;)
+    {
+        uint64_t t = tl->ev[i].t;
+        for (; i < tl->n && tl->ev[i].t == t; i++) // apply all events at this time together
+            state[tl->ev[i].axis] = tl->ev[i].dir;
+        timeline_wait(clk, t);
+        hbridge_enable(state[0], state[1], state[2]);
+        int64_t late = (int64_t)(acs_clock_now(clk) - t);
+        if (err != NULL)
+            acs_lateness_add(err, late, ACS_TORQUER_TOLERANCE);
+        if (hist != NULL)
+            acs_hist_add(hist, (uint64_t)(late < 0 ? -late : late) * 1000);
+    }
+}
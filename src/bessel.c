@@ -9,13 +9,31 @@
  * 
  */
 #include <bessel.h>
+#include <complex.h>
+#include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**
- * @brief Coefficients for the Bessel filter, calculated using calculateBessel().
+ * @brief SIMD register of doubles, used by the fused filter kernels.
  * 
  */
-float bessel_coeff[SH_BUFFER_SIZE]; // coefficients for Bessel filter, declared as floating point
+typedef double bessel_vd __attribute__((vector_size(BESSEL_SIMD_BYTES)));
+/**
+ * @brief SIMD register of floats, used by the fused filter kernels.
+ * 
+ */
+typedef float bessel_vf __attribute__((vector_size(BESSEL_SIMD_BYTES)));
+/**
+ * @brief Number of doubles in a SIMD register.
+ * 
+ */
+#define BESSEL_DLANES ((int)(BESSEL_SIMD_BYTES / sizeof(double)))
+/**
+ * @brief Number of floats in a SIMD register.
+ * 
+ */
+#define BESSEL_FLANES ((int)(BESSEL_SIMD_BYTES / sizeof(float)))
 
 /**
  * @brief Calculates factorial of the input. This function is inlined, and is available only in the scope of bessel.c.
@@ -63,7 +81,7 @@ void calculateBessel(float arr[], int size, int order, float freq_cutoff)
     return;
 }
 
-double dfilterBessel(double arr[], int index)
+double dfilterBessel(const float coeff[], double arr[], int index)
 {
     double val = 0;
     // index is guaranteed to be a number between 0...SH_BUFFER_SIZE by the readSensors() or getOmega() function.
@@ -71,19 +89,19 @@ double dfilterBessel(double arr[], int index)
     double coeff_sum = 0; // sum of the coefficients to calculate weighted average
     for (int i = index;;) // initiate the loop, break condition will be dealt with inside the loop
     {
-        val += bessel_coeff[coeff_index] * arr[i]; // add weighted value
-        coeff_sum += bessel_coeff[coeff_index];    // sum the weights to average with
+        val += coeff[coeff_index] * arr[i]; // add weighted value
+        coeff_sum += coeff[coeff_index];    // sum the weights to average with
         i--;                                       // read the previous element
         i = i < 0 ? SH_BUFFER_SIZE - 1 : i;        // allow for circular buffer issues
         coeff_index++;                             // use the next coefficient
         // looped around to the same element, coefficient crosses threshold OR (should never come to this) coeff_index overflows, break loop
-        if (i == index || bessel_coeff[coeff_index] < BESSEL_MIN_THRESHOLD || coeff_index > SH_BUFFER_SIZE)
+        if (i == index || coeff[coeff_index] < BESSEL_MIN_THRESHOLD || coeff_index > SH_BUFFER_SIZE)
             break;
     }
     return val / coeff_sum;
 }
 
-float ffilterBessel(float arr[], int index)
+float ffilterBessel(const float coeff[], float arr[], int index)
 {
     float val = 0;
     // index is guaranteed to be a number between 0...SH_BUFFER_SIZE by the readSensors() or getOmega() function.
@@ -91,14 +109,271 @@ float ffilterBessel(float arr[], int index)
     float coeff_sum = 0;  // sum of the coefficients to calculate weighted average
     for (int i = index;;) // initiate the loop, break condition will be dealt with inside the loop
     {
-        val += bessel_coeff[coeff_index] * arr[i]; // add weighted value
-        coeff_sum += bessel_coeff[coeff_index];    // sum the weights to average with
+        val += coeff[coeff_index] * arr[i]; // add weighted value
+        coeff_sum += coeff[coeff_index];    // sum the weights to average with
         i--;                                       // read the previous element
         i = i < 0 ? SH_BUFFER_SIZE - 1 : i;        // allow for circular buffer issues
         coeff_index++;                             // use the next coefficient
         // looped around to the same element, coefficient crosses threshold OR (should never come to this) coeff_index overflows, break loop
-        if (i == index || bessel_coeff[coeff_index] < BESSEL_MIN_THRESHOLD || coeff_index > SH_BUFFER_SIZE)
+        if (i == index || coeff[coeff_index] < BESSEL_MIN_THRESHOLD || coeff_index > SH_BUFFER_SIZE)
             break;
     }
     return val / coeff_sum;
-}
\ No newline at end of file
+}
+
+void bessel_fir_init(bessel_fir *f, const float coeff[])
+{
+    // same truncation as the loop in dfilterBessel(): the first tap is always used
+    int n = 1;
+    while (n < SH_BUFFER_SIZE && coeff[n] >= BESSEL_MIN_THRESHOLD)
+        n++;
+    double dsum = 0;
+    float fsum = 0;
+    for (int i = 0; i < n; i++)
+    {
+        dsum += coeff[i];
+        fsum += coeff[i];
+    }
+    memset(f, 0, sizeof(bessel_fir));
+    f->ntaps = n;
+    for (int i = 0; i < n; i++) // reverse, so that the taps run in the order of the history
+    {
+        f->dtaps[n - 1 - i] = coeff[i] / dsum;
+        f->ftaps[n - 1 - i] = coeff[i] / fsum;
+    }
+}
+
+void bessel_dfilter3(const bessel_fir *f, bessel_dhist *h, int index, double *x, double *y, double *z)
+{
+    int n = f->ntaps;
+    h->x[index] = h->x[index + SH_BUFFER_SIZE] = *x; // new sample is part of the window
+    h->y[index] = h->y[index + SH_BUFFER_SIZE] = *y;
+    h->z[index] = h->z[index + SH_BUFFER_SIZE] = *z;
+    int start = index + SH_BUFFER_SIZE - n + 1; // window ends at the newest sample
+    const double *t = f->dtaps, *hx = h->x + start, *hy = h->y + start, *hz = h->z + start;
+    bessel_vd ax = {0}, ay = {0}, az = {0};
+    int i = 0;
+    for (; i + BESSEL_DLANES <= n; i += BESSEL_DLANES)
+    {
+        bessel_vd vt, vx, vy, vz;
+        memcpy(&vt, t + i, sizeof(bessel_vd)); // unaligned loads
+        memcpy(&vx, hx + i, sizeof(bessel_vd));
+        memcpy(&vy, hy + i, sizeof(bessel_vd));
+        memcpy(&vz, hz + i, sizeof(bessel_vd));
+        ax += vt * vx;
+        ay += vt * vy;
+        az += vt * vz;
+    }
+    double sx = 0, sy = 0, sz = 0;
+    for (int j = 0; j < BESSEL_DLANES; j++)
+    {
+        sx += ax[j];
+        sy += ay[j];
+        sz += az[j];
+    }
+    for (; i < n; i++) // remaining taps
+    {
+        sx += t[i] * hx[i];
+        sy += t[i] * hy[i];
+        sz += t[i] * hz[i];
+    }
+    h->x[index] = h->x[index + SH_BUFFER_SIZE] = *x = sx; // filtered value is part of the history
+    h->y[index] = h->y[index + SH_BUFFER_SIZE] = *y = sy;
+    h->z[index] = h->z[index + SH_BUFFER_SIZE] = *z = sz;
+}
+
+void bessel_ffilter3(const bessel_fir *f, bessel_fhist *h, int index, float *x, float *y, float *z)
+{
+    int n = f->ntaps;
+    h->x[index] = h->x[index + SH_BUFFER_SIZE] = *x;
+    h->y[index] = h->y[index + SH_BUFFER_SIZE] = *y;
+    h->z[index] = h->z[index + SH_BUFFER_SIZE] = *z;
+    int start = index + SH_BUFFER_SIZE - n + 1;
+    const float *t = f->ftaps, *hx = h->x + start, *hy = h->y + start, *hz = h->z + start;
+    bessel_vf ax = {0}, ay = {0}, az = {0};
+    int i = 0;
+    for (; i + BESSEL_FLANES <= n; i += BESSEL_FLANES)
+    {
+        bessel_vf vt, vx, vy, vz;
+        memcpy(&vt, t + i, sizeof(bessel_vf));
+        memcpy(&vx, hx + i, sizeof(bessel_vf));
+        memcpy(&vy, hy + i, sizeof(bessel_vf));
+        memcpy(&vz, hz + i, sizeof(bessel_vf));
+        ax += vt * vx;
+        ay += vt * vy;
+        az += vt * vz;
+    }
+    float sx = 0, sy = 0, sz = 0;
+    for (int j = 0; j < BESSEL_FLANES; j++)
+    {
+        sx += ax[j];
+        sy += ay[j];
+        sz += az[j];
+    }
+    for (; i < n; i++)
+    {
+        sx += t[i] * hx[i];
+        sy += t[i] * hy[i];
+        sz += t[i] * hz[i];
+    }
+    h->x[index] = h->x[index + SH_BUFFER_SIZE] = *x = sx;
+    h->y[index] = h->y[index + SH_BUFFER_SIZE] = *y = sy;
+    h->z[index] = h->z[index + SH_BUFFER_SIZE] = *z = sz;
+}
+
+/**
+ * @brief Evaluates the polynomial with coefficients a[0] ... a[order] (a[k] for s^k) at s.
+ * 
+ */
+static inline double complex polyval(const double a[], int order, double complex s)
+{
+    double complex val = a[order];
+    for (int k = order - 1; k >= 0; k--)
+        val = val * s + a[k];
+    return val;
+}
+
+/**
+ * @brief Finds the poles of the analog Bessel filter of the given order, normalized for -3 dB at 1 rad/s.
+ * 
+ * The poles are the roots of the reverse Bessel polynomial, found with the Durand-Kerner iteration.
+ * The -3 dB frequency of the polynomial is then found by bisection, and the poles scaled by it.
+ * 
+ * @param order Order of the filter, 1 ... BESSEL_IIR_MAX_ORDER
+ * @param p Stores the order poles
+ */
+static void bessel_poles(int order, double complex p[])
+{
+    double a[BESSEL_IIR_MAX_ORDER + 1]; // https://en.wikipedia.org/wiki/Bessel_polynomials, monic
+    a[order] = 1;
+    for (int k = order - 1; k >= 0; k--) // a[k] = (2n - k)! / (2^(n - k) k! (n - k)!)
+        a[k] = a[k + 1] * (2.0 * order - k) * (k + 1) / (2.0 * (order - k));
+    for (int i = 0; i < order; i++)
+        p[i] = cpow(0.4 + 0.9 * I, i); // customary starting points, not on a symmetry line
+    for (int iter = 0; iter < 500; iter++)
+    {
+        double step = 0;
+        for (int i = 0; i < order; i++)
+        {
+            double complex den = 1;
+            for (int j = 0; j < order; j++)
+                if (j != i)
+                    den *= p[i] - p[j];
+            double complex d = polyval(a, order, p[i]) / den;
+            p[i] -= d;
+            if (cabs(d) > step)
+                step = cabs(d);
+        }
+        if (step < 1e-14)
+            break;
+    }
+    // |H(jw)| = a[0] / |theta(jw)| falls monotonically, -3 dB between 0 and order + 2 rad/s
+    double lo = 0, hi = order + 2;
+    for (int iter = 0; iter < 100; iter++)
+    {
+        double w = 0.5 * (lo + hi);
+        double mag = a[0] / cabs(polyval(a, order, w * I));
+        if (mag > M_SQRT1_2)
+            lo = w;
+        else
+            hi = w;
+    }
+    for (int i = 0; i < order; i++)
+        p[i] /= 0.5 * (lo + hi);
+}
+
+int bessel_iir_init(bessel_iir *f, int order, float freq_cutoff)
+{
+    memset(f, 0, sizeof(bessel_iir)); // no sections: pass through
+    if (order < 0 || order > BESSEL_IIR_MAX_ORDER || !(freq_cutoff > 0))
+        return -1;
+    if (order == 0)
+        return 1;
+    if (freq_cutoff < 2.05f) // Nyquist is a period of 2 samples
+        freq_cutoff = 2.05f;
+    double complex p[BESSEL_IIR_MAX_ORDER];
+    bessel_poles(order, p);
+    double wa = 2 * tan(M_PI / freq_cutoff); // prewarped analog cutoff, in units of the sampling time
+    for (int i = 0; i < order && f->nsec < BESSEL_IIR_SECTIONS; i++)
+    {
+        if (cimag(p[i]) < -1e-9) // conjugate pole is part of the same section
+            continue;
+        double complex zp = (2 + wa * p[i]) / (2 - wa * p[i]); // bilinear transform, s = 2 (z - 1) / (z + 1)
+        double *b = f->db[f->nsec], *a = f->da[f->nsec];
+        if (cimag(p[i]) <= 1e-9) // real pole: zero at z = -1
+        {
+            a[0] = -creal(zp);
+            a[1] = 0;
+            b[0] = b[1] = (1 + a[0]) / 2; // unity gain at z = 1
+            b[2] = 0;
+        }
+        else // complex pair: double zero at z = -1
+        {
+            a[0] = -2 * creal(zp);
+            a[1] = creal(zp) * creal(zp) + cimag(zp) * cimag(zp);
+            b[0] = b[2] = (1 + a[0] + a[1]) / 4;
+            b[1] = 2 * b[0];
+        }
+        f->nsec++;
+    }
+    for (int i = 0; i < f->nsec; i++)
+    {
+        for (int j = 0; j < 3; j++)
+            f->fb[i][j] = f->db[i][j];
+        for (int j = 0; j < 2; j++)
+            f->fa[i][j] = f->da[i][j];
+    }
+    return 1;
+}
+
+/**
+ * @brief Filters one sample through a double precision section, transposed direct form II.
+ * 
+ */
+static inline double dbiquad(const double b[3], const double a[2], double st[2], double in)
+{
+    double out = b[0] * in + st[0];
+    st[0] = b[1] * in - a[0] * out + st[1];
+    st[1] = b[2] * in - a[1] * out;
+    return out;
+}
+
+/**
+ * @brief Filters one sample through a single precision section, transposed direct form II.
+ * 
+ */
+static inline float fbiquad(const float b[3], const float a[2], float st[2], float in)
+{
+    float out = b[0] * in + st[0];
+    st[0] = b[1] * in - a[0] * out + st[1];
+    st[1] = b[2] * in - a[1] * out;
+    return out;
+}
+
+void bessel_diir3(const bessel_iir *f, bessel_diir *s, double *x, double *y, double *z)
+{
+    double vx = *x, vy = *y, vz = *z;
+    for (int i = 0; i < f->nsec; i++) // the three axes are independent chains
+    {
+        vx = dbiquad(f->db[i], f->da[i], s->x[i], vx);
+        vy = dbiquad(f->db[i], f->da[i], s->y[i], vy);
+        vz = dbiquad(f->db[i], f->da[i], s->z[i], vz);
+    }
+    *x = vx;
+    *y = vy;
+    *z = vz;
+}
+
+void bessel_fiir3(const bessel_iir *f, bessel_fiir *s, float *x, float *y, float *z)
+{
+    float vx = *x, vy = *y, vz = *z;
+    for (int i = 0; i < f->nsec; i++)
+    {
+        vx = fbiquad(f->fb[i], f->fa[i], s->x[i], vx);
+        vy = fbiquad(f->fb[i], f->fa[i], s->y[i], vy);
+        vz = fbiquad(f->fb[i], f->fa[i], s->z[i], vz);
+    }
+    *x = vx;
+    *y = vy;
+    *z = vz;
+}
@@ -15,9 +15,36 @@ void *eps_telem(void *id)
     return NULL;
 }
 
+/*
+ * Sends a command once the whole exchange, with a reply of insize bytes, fits before the
+ * next ACS quiet window. EPS traffic is housekeeping from whichever thread it is sent, and
+ * yields to the sensors and the ACS. The bus is released while the EPS prepares the reply.
+ */
+static int p31u_command(p31u *dev, const void *out, size_t outsize, size_t insize)
+{
+    if (i2c_bus_acquire_prio(dev->bus, EPS_EXCHANGE_TIME(outsize, insize), I2C_PRIO_HOUSEKEEPING) < 0)
+        return -1;
+    int status = i2c_bus_send(dev->bus, dev->addr, out, outsize);
+    i2c_bus_release(dev->bus);
+    return status;
+}
+
+/*
+ * Waits for the EPS to prepare the reply to the command sent with p31u_command(), and
+ * reads it once the read fits before the next ACS quiet window.
+ */
+static int p31u_reply(p31u *dev, void *in, size_t insize)
+{
+    usleep(EPS_REPLY_TIME); // max 10 ms for reply ready: command and reply can not be one combined transaction
+    if (i2c_bus_acquire_prio(dev->bus, EPS_XFER_TIME(insize), I2C_PRIO_HOUSEKEEPING) < 0)
+        return -1;
+    int status = i2c_bus_recv(dev->bus, dev->addr, in, insize);
+    i2c_bus_release(dev->bus);
+    return status;
+}
+
 int p31u_init(p31u *dev)
 {
-    int status;
     dev = NULL;
     dev = (p31u *)malloc(sizeof(p31u));
     if (dev == NULL)
@@ -27,34 +54,27 @@ int p31u_init(p31u *dev)
         return -1;
     }
     snprintf(dev->fname, 39, EPS_I2C_BUS); // store bus name to struct
-    dev->file = open(dev->fname, O_RDWR);  // open file descriptor
-    if (dev->file < 0)
+    dev->bus = i2c_bus_open(dev->fname);   // shared bus handle
+    if (dev->bus == NULL)
     {
         perror("EPS"
                "Error opening I2C bus!");
-        return dev->file;
+        return -1;
     }
     dev->addr = EPS_I2C_ADDR;
-
-    if ((status = ioctl(dev->file, I2C_SLAVE, dev->addr)) < 0)
-    {
-        perror("EPS"
-               "Error setting IOCTL for I2C_SLAVE at address");
-        return status;
-    }
     return 1;
 }
 
 void p31u_destroy(p31u *dev)
 {
-    close(dev->file);
+    i2c_bus_close(dev->bus);
     free(dev);
 }
 
 int p31u_xfer(p31u *dev, char *out, ssize_t outsize, char *in, ssize_t insize)
 {
     int status;
-    if ((status = write(dev->file, out, outsize)) != outsize)
+    if ((status = p31u_command(dev, out, outsize, insize > 0 ? insize : 0)) < 0)
     {
         perror("EPS"
                "I2C Write failed!");
@@ -62,8 +82,7 @@ int p31u_xfer(p31u *dev, char *out, ssize_t outsize, char *in, ssize_t insize)
     }
     if (insize < 1) // no reply expected
         return EPS_COMMAND_SUCCESS;
-    usleep(10000); // 10 ms sleep, max 10 ms for reply ready
-    if ((status = read(dev->file, in, insize)) != insize)
+    if ((status = p31u_reply(dev, in, insize)) < 0)
     {
         perror("EPS"
                "I2C Read failed!");
@@ -105,7 +124,7 @@ int eps_reboot(p31u *dev)
     buf[3] = 0x80;
     buf[4] = 0x07;
 
-    if ((write(dev->file, buf, 5)) != 5)
+    if (p31u_command(dev, buf, 5, 0) < 0)
     {
         perror("EPS"
                "I2C Write Failed in REBOOT");
@@ -152,7 +171,7 @@ int eps_get_hk(p31u *dev, uint8_t mode)
         readsize = 2 + sizeof(eps_hk_t);
         break;
     }
-    if (write(dev->file, outbuf, 2) != 2)
+    if (p31u_command(dev, outbuf, 2, readsize) < 0)
     {
         perror("EPS"
                "GET_HK Command failed!");
@@ -161,8 +180,7 @@ int eps_get_hk(p31u *dev, uint8_t mode)
     }
     else
     {
-        usleep(10000); // wait for 10 ms for answer to be generated
-        if (read(dev->file, inbuf, readsize) != readsize)
+        if (p31u_reply(dev, inbuf, readsize) < 0)
         {
             perror("EPS"
                    "GET_HK read failed!");
@@ -214,7 +232,7 @@ int eps_hk(p31u *dev)
     outbuf[0] = GET_HK;
     unsigned long readsize = 2 + sizeof(hkparam_t);
     inbuf = (uint8_t *)malloc(readsize);
-    if (write(dev->file, outbuf, 1) != 1)
+    if (p31u_command(dev, outbuf, 1, readsize) < 0)
     {
         perror("EPS"
                "GET_HK Command failed!");
@@ -223,8 +241,7 @@ int eps_hk(p31u *dev)
     }
     else
     {
-        usleep(10000); // wait for 10 ms for answer to be generated
-        if (read(dev->file, inbuf, readsize) != readsize)
+        if (p31u_reply(dev, inbuf, readsize) < 0)
         {
             perror("EPS"
                    "GET_HK read failed!");
@@ -255,14 +272,13 @@ int eps_set_output(p31u *dev, channel_t channels)
     char buf[2];
     buf[0] = SET_OUTPUT;
     buf[1] = channels.reg;
-    if ((status = write(dev->file, buf, 2)) != 2)
+    if ((status = p31u_command(dev, buf, 2, 2)) < 0)
     {
         perror("EPS"
                "I2C Write Failed in SET_OUTPUT");
         return status;
     }
-    usleep(10000); // 10 ms
-    if ((status = read(dev->file, buf, 2)) != 2)
+    if ((status = p31u_reply(dev, buf, 2)) < 0)
     {
         perror("EPS"
                "I2C Read Failed in SET_OUTPUT");
@@ -287,14 +303,13 @@ int eps_set_single(p31u *dev, uint8_t channel, uint8_t value, int16_t delay)
     buf[2] = value;
     buf[3] = ((uint8_t *)&delay)[1];
     buf[4] = ((uint8_t *)&delay)[0];
-    if ((status = write(dev->file, buf, 5)) != 5)
+    if ((status = p31u_command(dev, buf, 5, 2)) < 0)
     {
         perror("EPS"
                "I2C Write Failed in SET_SINGLE_OUTPUT");
         return status;
     }
-    usleep(10000); // 10 ms
-    if ((status = read(dev->file, buf, 2)) != 2)
+    if ((status = p31u_reply(dev, buf, 2)) < 0)
     {
         perror("EPS"
                "I2C Read Failed in SET_SINGLE_OUTPUT");
@@ -316,7 +331,7 @@ int eps_reset_wdt(p31u *dev)
     char buf[2];
     buf[0] = RESET_WDT;
     buf[1] = 0x78; // magic
-    if ((status = write(dev->file, buf, 2)) != 2)
+    if ((status = p31u_command(dev, buf, 2, 0)) < 0)
     {
         perror("EPS"
                "I2C Write Failed in RESET_WDT");
@@ -8,20 +8,84 @@
  * @copyright Copyright (c) 2020
  * 
  */
+#define _GNU_SOURCE  // CPU affinity of the module threads
 #define MAIN_PRIVATE // enable prototypes in main.h and modules in modules.h
 #include <main.h>
 #include <modules.h>
+#include <sh_time.h>
 #undef MAIN_PRIVATE
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <pthread.h>
 #include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 int sys_boot_count = -1;
 volatile sig_atomic_t done = 0;
 __thread int sys_status;
 
+/**
+ * @brief Prepares the attributes of a module thread from its real-time profile.
+ *
+ * @param attr Attribute to initialize, has to be destroyed by the caller
+ * @param rt Real-time profile of the module
+ * @param avail CPUs available to the program
+ * @param sched Apply the scheduling policy and priority of the profile, 0 to inherit them
+ */
+static void module_attr(pthread_attr_t *attr, const module_rt *rt, const cpu_set_t *avail, int sched)
+{
+    pthread_attr_init(attr);                                    // initialize attribute
+    pthread_attr_setdetachstate(attr, PTHREAD_CREATE_JOINABLE); // create threads to be joinable
+    if (rt->stack)
+        pthread_attr_setstacksize(attr, rt->stack);
+    cpu_set_t cpus; // CPUs of the profile that exist on this system
+    CPU_ZERO(&cpus);
+    for (int c = 0; c < (int)(8 * sizeof(rt->cpus)) && c < CPU_SETSIZE; c++)
+        if ((rt->cpus & (1UL << c)) && CPU_ISSET(c, avail))
+            CPU_SET(c, &cpus);
+    if (CPU_COUNT(&cpus)) // else run anywhere
+        pthread_attr_setaffinity_np(attr, sizeof(cpu_set_t), &cpus);
+    if (sched && rt->policy != SCHED_OTHER)
+    {
+        struct sched_param param;
+        param.sched_priority = rt->priority;
+        pthread_attr_setinheritsched(attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(attr, rt->policy);
+        pthread_attr_setschedparam(attr, &param);
+    }
+}
+
+/**
+ * @brief Touches the given amount of stack so that the pages are mapped (and locked)
+ * before the module starts.
+ *
+ * @param size Number of bytes to touch
+ */
+static void __attribute__((noinline)) prefault_stack(size_t size)
+{
+    unsigned char buf[size];
+    memset(buf, 0, size);
+    __asm__ __volatile__("" : : "r"(buf) : "memory"); // keep the compiler from dropping the writes
+}
+
+/**
+ * @brief Entry point of every module thread: prefaults half of the stack and runs the
+ * module registered in module_exec[].
+ *
+ * @param id Pointer to the index of the module
+ * @return void* Return value of the module
+ */
+static void *module_start(void *id)
+{
+    int i = *(int *)id;
+    size_t stack = module_profile[i].stack ? module_profile[i].stack : MODULE_STACK_SIZE;
+    prefault_stack(stack / 2);
+    return ((void *(*)(void *))module_exec[i])(id);
+}
+
 /**
  * @brief Main function executed when shflight.out binary is executed
  * 
@@ -51,27 +115,45 @@ int main(void)
         }
     }
     printf("Done init modules\n");
+    sh_time_init(); // calibrate the time source before the modules read it
+    printf("Time source: %s\n", sh_time_source());
+    // lock all current and future memory (including thread stacks) to avoid page faults
+    int mlock_err = mlockall(MCL_CURRENT | MCL_FUTURE) ? errno : 0;
+    if (mlock_err)
+        fprintf(stderr, "[Main] Warning: Could not lock memory (%s)\n", strerror(mlock_err));
     // set up threads
     int rc[num_systems];                                         // fork-join return codes
     pthread_t thread[num_systems];                               // thread containers
     pthread_attr_t attr;                                         // thread attribute
     int args[num_systems];                                       // thread arguments (thread id in this case, but can be expanded by passing structs etc)
     void *status;                                                // thread return value
-    pthread_attr_init(&attr);                                    // initialize attribute
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE); // create threads to be joinable
+    int rt_failed = 0;                                           // number of threads running without their real-time profile
+    cpu_set_t avail;                                             // CPUs available to the program
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &avail))
+        CPU_ZERO(&avail);
 
     for (int i = 0; i < num_systems; i++)
     {
         args[i] = i; // sending a pointer to i to every thread may end up with duplicate thread ids because of access times
-        rc[i] = pthread_create(&thread[i], &attr, module_exec[i], (void *)(&args[i]));
-        if (rc[i])
+        module_attr(&attr, &module_profile[i], &avail, 1);
+        rc[i] = pthread_create(&thread[i], &attr, module_start, (void *)(&args[i]));
+        pthread_attr_destroy(&attr);
+        if (rc[i] == EPERM) // no real-time privileges, retry without the scheduling parameters
         {
-            printf("[Main] Error: Unable to create thread %d: Errno %d\n", i, errno);
+            module_attr(&attr, &module_profile[i], &avail, 0);
+            rc[i] = pthread_create(&thread[i], &attr, module_start, (void *)(&args[i]));
+            pthread_attr_destroy(&attr);
+            if (rc[i] == 0) // running, without its real-time profile
+                rt_failed++;
+        }
+        if (rc[i]) // bad attribute, or the retry failed too: the thread is not started
+        {
+            printf("[Main] Error: Unable to create thread %d: Errno %d\n", i, rc[i]);
             exit(-1);
         }
     }
-
-    pthread_attr_destroy(&attr); // destroy the attribute
+    if (rt_failed)
+        fprintf(stderr, "[Main] Warning: Real-time scheduling not obtained for %d of %d threads, run as root or with CAP_SYS_NICE for bounded ACS latency\n", rt_failed, num_systems);
 
     for (int i = 0; i < num_systems; i++)
     {
@@ -0,0 +1,245 @@
+/**
+ * @file sh_time.c
+ * @author Sunip K. Mukherjee (sunipkmukherjee@gmail.com)
+ * @brief Time source of the flight software.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+#include <sh_time.h>
+#include <time.h>
+
+/**
+ * @brief Reads CLOCK_MONOTONIC, through the vDSO on Linux.
+ *
+ */
+static inline uint64_t mono_nsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+#if defined(SH_TIME_CYCLES) && (defined(__aarch64__) || defined(__x86_64__))
+#define SH_TIME_HAS_CYCLES
+#ifdef __x86_64__
+#include <cpuid.h>
+#endif
+
+/**
+ * @brief Reads the cycle counter: the virtual counter of the generic timer on aarch64, the
+ * time stamp counter on x86-64.
+ *
+ */
+static inline uint64_t read_cycles(void)
+{
+#ifdef __aarch64__
+    uint64_t v;
+    __asm__ volatile("isb\n\tmrs %0, cntvct_el0"
+                     : "=r"(v)
+                     :
+                     : "memory");
+    return v;
+#else
+    uint32_t lo, hi;
+    __asm__ volatile("lfence\n\trdtsc"
+                     : "=a"(lo), "=d"(hi)
+                     :
+                     : "memory");
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+/**
+ * @brief Checks that the counter runs at a constant rate: CNTFRQ is set on aarch64, the TSC
+ * is invariant on x86-64.
+ *
+ */
+static int cycles_usable(void)
+{
+#ifdef __aarch64__
+    uint64_t frq;
+    __asm__ volatile("mrs %0, cntfrq_el0"
+                     : "=r"(frq));
+    return frq != 0;
+#else
+    unsigned int a, b, c, d;
+    if (!__get_cpuid(0x80000007, &a, &b, &c, &d))
+        return 0;
+    return (d >> 8) & 1; // invariant TSC
+#endif
+}
+
+/**
+ * @brief Point where the counter was matched against CLOCK_MONOTONIC. Times are extrapolated
+ * from the last anchor, in 32.32 fixed point nsec per count.
+ *
+ */
+typedef struct
+{
+    uint64_t cnt;    ///< Counter at the anchor
+    uint64_t ref;    ///< CLOCK_MONOTONIC at the anchor, in nsec
+    uint64_t ns;     ///< Time reported at the anchor, never behind the time reported before it, in nsec
+    uint64_t rate;   ///< Measured nsec per count, 32.32 fixed point
+    uint64_t mult;   ///< Nsec per count reported until the next anchor, slews ns back onto ref
+    uint64_t period; ///< Counts until the next anchor
+} time_anchor;
+
+static time_anchor anchor;                  // written under seq, by one thread at a time
+static uint32_t anchor_seq;                 // odd while the anchor is written
+static int cycles_active;                   // cycle counter calibrated
+static const char *source_name = "clock_monotonic";
+
+/**
+ * @brief Reads the counter and CLOCK_MONOTONIC at the same instant, within the time it
+ * takes to read CLOCK_MONOTONIC.
+ *
+ */
+static inline void sample(uint64_t *cnt, uint64_t *ref)
+{
+    uint64_t c0 = read_cycles();
+    *ref = mono_nsec();
+    uint64_t c1 = read_cycles();
+    *cnt = c0 + (c1 - c0) / 2;
+}
+
+static inline uint64_t extrapolate(const time_anchor *a, uint64_t cnt)
+{
+    return a->ns + (uint64_t)(((unsigned __int128)(cnt - a->cnt) * a->mult) >> 32);
+}
+
+static void anchor_load(time_anchor *a)
+{
+    uint32_t s;
+    do
+    {
+        s = __atomic_load_n(&anchor_seq, __ATOMIC_ACQUIRE);
+        a->cnt = __atomic_load_n(&anchor.cnt, __ATOMIC_RELAXED);
+        a->ref = __atomic_load_n(&anchor.ref, __ATOMIC_RELAXED);
+        a->ns = __atomic_load_n(&anchor.ns, __ATOMIC_RELAXED);
+        a->rate = __atomic_load_n(&anchor.rate, __ATOMIC_RELAXED);
+        a->mult = __atomic_load_n(&anchor.mult, __ATOMIC_RELAXED);
+        a->period = __atomic_load_n(&anchor.period, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((s & 1) || s != __atomic_load_n(&anchor_seq, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief Publishes a new anchor. Returns 0 if another thread is publishing one.
+ *
+ */
+static int anchor_store(const time_anchor *a)
+{
+    uint32_t s = __atomic_load_n(&anchor_seq, __ATOMIC_RELAXED);
+    if ((s & 1) || !__atomic_compare_exchange_n(&anchor_seq, &s, s + 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return 0;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&anchor.cnt, a->cnt, __ATOMIC_RELAXED);
+    __atomic_store_n(&anchor.ref, a->ref, __ATOMIC_RELAXED);
+    __atomic_store_n(&anchor.ns, a->ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&anchor.rate, a->rate, __ATOMIC_RELAXED);
+    __atomic_store_n(&anchor.mult, a->mult, __ATOMIC_RELAXED);
+    __atomic_store_n(&anchor.period, a->period, __ATOMIC_RELAXED);
+    __atomic_store_n(&anchor_seq, s + 2, __ATOMIC_RELEASE);
+    return 1;
+}
+
+/**
+ * @brief Matches the counter against CLOCK_MONOTONIC again: the rate is measured over the
+ * last interval, and the reported time is slewed, never stepped back, onto CLOCK_MONOTONIC
+ * over the next interval, twice as long as the last one up to SH_TIME_RESYNC.
+ *
+ */
+static uint64_t resync(const time_anchor *a)
+{
+    time_anchor n;
+    sample(&n.cnt, &n.ref);
+    if (n.cnt <= a->cnt || n.ref <= a->ref)
+        return extrapolate(a, a->cnt + a->period);
+    n.rate = (uint64_t)(((unsigned __int128)(n.ref - a->ref) << 32) / (n.cnt - a->cnt));
+    uint64_t interval = 2 * (n.ref - a->ref); // short intervals after the calibration, doubling up to SH_TIME_RESYNC
+    if (interval > SH_TIME_RESYNC)
+        interval = SH_TIME_RESYNC;
+    n.period = (uint64_t)(((unsigned __int128)interval << 32) / n.rate);
+    uint64_t pred = extrapolate(a, n.cnt);
+    n.ns = pred > n.ref ? pred : n.ref;
+    uint64_t slew = (uint64_t)(((unsigned __int128)(n.ns - n.ref) << 32) / n.period);
+    n.mult = slew < n.rate / 2 ? n.rate - slew : n.rate / 2; // at most half speed while catching up
+    anchor_store(&n);
+    return n.ns;
+}
+#endif // SH_TIME_CYCLES
+
+int sh_time_init(void)
+{
+#ifdef SH_TIME_HAS_CYCLES
+    if (!cycles_usable())
+        return 0;
+    time_anchor a;
+    uint64_t cnt, ref;
+    sample(&cnt, &ref);
+    while (mono_nsec() - ref < SH_TIME_CALIBRATE) // spin, a sleeping CPU may stop the counter of a virtual machine
+        ;
+    sample(&a.cnt, &a.ref);
+    if (a.cnt <= cnt || a.ref <= ref)
+        return 0;
+    a.rate = (uint64_t)(((unsigned __int128)(a.ref - ref) << 32) / (a.cnt - cnt));
+    a.mult = a.rate;
+    a.period = (uint64_t)(((unsigned __int128)(2 * SH_TIME_CALIBRATE) << 32) / a.rate);
+    a.ns = a.ref;
+    if (!anchor_store(&a))
+        return 0;
+#ifdef __aarch64__
+    source_name = "cntvct";
+#else
+    source_name = "tsc";
+#endif
+    __atomic_store_n(&cycles_active, 1, __ATOMIC_RELEASE);
+    return 1;
+#else
+    return 0;
+#endif // SH_TIME_HAS_CYCLES
+}
+
+const char *sh_time_source(void)
+{
+#ifdef SH_TIME_HAS_CYCLES
+    if (__atomic_load_n(&cycles_active, __ATOMIC_ACQUIRE))
+        return source_name;
+#endif
+    return "clock_monotonic";
+}
+
+uint64_t sh_time_nsec(void)
+{
+#ifdef SH_TIME_HAS_CYCLES
+    if (__atomic_load_n(&cycles_active, __ATOMIC_ACQUIRE))
+    {
+        time_anchor a;
+        anchor_load(&a);
+        uint64_t d = read_cycles() - a.cnt;
+        if ((int64_t)d < 0) // counter read on a core slightly behind the one that anchored
+            return a.ns;
+        if (d >= a.period)
+            return resync(&a);
+        return a.ns + (uint64_t)(((unsigned __int128)d * a.mult) >> 32);
+    }
+#endif
+    return mono_nsec();
+}
+
+uint64_t sh_time_usec(void)
+{
+    return sh_time_nsec() / 1000;
+}
+
+uint64_t sh_time_utc(uint64_t usec)
+{
+    struct timespec rt, mt;
+    clock_gettime(CLOCK_REALTIME, &rt);
+    clock_gettime(CLOCK_MONOTONIC, &mt);
+    int64_t offset = ((int64_t)rt.tv_sec - mt.tv_sec) * 1000000 + (rt.tv_nsec - mt.tv_nsec) / 1000;
+    return usec + offset;
+}
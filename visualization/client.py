@@ -45,7 +45,10 @@ class packet_data(c.Structure):
         ('z_W', c.c_float),
         ('x_S', c.c_float),
         ('y_S', c.c_float),
-        ('z_S', c.c_float)
+        ('z_S', c.c_float),
+        ('lat_p50', c.c_float * 7),  # ACS phase latencies in usec: sense, estimate,
+        ('lat_p99', c.c_float * 7),  # transition, command, actuate, switch, period
+        ('lat_max', c.c_float * 7)
     ]
 
 